@@ -0,0 +1,102 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_ARCHIVE_H_
+#define VOODOO_ARCHIVE_H_
+
+#include "file_system.h"
+
+namespace voodoo {
+// Packed asset archive layout. The header is followed by the entry table
+// sorted by name hash, the chunk table, the name blob and the data. Every
+// entry is split into chunks that are compressed independently, so large
+// files decompress in parallel. Chunks whose compressed size equals their
+// size are stored, and entries made of stored chunks only are used
+// straight from the mapping.
+struct ArchiveHeader {
+  uint magic;
+  uint version;
+  uint entry_count;
+  uint chunk_count;
+  uint chunk_size;
+  uint reserved;
+
+  ullong entry_offset;
+  ullong chunk_offset;
+  ullong name_offset;
+  ullong name_size;
+  ullong file_size;
+};
+
+struct ArchiveEntry {
+  ullong hash;
+  ullong size;
+  uint name_offset;
+  uint name_size;
+  uint first_chunk;
+  uint chunk_count;
+};
+
+struct ArchiveChunk {
+  ullong offset;
+  uint size;
+  uint compressed_size;
+};
+
+struct ArchiveSource {
+  // Relative path inside the archive, e.g. "meshes/cube.mesh"
+  string name;
+  string path;
+  bool compress;
+};
+
+struct ArchiveStats {
+  uint entry_count;
+  ullong source_size, archive_size;
+};
+
+class Archive final {
+ public:
+  static constexpr uint kMagic = 0x4b415056;  // "VPAK"
+  static constexpr uint kVersion = 1;
+  static constexpr uint kAlignment = 16;
+  static constexpr uint kChunkSize = 64 * 1024;
+
+  // Maps and validates the archive, throws when it is unusable
+  explicit Archive(const string& filename);
+
+  // Null when there is no entry with that name
+  const ArchiveEntry* Find(const string& name) const;
+  string GetName(const ArchiveEntry& entry) const;
+  const vector<ArchiveEntry>& GetEntries() const;
+
+  // Throws when a chunk fails to decompress
+  sptr<FileData> Read(const ArchiveEntry& entry) const;
+
+  static bool Write(const string& filename,
+                    const vector<ArchiveSource>& sources,
+                    ArchiveStats* stats = nullptr);
+
+ private:
+  string filename_;
+  sptr<MappedFile> mapping_;
+  vector<ArchiveEntry> entries_;
+  const ArchiveChunk* chunks_;
+  const char* names_;
+  uint chunk_size_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_ARCHIVE_H_
@@ -16,39 +16,366 @@
 #ifndef VOODOO_ASSET_MANAGER_H_
 #define VOODOO_ASSET_MANAGER_H_
 
+#include "io_queue.h"
+#include "name_id.h"
 #include "std_mappings.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
 
 namespace voodoo {
+// Shared state of an asset that may still be loading. get() blocks until
+// the load completes and rethrows its exception on failure. The cache
+// doesn't evict an asset while any of its futures is held, so that a
+// caller which has not taken the value yet doesn't lose it.
+template <class T>
+class AssetFuture {
+ public:
+  AssetFuture() = default;
+  AssetFuture(std::shared_future<sptr<T>> future, sptr<void> handle)
+      : future_(std::move(future)), handle_(std::move(handle)) {}
+
+  const sptr<T>& get() const { return future_.get(); }
+  bool valid() const { return future_.valid(); }
+  void wait() const { future_.wait(); }
+
+  template <class Rep, class Period>
+  std::future_status wait_for(
+      const std::chrono::duration<Rep, Period>& timeout) const {
+    return future_.wait_for(timeout);
+  }
+
+ private:
+  std::shared_future<sptr<T>> future_;
+
+  // Shared by the futures of an entry, counted by IsEvictable()
+  sptr<void> handle_;
+};
+
+struct AssetCacheStats {
+  ullong hits, misses, evictions;
+  size_t resident_bytes, budget;
+};
+
+// Thread-safe asset cache. Lookups take a shared lock on one of several
+// shards, so concurrent retrieval of loaded assets rarely contends.
+// Requests for an asset that is already loading wait for that load
+// instead of starting another one. Load() may therefore run on any
+// thread, and the manager must outlive its asynchronous loads.
+// Asynchronous loads read the file on the I/O queue and decode it on the
+// thread pool.
+//
+// With a memory budget set, assets referenced only by the cache, with no
+// future of theirs held either, are evicted least recently used first
+// whenever a load exceeds the budget.
 template <class T>
 class AssetManager {
  public:
+  AssetManager() : budget_(0), resident_bytes_(0), tick_(0), hits_(0),
+                   misses_(0), evictions_(0) {}
+  virtual ~AssetManager() = default;
+
+  // Loads on the calling thread unless the asset is cached or in flight
   sptr<T> Retrieve(const string& filename) {
-    auto it = resources_.find(filename);
-    if (it != resources_.end()) {
-      return it->second;
-    } else {
-      auto resource = Load(filename);
-      resources_.insert(pair<string, sptr<T>>(filename, resource));
-      return resource;
+    sptr<std::promise<sptr<T>>> promise;
+    auto future = Find(filename, promise);
+    if (promise) Fulfil(filename, *promise);
+
+    return future.get();
+  }
+
+  // Loads in the background, the returned future becomes ready when the
+  // asset is
+  AssetFuture<T> RetrieveAsync(const string& filename,
+                               IoPriority priority = kIoPriorityNormal) {
+    sptr<std::promise<sptr<T>>> promise;
+    auto future = Find(filename, promise);
+    if (!promise) return future;
+
+    auto request = IoQueue::Get().Read(
+        filename, priority,
+        [this, filename, promise](sptr<FileData> file,
+                                  std::exception_ptr error) {
+          ThreadPool::Get().Submit([this, filename, promise, file, error]() {
+            Fulfil(filename, *promise, file, error);
+          });
+        });
+
+    NameId id(filename);
+    Shard& shard = GetShard(id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.resources.find(id);
+    if (it != shard.resources.end() && it->second.size == 0)
+      it->second.request = request;
+
+    return future;
+  }
+
+  // Abandons an asynchronous load whose file has not been read yet. Its
+  // future then holds an error. False when the load is past that point.
+  bool Cancel(const string& filename) {
+    IoRequest request;
+    {
+      NameId id(filename);
+      Shard& shard = GetShard(id);
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      auto it = shard.resources.find(id);
+      if (it == shard.resources.end() || it->second.size != 0) return false;
+      request = it->second.request;
     }
+
+    return request.Cancel();
+  }
+
+  // Zero budget keeps every asset resident
+  void SetBudget(size_t bytes) {
+    budget_ = bytes;
+    Trim();
+  }
+
+  // Evicts unreferenced assets until the resident size fits the budget
+  void Trim() {
+    std::unique_lock<std::mutex> trim_lock(trim_mutex_, std::try_to_lock);
+    if (!trim_lock || budget_ == 0 || resident_bytes_ <= budget_) return;
+
+    struct Candidate {
+      ullong last_use;
+      uint shard;
+      NameId id;
+    };
+
+    vector<Candidate> candidates;
+    for (uint i = 0; i < kShardCount; i++) {
+      std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+      for (const auto& resource : shards_[i].resources) {
+        if (IsEvictable(resource.second))
+          candidates.push_back({resource.second.last_use, i, resource.first});
+      }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) {
+                return a.last_use < b.last_use;
+              });
+
+    // Assets may have been retrieved since the scan, so every candidate
+    // is checked again under the exclusive lock
+    for (const auto& candidate : candidates) {
+      if (resident_bytes_ <= budget_) break;
+
+      Shard& shard = shards_[candidate.shard];
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      auto it = shard.resources.find(candidate.id);
+      if (it == shard.resources.end() || !IsEvictable(it->second)) continue;
+
+      resident_bytes_ -= it->second.size;
+      evictions_++;
+      shard.resources.erase(it);
+    }
+  }
+
+  // Loads a resident asset again on the calling thread, bypassing the
+  // cache. The cached object is returned as current so that the caller can
+  // move the fresh contents into it on the thread that uses the asset,
+  // which keeps every reference to it valid. Returns false when the asset
+  // is not resident and throws when loading fails.
+  bool Reload(const string& filename, sptr<T>& current, sptr<T>& fresh) {
+    NameId id(filename);
+    Shard& shard = GetShard(id);
+    {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      auto it = shard.resources.find(id);
+      if (it == shard.resources.end() || it->second.size == 0 ||
+          it->second.future.wait_for(std::chrono::seconds(0)) !=
+              std::future_status::ready) {
+        return false;
+      }
+      current = it->second.future.get();
+    }
+
+    fresh = Load(filename);
+
+    size_t size = std::max<size_t>(GetAssetSize(*fresh), 1);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.resources.find(id);
+    if (it != shard.resources.end() && it->second.size != 0) {
+      resident_bytes_ += size;
+      resident_bytes_ -= it->second.size;
+      it->second.size = size;
+    }
+
+    return true;
+  }
+
+  AssetCacheStats GetStats() const {
+    return {hits_, misses_, evictions_, resident_bytes_, budget_};
   }
 
  protected:
-  virtual sptr<T> Load(const string& filename) = 0;
+  // Builds the asset from the contents of the file
+  virtual sptr<T> Load(const string& filename, sptr<FileData> file) = 0;
+
+  // Memory accounted against the budget
+  virtual size_t GetAssetSize(const T& asset) const { return sizeof(T); }
 
   void Unload(const string& filename) {
     using namespace std;
-    auto it = resources_.find(filename);
-    if (it == resources_.end()) {
+    NameId id(filename);
+    Shard& shard = GetShard(id);
+    unique_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.resources.find(id);
+    if (it == shard.resources.end()) {
       throw runtime_error("Failed to load resource: \"" + filename + "\"");
     } else {
-      resources_.erase(it);
+      resident_bytes_ -= it->second.size;
+      shard.resources.erase(it);
     }
   }
 
- protected:
-  map<string, sptr<T>> resources_;
+ private:
+  static constexpr uint kShardCount = 16;
+
+  struct Entry {
+    Entry() = default;
+
+    // Entries move when their table grows or one is erased, both under
+    // the exclusive lock
+    Entry(Entry&& other) noexcept
+        : future(std::move(other.future)),
+          handle(std::move(other.handle)),
+          size(other.size),
+          request(std::move(other.request)),
+          last_use(other.last_use.load(std::memory_order_relaxed)) {}
+
+    Entry& operator=(Entry&& other) noexcept {
+      future = std::move(other.future);
+      handle = std::move(other.handle);
+      size = other.size;
+      request = std::move(other.request);
+      last_use.store(other.last_use.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+      return *this;
+    }
+
+    std::shared_future<sptr<T>> future;
+    sptr<void> handle;
+    size_t size = 0;
+
+    // Read of a load in flight
+    IoRequest request;
+
+    // Value of the manager tick at the last retrieval, written under the
+    // shared lock
+    std::atomic<ullong> last_use{0};
+  };
+
+  struct Shard {
+    std::shared_mutex mutex;
+    flat_hash_map<NameId, Entry> resources;
+  };
+
+  Shard& GetShard(NameId id) { return shards_[id.GetValue() % kShardCount]; }
+
+  // Loaded assets whose only owner is the cache and whose futures were
+  // all released
+  static bool IsEvictable(const Entry& entry) {
+    return entry.size != 0 && entry.handle.use_count() == 1 &&
+           entry.future.wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready &&
+           entry.future.get().use_count() == 1;
+  }
+
+  // Returns the cached or in-flight entry. Otherwise inserts a pending
+  // entry and hands its promise to the caller, who must fulfil it.
+  AssetFuture<T> Find(const string& filename,
+                      sptr<std::promise<sptr<T>>>& promise) {
+    NameId id(filename);
+    Shard& shard = GetShard(id);
+    {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      auto it = shard.resources.find(id);
+      if (it != shard.resources.end()) {
+        it->second.last_use.store(++tick_, std::memory_order_relaxed);
+        hits_++;
+        return AssetFuture<T>(it->second.future, it->second.handle);
+      }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.resources.find(id);
+    if (it != shard.resources.end()) {
+      it->second.last_use.store(++tick_, std::memory_order_relaxed);
+      hits_++;
+      return AssetFuture<T>(it->second.future, it->second.handle);
+    }
+
+    promise = std::make_shared<std::promise<sptr<T>>>();
+    Entry& entry = shard.resources[NameId::Intern(filename)];
+    entry.future = promise->get_future().share();
+    entry.handle = std::make_shared<byte>();
+    entry.last_use.store(++tick_, std::memory_order_relaxed);
+    misses_++;
+
+    return AssetFuture<T>(entry.future, entry.handle);
+  }
+
+  sptr<T> Load(const string& filename) {
+    return Load(filename, FileSystem::Read(filename));
+  }
+
+  // Reads the file unless it was read already
+  void Fulfil(const string& filename, std::promise<sptr<T>>& promise,
+              sptr<FileData> file = nullptr,
+              std::exception_ptr error = nullptr) {
+    NameId id(filename);
+    Shard& shard = GetShard(id);
+    sptr<T> asset;
+    try {
+      if (error) std::rethrow_exception(error);
+      asset = file ? Load(filename, file) : Load(filename);
+    } catch (...) {
+      // Failed loads are forgotten so that a later request retries
+      {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.resources.erase(id);
+      }
+      promise.set_exception(std::current_exception());
+      return;
+    }
+
+    // Sizes are at least one byte so that zero marks a pending entry
+    size_t size = std::max<size_t>(GetAssetSize(*asset), 1);
+    {
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      auto it = shard.resources.find(id);
+      if (it != shard.resources.end()) {
+        it->second.size = size;
+        it->second.request = IoRequest();
+        resident_bytes_ += size;
+      }
+    }
+
+    // The asset is still held here, so trimming never evicts the asset
+    // that was just loaded
+    promise.set_value(asset);
+    if (budget_ != 0 && resident_bytes_ > budget_) Trim();
+  }
+
+ private:
+  Shard shards_[kShardCount];
+
+  std::atomic<size_t> budget_;
+  std::atomic<size_t> resident_bytes_;
+  std::atomic<ullong> tick_;
+  std::atomic<ullong> hits_, misses_, evictions_;
+  std::mutex trim_mutex_;
 };
 }  // namespace voodoo
 
-#endif
\ No newline at end of file
+#endif
@@ -16,6 +16,7 @@
 #ifndef VOODOO_BEHAVIOR_H_
 #define VOODOO_BEHAVIOR_H_
 
+#include "behavior_stats.h"
 #include "component.h"
 
 namespace voodoo {
@@ -27,6 +28,11 @@ class Behavior : public Component {
  private:
   virtual void Start();
   virtual void Update();
+
+  BehaviorCounters& GetCounters();
+
+ private:
+  BehaviorCounters* counters_ = nullptr;
 };
 }  // namespace voodoo
 
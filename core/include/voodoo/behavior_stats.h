@@ -0,0 +1,90 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_BEHAVIOR_STATS_H_
+#define VOODOO_BEHAVIOR_STATS_H_
+
+#include "std_mappings.h"
+
+#include <deque>
+#include <typeindex>
+
+namespace voodoo {
+class Behavior;
+
+// Times of one Behavior type in milliseconds, since the last reset
+struct BehaviorTypeStats {
+  string type;
+
+  ullong start_calls;
+  float start_time, start_max;
+
+  ullong update_calls;
+  float update_time;
+
+  // Update() time of every object of the type in a frame
+  float frame_avg, frame_max;
+
+  // Longest single Update()
+  float call_max;
+};
+
+// Running totals of a type, kept by its behaviors
+struct BehaviorCounters {
+  string type;
+  ullong start_calls, start_time, start_max;
+  ullong update_calls, update_time, call_max;
+  ullong frame_time, frame_max;
+};
+
+// Attributes the time spent in Behavior::Start() and Update() to the
+// behavior's type. Behaviors run on the main thread, so do these counters.
+class BehaviorStats final {
+ public:
+  static BehaviorStats& Get();
+
+  static bool IsEnabled() { return enabled_; }
+  static void SetEnabled(bool enabled);
+
+  static ullong Now();
+
+  // Counters of the behavior's type, looked up once per behavior
+  BehaviorCounters& GetCounters(const Behavior& behavior);
+
+  // Closes the frame, called by the engine after the updates
+  void EndFrame();
+
+  void Reset();
+
+  // Most expensive types first by Update() time per frame
+  vector<BehaviorTypeStats> GetStats() const;
+
+  // Writes the stats to the log
+  void Dump() const;
+
+ private:
+  BehaviorStats();
+
+ private:
+  static bool enabled_;
+
+  // A deque, as behaviors keep pointers to their counters
+  std::deque<BehaviorCounters> counters_;
+  unordered_map<std::type_index, BehaviorCounters*> types_;
+  ullong frame_count_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_BEHAVIOR_STATS_H_
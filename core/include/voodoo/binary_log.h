@@ -0,0 +1,114 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_BINARY_LOG_H_
+#define VOODOO_BINARY_LOG_H_
+
+#include "logger.h"
+
+#include <deque>
+#include <fstream>
+
+namespace voodoo {
+// Binary log file layout. The header is followed by records, each starting
+// with its kind byte, integers are LEB128 varints:
+//   kBinaryLogRecordFormat  id, length, characters of a format string
+//   kBinaryLogRecordEntry   level | category << 2, thread, time since the
+//                           previous entry in ns (zigzag), format id or zero
+//                           for plain messages, size, the LogArguments or
+//                           the message
+// Formats are written once, before the first entry using them. Records are
+// only appended, a file cut short by a crash reads up to its last whole
+// record.
+struct BinaryLogHeader {
+  uint magic;
+  uint version;
+
+  // Nanoseconds since the Unix epoch at time zero of the entries
+  ullong start_time;
+};
+
+enum BinaryLogRecord {
+  kBinaryLogRecordFormat = 1,
+  kBinaryLogRecordEntry = 2,
+};
+
+struct BinaryLogEntry {
+  LogEntryLevel level;
+  LogCategory category;
+  uint thread;
+
+  // Nanoseconds since the start of the log
+  ullong time;
+
+  // Null for plain messages
+  const char* format;
+  string text;
+};
+
+// Used by the log writer thread, see Log::OpenBinary()
+class BinaryLogWriter final {
+ public:
+  static constexpr uint kMagic = 0x474f4c56;  // "VLOG"
+  static constexpr uint kVersion = 1;
+
+  BinaryLogWriter();
+
+  bool Open(const string& filename, ullong start_time);
+
+  // Adds the entry to the records not yet written
+  void Append(const BinaryLogEntry& entry);
+
+  bool Write();
+
+  // Record bytes and entries written so far
+  ullong GetSize() const;
+  ullong GetEntryCount() const;
+
+ private:
+  std::ofstream file_;
+  string records_;
+  unordered_map<const char*, uint> format_ids_;
+  ullong last_time_;
+  ullong size_;
+  ullong entry_count_;
+};
+
+class BinaryLogReader final {
+ public:
+  // Throws if the file cannot be read or is not a binary log
+  explicit BinaryLogReader(const string& filename);
+
+  // False at the end of the file or its last whole record
+  bool Next(BinaryLogEntry& entry);
+
+  ullong GetStartTime() const;
+
+  // Whether the file ends within a record, e.g. after a crash
+  bool IsTruncated() const;
+
+ private:
+  string data_;
+  size_t offset_;
+  ullong start_time_;
+  ullong time_;
+  bool truncated_;
+
+  // Indexed by id, first is the plain message
+  std::deque<string> formats_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_BINARY_LOG_H_
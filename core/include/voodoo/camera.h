@@ -26,6 +26,9 @@ class Camera : public Component {
   float4x4 GetViewMatrix();
   float4x4 GetProjectionMatrix();
 
+  // Vertical, in radians
+  float GetFov() const;
+
  private:
   float fov_, aspect_ratio_, z_near_, z_far_;
 };
@@ -59,8 +59,9 @@ struct color {
         b(clamp_color(v.z)),
         a(clamp_color(v.w)) {}
 
-  inline operator float*() const {
-    return new float[4]{r, g, b, a};
+  // The four channels in order, as Direct3D takes colors
+  inline operator const float*() const {
+    return &r;
   }
 
   inline operator float3() const {
@@ -74,6 +75,8 @@ struct color {
  public:
   float r, g, b, a;
 };
+
+static_assert(sizeof(color) == 4 * sizeof(float), "color is read as float[4]");
 }  // namespace voodoo
 
 #endif
\ No newline at end of file
@@ -20,6 +20,8 @@
 
 #include "game_object.h"
 #include "logger.h"
+#include "memory_tracker.h"
+#include "object_pool.h"
 #include "scene.h"
 
 // Not necessary but widely-used dependencies
@@ -52,12 +54,21 @@ class Component : public Object {
     return game_object_->AddComponent(forward<Types>(args)...);
   }
 
+  // From the global arena, components added to a game object come from
+  // its scene's
   template <class T, class... Types, enable_if_component_t<T> = 0>
   static sptr<T> Create(Types&&... args) {
     using namespace std;
-    auto component = make_shared<T>(forward<Types>(args)...);
-    auto name = get_class_name<T>();
-    component->SetName(name);
+    return CreateIn<T>(ObjectArena::GetGlobal(), forward<Types>(args)...);
+  }
+
+  template <class T, class... Types, enable_if_component_t<T> = 0>
+  static sptr<T> CreateIn(const sptr<ObjectArena>& arena, Types&&... args) {
+    using namespace std;
+    MemoryScope memory_scope(kMemoryTagComponents);
+    auto component = allocate_shared<T>(PoolAllocator<T>(arena),
+                                        forward<Types>(args)...);
+    component->SetName(get_class_name_id<T>());
     return component;
   }
 
@@ -65,7 +76,7 @@ class Component : public Object {
   Component() = default;
 
  private:
-  void SetName(const string& name);
+  void SetName(NameId name);
 
  protected:
   sptr<GameObject> game_object_;
@@ -75,12 +86,14 @@ class Component : public Object {
 template <class T, class... Types, enable_if_component_t<T>>
 sptr<T> GameObject::AddComponent(Types&&... args) {
   using namespace std;
-  auto name = get_class_name<T>();
-  if (GetComponentByName(name)) {
-    Log::Warning("GameObject " + GetName() + " already have " + name + " component");
+  if (GetComponentByName(get_class_name_id<T>())) {
+    VOODOO_LOG_WARNING(kLogCategoryEngine,
+                       "GameObject {} already have {} component", GetName(),
+                       get_class_name<T>());
     return nullptr;
   }
-  auto component = Component::Create<T>(forward<Types>(args)...);
+  auto arena = scene_ ? scene_->GetArena() : ObjectArena::GetGlobal();
+  auto component = Component::CreateIn<T>(arena, forward<Types>(args)...);
   return d_cast<T>(InsertComponent(component));
 }
 }  // namespace voodoo
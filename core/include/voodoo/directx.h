@@ -29,6 +29,7 @@ class DirectX : public GraphicsAPI {
   virtual bool Init(const sptr<Window>& window) override;
   virtual bool Render(const sptr<Scene>& scene) override;
   virtual bool CreateMeshBuffers(sptr<Mesh> mesh) override;
+  virtual void ReleaseMeshBuffers() override;
 
   void ToggleWireframeMode();
   void ToggleBlendMode();
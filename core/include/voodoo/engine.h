@@ -17,10 +17,12 @@
 #define VOODOO_ENGINE_H_
 
 #include "graphics_api.h"
+#include "hot_reload.h"
 #include "logger.h"
 #include "time.h"
 #include "window.h"
 #include "scene.h"
+#include "texture_streamer.h"
 
 namespace voodoo {
 class Engine {
@@ -32,17 +34,31 @@ class Engine {
   wstring GetName() const;
   sptr<Window> GetWindow() const;
   sptr<GraphicsAPI> GetGraphicsAPI() const;
+  sptr<HotReload> GetHotReload() const;
+  sptr<TextureStreamer> GetTextureStreamer() const;
   sptr<Scene> GetScene() const;
 
  private:
   void UpdateCaption();
   bool Update();
 
+  // Warns when a steady frame allocates, with memory tracking hooked
+  void CheckFrameAllocations();
+
  private:
   wstring name_;
   sptr<Window> window_;
   sptr<GraphicsAPI> graphics_api_;
+  sptr<HotReload> hot_reload_;
+  sptr<TextureStreamer> texture_streamer_;
   sptr<Scene> scene_;
+
+  // Frames since the scene, its assets or its streamed textures last
+  // changed, and what they were at that point
+  uint steady_frames_ = 0;
+  size_t checked_objects_ = 0;
+  uint checked_reloads_ = 0;
+  ullong checked_streamed_bytes_ = 0;
 };
 }  // namespace voodoo
 
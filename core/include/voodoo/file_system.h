@@ -0,0 +1,85 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_FILE_SYSTEM_H_
+#define VOODOO_FILE_SYSTEM_H_
+
+#include "mapped_file.h"
+
+#include <functional>
+#include <ostream>
+#include <shared_mutex>
+
+namespace voodoo {
+class Archive;
+
+// Read-only contents of a file. The data either points into a memory
+// mapping that it keeps alive or into a buffer it owns.
+class FileData final {
+ public:
+  explicit FileData(sptr<MappedFile> mapping);
+  FileData(sptr<MappedFile> mapping, const byte* data, size_t size);
+  explicit FileData(vector<byte>&& buffer);
+
+  // No copy
+  FileData(const FileData& other) = delete;
+  FileData& operator=(const FileData& other) = delete;
+
+  const byte* GetData() const;
+  size_t GetSize() const;
+
+ private:
+  sptr<MappedFile> mapping_;
+  vector<byte> buffer_;
+  const byte* data_;
+  size_t size_;
+};
+
+// Virtual file system over loose files and mounted archives. Asset
+// loaders read through it, so packed and loose assets are
+// interchangeable.
+class FileSystem final {
+ public:
+  // Files below the mount point are looked up in the archive first,
+  // archives mounted later take precedence
+  static bool Mount(const string& archive, const string& mount_point);
+  static void UnmountAll();
+
+  // Throws when the file is neither in a mounted archive nor on disk
+  static sptr<FileData> Read(const string& filename);
+
+  // Writes the file under a temporary name and moves it over the target.
+  // Mappings of the previous file stay valid, and a failed write leaves
+  // it untouched.
+  static bool Write(const string& filename, const byte* data, size_t size);
+  static bool Write(const string& filename,
+                    const std::function<void(std::ostream&)>& write);
+
+ private:
+  struct MountPoint {
+    string prefix;
+    sptr<Archive> archive;
+  };
+
+  static string Normalize(const string& path);
+  static bool Replace(const string& source, const string& target);
+
+ private:
+  static std::shared_mutex mutex_;
+  static vector<MountPoint> mounts_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_FILE_SYSTEM_H_
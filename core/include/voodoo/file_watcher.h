@@ -0,0 +1,70 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_FILE_WATCHER_H_
+#define VOODOO_FILE_WATCHER_H_
+
+#include "std_mappings.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace voodoo {
+// Reports files written or renamed into watched directory trees. Every
+// directory is watched by its own thread, which invokes the callback with
+// the normalized path of the changed file.
+class FileWatcher final {
+ public:
+  using Callback = std::function<void(const string& filename)>;
+
+  explicit FileWatcher(Callback callback);
+  ~FileWatcher();
+
+  // No copy
+  FileWatcher(const FileWatcher& other) = delete;
+  FileWatcher& operator=(const FileWatcher& other) = delete;
+
+  // Subdirectories created after this call are not watched on Linux
+  bool Watch(const string& directory);
+
+ private:
+  struct Directory {
+    string path;
+#ifdef _WIN32
+    void* handle;
+#else
+    int descriptor;
+    map<int, string> subdirectories;
+#endif  // _WIN32
+    std::thread thread;
+  };
+
+  void Work(Directory& directory);
+
+ private:
+  Callback callback_;
+  vector<uptr<Directory>> directories_;
+  std::mutex mutex_;
+  std::atomic<bool> stopping_;
+
+#ifdef _WIN32
+  void* stop_event_;
+#endif  // _WIN32
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_FILE_WATCHER_H_
@@ -20,8 +20,6 @@
 #include "mesh.h"
 #include "texture.h"
 
-#include <map>
-
 namespace voodoo {
 class Font {
  public:
@@ -36,12 +34,16 @@ class Font {
 
   float GetWidth();
   float GetHeight();
+
+  // Cooked atlases are padded to whole compression blocks, glyphs keep
+  // their texel positions
+  void SetAtlasSize(float width, float height);
   CharData GetCharData(const char& c);
 
  private:
   float width_, height_;
 
-  std::map<char, Font::CharData> characters_;
+  flat_hash_map<char, Font::CharData> characters_;
 };
 }  // namespace voodoo
 
@@ -0,0 +1,101 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_FRAME_ARENA_H_
+#define VOODOO_FRAME_ARENA_H_
+
+#include "std_mappings.h"
+
+namespace voodoo {
+// Bump allocator for memory that lives no longer than a frame: allocating
+// moves a pointer, Reset() releases everything at once. A frame that needs
+// more than the capacity takes extra blocks and the next Reset() grows the
+// capacity to cover them, so a steady frame does not touch the heap. Not
+// thread safe.
+class FrameArena final {
+ public:
+  static constexpr size_t kDefaultCapacity = 256 * 1024;
+
+  // The main thread's arena, reset by the engine at the end of the frame
+  static FrameArena& Get();
+
+  explicit FrameArena(size_t capacity = kDefaultCapacity);
+
+  // No copy
+  FrameArena(const FrameArena& other) = delete;
+  FrameArena& operator=(const FrameArena& other) = delete;
+
+  void* Allocate(size_t size, size_t alignment);
+
+  // Everything allocated since the last reset must be out of use
+  void Reset();
+
+  // Bytes taken since the last reset, alignment included
+  size_t GetUsed() const;
+  size_t GetPeak() const;
+  size_t GetCapacity() const;
+
+ private:
+  uptr<byte[]> block_;
+  vector<uptr<byte[]>> overflow_;
+  size_t capacity_;
+
+  byte* position_;
+  byte* end_;
+  size_t used_;
+  size_t peak_;
+};
+
+// Places a container's memory in a FrameArena, e.g. frame_vector below.
+// Deallocation does nothing, the memory returns on the arena's reset.
+template <class T>
+class FrameAllocator {
+ public:
+  using value_type = T;
+
+  FrameAllocator() : arena_(&FrameArena::Get()) {}
+  explicit FrameAllocator(FrameArena& arena) : arena_(&arena) {}
+
+  template <class U>
+  FrameAllocator(const FrameAllocator<U>& other) : arena_(other.arena_) {}
+
+  T* allocate(size_t count) {
+    return static_cast<T*>(arena_->Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* pointer, size_t count) {}
+
+  template <class U>
+  bool operator==(const FrameAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+
+  template <class U>
+  bool operator!=(const FrameAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+
+ private:
+  template <class U>
+  friend class FrameAllocator;
+
+  FrameArena* arena_;
+};
+
+template <class T>
+using frame_vector = std::vector<T, FrameAllocator<T>>;
+}  // namespace voodoo
+
+#endif  // VOODOO_FRAME_ARENA_H_
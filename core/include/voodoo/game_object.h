@@ -26,13 +26,23 @@ class Transform;
 template <class T>
 using enable_if_component_t = enable_if_t<is_base_of_v<Component, T>, int>;
 
+// Built once per type, components are looked up by it every frame
 template<class T>
-string get_class_name() {
-  return string(typeid(T).name()).erase(0, 14);
+const string& get_class_name() {
+  static const string name = string(typeid(T).name()).erase(0, 14);
+  return name;
+}
+
+template <class T>
+NameId get_class_name_id() {
+  static const NameId id = NameId::Intern(get_class_name<T>());
+  return id;
 }
 
 class GameObject final : public Object {
  public:
+  using ComponentMap = flat_hash_map<NameId, sptr<Component>>;
+
   GameObject() = delete;
   GameObject(const string& name, sptr<Scene> scene);
 
@@ -49,27 +59,30 @@ class GameObject final : public Object {
 
   sptr<Scene> GetScene() const;
   sptr<Transform> GetTransform() const;
-  vector<sptr<Component>> GetComponents() const;
+  // A view, copy it to add or remove components while iterating
+  map_values<ComponentMap> GetComponents() const;
   sptr<Component> AddComponent(sptr<Component> component);
 
   template <class T, enable_if_component_t<T> = 0>
   sptr<T> GetComponent() const {
-    auto name = get_class_name<T>();
-    auto component = GetComponentByName(name);
+    auto component = GetComponentByName(get_class_name_id<T>());
     return component ? s_cast<T>(component) : nullptr;
   }
 
   template <class T, class... Types, enable_if_component_t<T> = 0>
   sptr<T> AddComponent(Types&&... args);
 
+  // Drops the components, parent and scene, see Scene::Unload()
+  void Release();
+
  private:
-   sptr<Component> GetComponentByName(const string& name) const;
+   sptr<Component> GetComponentByName(NameId name) const;
    sptr<Component> InsertComponent(sptr<Component> component);
 
  private:
   sptr<Scene> scene_;
   sptr<GameObject> parent_;
-  map<string, sptr<Component>> components_;
+  ComponentMap components_;
 
   bool active_;
 };
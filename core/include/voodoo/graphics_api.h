@@ -36,14 +36,36 @@ struct Mesh;
 class Scene;
 class Window;
 
+// Counted by the last Render() call
+struct RenderStats {
+  uint draws;
+  uint shader_binds, texture_binds, mesh_binds;
+
+  // Runs of draws sharing shader and texture, each of which could become
+  // a single batched or instanced draw
+  uint batches;
+};
+
 class GraphicsAPI {
  protected:
   using Device = ID3D11Device;
   using DeviceContext = ID3D11DeviceContext;
 
   using Buffer = ID3D11Buffer*;
-  using MeshBuffer = pair<Buffer, Buffer>;
-  using MeshBufferMap = map<sptr<Mesh>, MeshBuffer>;
+
+  // Buffers don't keep their mesh alive, so that a mesh no renderer uses
+  // any more can be evicted by its manager
+  struct MeshBuffer {
+    // Tells the mesh apart from a freed one that had the same address
+    bool IsOf(const sptr<Mesh>& other) const {
+      return !mesh.owner_before(other) && !other.owner_before(mesh);
+    }
+
+    std::weak_ptr<Mesh> mesh;
+    Buffer vertices = nullptr;
+    Buffer indices = nullptr;
+  };
+  using MeshBufferMap = flat_hash_map<const Mesh*, MeshBuffer>;
 
  public:
   virtual ~GraphicsAPI() = default;
@@ -52,15 +74,21 @@ class GraphicsAPI {
   virtual bool Render(const sptr<Scene>& scene) = 0;
   virtual bool CreateMeshBuffers(sptr<Mesh> mesh) = 0;
 
+  // Releases the buffers of every mesh, called when a scene is unloaded.
+  // Meshes drawn later get their buffers again on first use.
+  virtual void ReleaseMeshBuffers() = 0;
+
   sptr<Device> GetDevice() { return device_; }
   sptr<DeviceContext> GetDeviceContext() { return device_context_; }
-  MeshBufferMap GetMeshBuffers() { return mesh_buffers_; }
+  const MeshBufferMap& GetMeshBuffers() const { return mesh_buffers_; }
+  const RenderStats& GetRenderStats() const { return render_stats_; }
 
  protected:
   sptr<Device> device_;
   sptr<DeviceContext> device_context_;
 
   MeshBufferMap mesh_buffers_;
+  RenderStats render_stats_ = {0, 0, 0, 0, 0};
 };
 }  // namespace voodoo
 
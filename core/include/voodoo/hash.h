@@ -0,0 +1,49 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_HASH_H_
+#define VOODOO_HASH_H_
+
+#include "std_mappings.h"
+
+namespace voodoo {
+constexpr ullong kFnvOffsetBasis = 14695981039346656037ull;
+constexpr ullong kFnvPrime = 1099511628211ull;
+
+// 64-bit FNV-1a, pass a previous result as seed to hash in pieces
+inline ullong Fnv1a(const void* data, size_t size,
+                    ullong seed = kFnvOffsetBasis) {
+  const byte* bytes = static_cast<const byte*>(data);
+  ullong hash = seed;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+// Usable in constant expressions, e.g. for NameId literals
+constexpr ullong Fnv1a(std::string_view text,
+                       ullong seed = kFnvOffsetBasis) {
+  ullong hash = seed;
+  for (char c : text) {
+    hash ^= static_cast<byte>(c);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+}  // namespace voodoo
+
+#endif  // VOODOO_HASH_H_
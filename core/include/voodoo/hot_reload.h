@@ -0,0 +1,105 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_HOT_RELOAD_H_
+#define VOODOO_HOT_RELOAD_H_
+
+#include "file_watcher.h"
+#include "graphics_api.h"
+#include "image.h"
+#include "mesh.h"
+#include "scene.h"
+#include "shader.h"
+
+#include <chrono>
+#include <future>
+#include <set>
+
+namespace voodoo {
+struct HotReloadStats {
+  uint reloads, failures;
+
+  // From the first change notification to the recreated GPU resources
+  float last_latency, max_latency;
+};
+
+// Reloads resident assets when their files change. Assets load on the
+// thread pool and are swapped in place on the main thread, so existing
+// references stay valid. Afterwards only the GPU resources created from
+// the changed assets are recreated: mesh buffers, textures and shaders
+// used by renderers of the scene.
+class HotReload final {
+ public:
+  using Listener = std::function<void(const string& filename)>;
+
+  explicit HotReload(sptr<GraphicsAPI> graphics_api);
+  ~HotReload();
+
+  // Asset filenames must be normalized paths below the directory, e.g.
+  // "../assets/meshes/cube.mesh" when watching "../assets"
+  bool Watch(const string& directory);
+
+  // Listeners run on the main thread after the assets of a changed file
+  // were swapped and before the GPU resources are recreated
+  void AddListener(Listener listener);
+
+  // Applies completed reloads, called once per frame on the main thread
+  void Update(const sptr<Scene>& scene);
+
+  const HotReloadStats& GetStats() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Change {
+    Clock::time_point first, last;
+  };
+
+  struct Reload {
+    string filename;
+    Clock::time_point changed;
+    bool failed;
+
+    sptr<Mesh> mesh, fresh_mesh;
+    sptr<Image> image, fresh_image;
+    sptr<ShaderBuffer> shader_buffer, fresh_shader_buffer;
+  };
+
+  void OnChange(const string& filename);
+  void LoadAssets(const string& filename, Clock::time_point changed);
+  void Apply(Reload& reload, const sptr<Scene>& scene);
+
+ private:
+  sptr<GraphicsAPI> graphics_api_;
+  vector<Listener> listeners_;
+  HotReloadStats stats_;
+
+  // Changes wait until the file has been quiet for a moment, editors
+  // often save in several writes
+  std::mutex mutex_;
+  map<string, Change> changes_;
+  vector<Reload> reloads_;
+
+  // Files with a load in flight. Further changes stay queued until its
+  // result is queued, so that results are applied in the order of changes.
+  std::set<string> loading_;
+  vector<std::future<void>> loads_;
+
+  // Destroyed first so that no callback arrives during destruction
+  uptr<FileWatcher> watcher_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_HOT_RELOAD_H_
@@ -16,11 +16,80 @@
 #ifndef VOODOO_IMAGE_H_
 #define VOODOO_IMAGE_H_
 
+#include "std_mappings.h"
+
+#include <utility>
+
 namespace voodoo {
+// Block compressed formats store 4x4 texel blocks. Values are stored in
+// cooked files.
+enum ImageFormat {
+  kImageFormatRgba8 = 0,
+  kImageFormatBc1 = 1,  // RGB, 8 bytes per block
+  kImageFormatBc3 = 2,  // RGBA, 16 bytes per block
+  kImageFormatBc4 = 3,  // R, 8 bytes per block
+  kImageFormatBc7 = 4,  // RGBA, 16 bytes per block
+  kImageFormatR8 = 5,
+  kImageFormatRg8 = 6,
+  kImageFormatCount = 7,
+};
+
+inline bool IsBlockCompressed(ImageFormat format) {
+  return format >= kImageFormatBc1 && format <= kImageFormatBc7;
+}
+
+// Bytes per texel of uncompressed formats
+inline int GetComponentCount(ImageFormat format) {
+  switch (format) {
+    case kImageFormatR8:
+      return 1;
+    case kImageFormatRg8:
+      return 2;
+    default:
+      return 4;
+  }
+}
+
+// Bytes of one row of texels, or of blocks when block compressed
+inline size_t GetImageRowPitch(ImageFormat format, int width) {
+  switch (format) {
+    case kImageFormatBc1:
+    case kImageFormatBc4:
+      return size_t((width + 3) / 4) * 8;
+    case kImageFormatBc3:
+    case kImageFormatBc7:
+      return size_t((width + 3) / 4) * 16;
+    default:
+      return size_t(width) * GetComponentCount(format);
+  }
+}
+
+inline size_t GetImageLevelSize(ImageFormat format, int width, int height) {
+  int rows = IsBlockCompressed(format) ? (height + 3) / 4 : height;
+  return GetImageRowPitch(format, width) * rows;
+}
+
+struct ImageLevel {
+  int width, height;
+  vector<byte> data;
+};
+
 struct Image {
  public:
   Image(const int& width, const int& height, const int& channels, byte* data)
-      : width(width), height(height), channels(channels), data(data) {}
+      : width(width),
+        height(height),
+        channels(channels),
+        format(kImageFormatRgba8),
+        data(data) {}
+
+  Image(const int& width, const int& height, const int& channels,
+        ImageFormat format, byte* data)
+      : width(width),
+        height(height),
+        channels(channels),
+        format(format),
+        data(data) {}
 
   ~Image() {
     if (data) {
@@ -28,9 +97,29 @@ struct Image {
     }
   }
 
+  // No copy
+  Image(const Image& other) = delete;
+  Image& operator=(const Image& other) = delete;
+
+  // Used by hot reload to replace contents in place
+  Image& operator=(Image&& other) noexcept {
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(channels, other.channels);
+    std::swap(format, other.format);
+    std::swap(data, other.data);
+    std::swap(mips, other.mips);
+    return *this;
+  }
+
  public:
+  // Channels of the source file, the format may keep fewer or more
   int width, height, channels;
+  ImageFormat format;
   byte* data;
+
+  // Levels below the full resolution one, largest first
+  vector<ImageLevel> mips;
 };
 }  // namespace voodoo
 
@@ -18,8 +18,27 @@
 
 #include "asset_manager.h"
 #include "image.h"
+#include "mip_generator.h"
+
+#include <atomic>
+#include <mutex>
 
 namespace voodoo {
+struct ImageOptions {
+  ImageOptions() : channels(0) {}
+
+  // Channels kept in memory, 0 keeps those of the file. Three channels are
+  // always widened to four as there is no 24-bit texture format. Single
+  // channel textures sample as red only, gray color maps should ask for 4.
+  int channels;
+  MipOptions mips;
+};
+
+// Decoded (not cooked) images, with the bytes they would take as RGBA
+struct ImageMemoryStats {
+  ullong images, bytes, rgba8_bytes;
+};
+
 class ImageManager : public AssetManager<Image> {
  public:
   // Temporal singleton
@@ -28,8 +47,26 @@ class ImageManager : public AssetManager<Image> {
     return instance;
   }
 
+  // Images loaded afterwards are decoded with these options instead of the
+  // defaults
+  void SetImageOptions(const string& filename, const ImageOptions& options);
+
+  ImageMemoryStats GetMemoryStats() const;
+
+ private:
+  virtual sptr<Image> Load(const string& filename,
+                           sptr<FileData> file) override;
+  virtual size_t GetAssetSize(const Image& image) const override;
+
+  ImageOptions GetImageOptions(const string& filename);
+
  private:
-  virtual sptr<Image> Load(const string& filename) override;
+  std::mutex options_mutex_;
+  unordered_map<string, ImageOptions> options_;
+
+  std::atomic<ullong> total_images_{0};
+  std::atomic<ullong> total_bytes_{0};
+  std::atomic<ullong> total_rgba8_bytes_{0};
 };
 }  // namespace voodoo
 
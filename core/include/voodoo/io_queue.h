@@ -0,0 +1,137 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_IO_QUEUE_H_
+#define VOODOO_IO_QUEUE_H_
+
+#include "file_system.h"
+#include "std_mappings.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace voodoo {
+// Lower values are served first
+enum IoPriority {
+  kIoPriorityHigh = 0,    // Needed for the current frame
+  kIoPriorityNormal = 1,
+  kIoPriorityLow = 2,     // Prefetching
+};
+
+// Called on an I/O thread with the file contents or with the error
+using IoCallback =
+    std::function<void(sptr<FileData> file, std::exception_ptr error)>;
+
+struct IoStats {
+  ullong requests, coalesced, cancelled, failed;
+  ullong bytes;
+
+  // Time with at least one read pending or in flight
+  double busy_time;
+
+  // From the request to the completion, in milliseconds
+  double latency_p50, latency_p90, latency_p99, latency_max;
+};
+
+class IoQueue;
+struct IoRead;
+
+// Handle of one caller's interest in a read
+class IoRequest final {
+ public:
+  IoRequest();
+
+  // Drops the callback, it is invoked with an error instead. The read
+  // itself is dropped when no other caller waits for it. False when the
+  // read has already started.
+  bool Cancel();
+
+ private:
+  friend class IoQueue;
+
+  IoQueue* queue_;
+  sptr<IoRead> read_;
+  uint ticket_;
+};
+
+// Prioritised queue of file reads served by dedicated I/O threads, so
+// decoding on the thread pool never waits behind a read. Reads of a file
+// that is already queued or being read are coalesced into one, taking the
+// highest priority of the callers.
+//
+// Files are read through the FileSystem. Mapped data is touched page by
+// page on the I/O thread, so the page faults happen there rather than in
+// the decoder.
+class IoQueue final {
+ public:
+  explicit IoQueue(uint thread_count = 2);
+  ~IoQueue();
+
+  // No copy
+  IoQueue(const IoQueue& other) = delete;
+  IoQueue& operator=(const IoQueue& other) = delete;
+
+  // Temporal singleton shared by asset loading
+  static IoQueue& Get() {
+    static IoQueue instance;
+    return instance;
+  }
+
+  IoRequest Read(const string& filename, IoPriority priority,
+                 IoCallback callback);
+
+  IoStats GetStats() const;
+  void ResetStats();
+
+ private:
+  friend class IoRequest;
+
+  using Clock = std::chrono::steady_clock;
+
+  // Pending reads ordered by priority, then by submission
+  using Order = std::pair<uint, ullong>;
+
+  bool Cancel(const sptr<IoRead>& read, uint ticket);
+  void Work();
+  void Complete(const sptr<IoRead>& read, sptr<FileData> file,
+                std::exception_ptr error);
+
+  static void Touch(const FileData& file);
+
+ private:
+  static constexpr size_t kLatencySampleCount = 4096;
+
+  vector<std::thread> threads_;
+  std::map<Order, sptr<IoRead>> pending_;
+  unordered_map<string, sptr<IoRead>> reads_;
+  ullong sequence_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopping_;
+
+  ullong requests_, coalesced_, cancelled_, failed_, bytes_;
+  Clock::time_point busy_start_;
+  Clock::duration busy_time_;
+  vector<float> latencies_;
+  size_t latency_next_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_IO_QUEUE_H_
@@ -25,9 +25,16 @@
 #include <windows.h>
 #endif  // _WIN32 &&_DEBUG
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
 
 #include "std_mappings.h"
 
@@ -49,6 +56,137 @@ enum LogEntryLevel {
   kLogEntryLevelError = 2,
 };
 
+enum LogCategory {
+  kLogCategoryEngine = 0,
+  kLogCategoryAssets = 1,
+  kLogCategoryRender = 2,
+  kLogCategoryNetwork = 3,
+  kLogCategoryCount = 4,
+};
+
+// Entries below this level are compiled out of the VOODOO_LOG_* macros,
+// their arguments are not even evaluated
+#ifndef VOODOO_LOG_LEVEL
+#define VOODOO_LOG_LEVEL 0
+#endif
+
+// Logs "{}" placeholders in a string literal filled in with the arguments
+// in order, e.g.
+//   VOODOO_LOG_WARNING(kLogCategoryAssets, "Failed to read \"{}\"", name);
+// Only the arguments are copied, the text is put together by the writer
+// thread and only when the level and category are enabled.
+#define VOODOO_LOG(level, category, ...)                                 \
+  do {                                                                   \
+    if constexpr ((level) >= VOODOO_LOG_LEVEL) {                         \
+      if (::voodoo::Log::IsEnabled((level), (category)))                 \
+        ::voodoo::Log::Format((level), (category), __VA_ARGS__);         \
+    }                                                                    \
+  } while (false)
+
+#define VOODOO_LOG_INFO(category, ...) \
+  VOODOO_LOG(::voodoo::kLogEntryLevelInfo, category, __VA_ARGS__)
+#define VOODOO_LOG_WARNING(category, ...) \
+  VOODOO_LOG(::voodoo::kLogEntryLevelWarning, category, __VA_ARGS__)
+#define VOODOO_LOG_ERROR(category, ...) \
+  VOODOO_LOG(::voodoo::kLogEntryLevelError, category, __VA_ARGS__)
+
+enum LogArgumentType {
+  kLogArgumentTypeInt = 0,
+  kLogArgumentTypeUint = 1,
+  kLogArgumentTypeDouble = 2,
+  kLogArgumentTypeBool = 3,
+  kLogArgumentTypeString = 4,
+};
+
+// Arguments of a deferred entry, each a type byte followed by its value.
+// Integers and string lengths are LEB128 varints, signed ones zigzag
+// encoded, doubles are stored as they are in memory.
+class LogArguments final {
+ public:
+  static void Encode(string& arguments) {}
+
+  template <class T, class... Rest>
+  static void Encode(string& arguments, const T& value,
+                     const Rest&... rest) {
+    Append(arguments, value);
+    Encode(arguments, rest...);
+  }
+
+  // Replaces the placeholders of format, extra arguments are ignored
+  static string Format(const char* format, const string& arguments);
+
+  static void AppendVarint(string& data, ullong value) {
+    while (value >= 0x80) {
+      data += static_cast<char>((value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+    data += static_cast<char>(value);
+  }
+
+  // False when data ends first
+  static bool ReadVarint(const string& data, size_t& offset, ullong& value);
+
+  // Small values of either sign take few bytes
+  static ullong ZigZag(llong value) {
+    return (ullong(value) << 1) ^ ullong(value >> 63);
+  }
+  static llong UnZigZag(ullong value) {
+    return llong(value >> 1) ^ -llong(value & 1);
+  }
+
+ private:
+  static void Append(string& arguments, bool value) {
+    arguments += static_cast<char>(kLogArgumentTypeBool);
+    arguments += static_cast<char>(value);
+  }
+
+  template <class T, std::enable_if_t<std::is_arithmetic_v<T>, int> = 0>
+  static void Append(string& arguments, T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+      auto stored = double(value);
+      arguments += static_cast<char>(kLogArgumentTypeDouble);
+      arguments.append(reinterpret_cast<const char*>(&stored),
+                       sizeof(stored));
+    } else if constexpr (std::is_signed_v<T>) {
+      arguments += static_cast<char>(kLogArgumentTypeInt);
+      AppendVarint(arguments, ZigZag(llong(value)));
+    } else {
+      arguments += static_cast<char>(kLogArgumentTypeUint);
+      AppendVarint(arguments, ullong(value));
+    }
+  }
+
+  template <class T, std::enable_if_t<std::is_enum_v<T>, int> = 0>
+  static void Append(string& arguments, T value) {
+    Append(arguments, llong(value));
+  }
+
+  static void Append(string& arguments, const char* value) {
+    Append(arguments, value, std::char_traits<char>::length(value));
+  }
+
+  static void Append(string& arguments, const string& value) {
+    Append(arguments, value.data(), value.size());
+  }
+
+  static void Append(string& arguments, const char* value, size_t length) {
+    arguments += static_cast<char>(kLogArgumentTypeString);
+    AppendVarint(arguments, length);
+    arguments.append(value, length);
+  }
+};
+
+// What logging threads do when the writer falls behind and the queue is full
+enum LogOverflowPolicy {
+  kLogOverflowPolicyBlock = 0,  // Wait for a free entry, nothing is lost
+  kLogOverflowPolicyDrop = 1,   // Return at once and count it, but errors
+                                // still wait
+};
+
+class BinaryLogWriter;
+
+// Entries are queued and written to log.txt in batches by a background
+// thread, errors wait until they are written. Safe to use from any thread.
 class Log final {
  public:
   ~Log();
@@ -62,13 +200,92 @@ class Log final {
 
   static void Throw(string message);
 
+  // Deferred entry, see VOODOO_LOG(). The format is kept by pointer and
+  // must outlive the log, as string literals do.
+  template <class... Args>
+  static void Format(LogEntryLevel level, LogCategory category,
+                     const char* format, const Args&... args) {
+    string& arguments = GetArgumentBuffer();
+    arguments.clear();
+    LogArguments::Encode(arguments, args...);
+    Write(level, category, format, arguments);
+  }
+
+  static bool IsEnabled(LogEntryLevel level, LogCategory category) {
+    return level >= levels_[category].load(std::memory_order_relaxed);
+  }
+
+  // Lowest level written, of every category or just one
+  static void SetLevel(LogEntryLevel level);
+  static void SetLevel(LogCategory category, LogEntryLevel level);
+
+  // Returns once everything logged before the call is written
+  static void Flush();
+
+  // From then on also writes every entry to a binary file without
+  // formatting it, see BinaryLogWriter, and leaves only warnings and errors
+  // to log.txt. Can only be opened once.
+  static bool OpenBinary(const string& filename);
+
+  static void SetOverflowPolicy(LogOverflowPolicy policy);
+
+  // Entries lost to kLogOverflowPolicyDrop
+  static ullong GetDroppedCount();
+
  private:
+  // Written by one logging thread, then read by the writer once sequence
+  // says so
+  struct Entry {
+    std::atomic<size_t> sequence;
+    LogEntryLevel level;
+    LogCategory category;
+    uint thread;
+
+    // Nanoseconds since the log started
+    ullong time;
+
+    // The message, or the arguments of format when there is one
+    const char* format;
+    string text;
+  };
+
   Log();
 
   static Log& Get();
+  static string& GetArgumentBuffer();
+  static uint GetThreadId();
+
+  static void Write(LogEntryLevel level, LogCategory category,
+                    const char* format, string& text);
+
+  bool Push(LogEntryLevel level, LogCategory category, const char* format,
+            string& text);
+  void Work();
+
+ private:
+  static std::atomic<LogEntryLevel> levels_[kLogCategoryCount];
 
  private:
   std::ofstream log_file_;
+  std::chrono::steady_clock::time_point start_;
+
+  // Only used by the writer once binary_open_ is set
+  uptr<BinaryLogWriter> binary_;
+  std::atomic<bool> binary_open_;
+
+  std::unique_ptr<Entry[]> entries_;
+  std::atomic<size_t> push_position_;
+  size_t pop_position_;
+
+  std::thread writer_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::atomic<size_t> written_;
+  size_t flush_position_;
+  bool stopping_;
+
+  std::atomic<LogOverflowPolicy> overflow_policy_;
+  std::atomic<ullong> dropped_;
 
 #ifdef VOODOO_LOG_CONSOLE_ENABLED
  private:
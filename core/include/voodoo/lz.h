@@ -0,0 +1,39 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_LZ_H_
+#define VOODOO_LZ_H_
+
+#include "std_mappings.h"
+
+namespace voodoo {
+// Byte-oriented LZ77 block codec in the spirit of LZ4. Favours
+// decompression speed over ratio, every block is self-contained.
+class Lz final {
+ public:
+  // Worst case size of a compressed block
+  static size_t GetBound(size_t size);
+
+  // Returns the compressed size, the destination must hold GetBound()
+  static size_t Compress(const byte* source, size_t size, byte* destination);
+
+  // Fails on malformed input or when the output doesn't match the
+  // expected size exactly
+  static bool Decompress(const byte* source, size_t size, byte* destination,
+                         size_t destination_size);
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_LZ_H_
@@ -0,0 +1,49 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_MAPPED_FILE_H_
+#define VOODOO_MAPPED_FILE_H_
+
+#include "std_mappings.h"
+
+namespace voodoo {
+// Read-only memory mapping of a whole file. Mapped memory stays valid
+// for the lifetime of the object.
+class MappedFile final {
+ public:
+  MappedFile(const string& filename);
+  ~MappedFile();
+
+  // No copy
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  const byte* GetData() const;
+  size_t GetSize() const;
+
+ private:
+#ifdef _WIN32
+  void* file_;
+  void* mapping_;
+#else
+  int descriptor_;
+#endif  // _WIN32
+
+  const byte* data_;
+  size_t size_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_MAPPED_FILE_H_
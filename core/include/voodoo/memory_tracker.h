@@ -0,0 +1,130 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_MEMORY_TRACKER_H_
+#define VOODOO_MEMORY_TRACKER_H_
+
+#include "std_mappings.h"
+
+#include <new>
+
+namespace voodoo {
+enum MemoryTag {
+  kMemoryTagGeneral = 0,  // Anything outside a MemoryScope
+  kMemoryTagMeshes = 1,
+  kMemoryTagImages = 2,
+  kMemoryTagComponents = 3,  // GameObjects and their components
+  kMemoryTagNetwork = 4,
+  kMemoryTagCount = 5,
+};
+
+struct MemoryTagStats {
+  const char* name;
+
+  llong live_bytes;
+  ullong peak_bytes;
+  llong live_allocations;
+  ullong allocations;
+
+  // Of the last whole frame
+  ullong frame_allocations, frame_bytes;
+};
+
+// Attributes the allocations of the current thread to a tag while alive,
+// scopes nest
+class MemoryScope final {
+ public:
+  explicit MemoryScope(MemoryTag tag);
+  ~MemoryScope();
+
+  // No copy
+  MemoryScope(const MemoryScope& other) = delete;
+  MemoryScope& operator=(const MemoryScope& other) = delete;
+
+ private:
+  MemoryTag previous_;
+};
+
+// Counts live, peak and per frame allocations per tag. Memory from
+// TaggedAllocator is always counted. Builds with VOODOO_MEMORY_TRACKING,
+// the default in debug, replace the global operator new and delete to count
+// everything else under the tag of the current MemoryScope. In Windows debug
+// builds the call stacks of large allocations and of a sample of the others
+// are kept for Dump().
+class MemoryTracker final {
+ public:
+  // Null when out of memory
+  static void* Allocate(size_t size, size_t alignment, MemoryTag tag);
+  static void Free(void* pointer);
+
+  static MemoryTag GetCurrentTag();
+
+  // Whether the global operator new is counted
+  static bool IsHooked();
+
+  // Closes the frame's counts, called by the engine
+  static void EndFrame();
+
+  static MemoryTagStats GetStats(MemoryTag tag);
+  static vector<MemoryTagStats> GetReport();
+
+  // Allocations of every tag in the last whole frame
+  static ullong GetFrameAllocationCount();
+
+  // Writes the report to the log
+  static void Dump();
+
+ private:
+  friend MemoryScope;
+};
+
+// Counts a container's memory under a tag, e.g.
+//   std::vector<char, TaggedAllocator<char, kMemoryTagNetwork>>
+template <class T, MemoryTag tag>
+class TaggedAllocator {
+ public:
+  using value_type = T;
+
+  template <class U>
+  struct rebind {
+    using other = TaggedAllocator<U, tag>;
+  };
+
+  TaggedAllocator() = default;
+
+  template <class U>
+  TaggedAllocator(const TaggedAllocator<U, tag>& other) {}
+
+  T* allocate(size_t count) {
+    void* pointer = MemoryTracker::Allocate(count * sizeof(T), alignof(T), tag);
+    if (!pointer) throw std::bad_alloc();
+    return static_cast<T*>(pointer);
+  }
+
+  void deallocate(T* pointer, size_t count) { MemoryTracker::Free(pointer); }
+
+  template <class U>
+  bool operator==(const TaggedAllocator<U, tag>& other) const {
+    return true;
+  }
+
+  template <class U>
+  bool operator!=(const TaggedAllocator<U, tag>& other) const {
+    return false;
+  }
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_MEMORY_TRACKER_H_
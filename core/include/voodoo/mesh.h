@@ -16,6 +16,7 @@
 #ifndef VOODOO_MESH_H_
 #define VOODOO_MESH_H_
 
+#include "file_system.h"
 #include "vertex.h"
 
 #include <vector>
@@ -50,22 +51,115 @@ struct Mesh {
       : vertices(),
         vertex_count(0),
         indices(),
-        index_count(0) {}
+        index_count(0),
+        vertex_format(kVertexFormatPtn),
+        position_offset(kVec3fZeros),
+        position_scale(1.0f),
+        bounds_min(kVec3fZeros),
+        bounds_max(kVec3fZeros),
+        mapped_vertices(nullptr),
+        mapped_indices(nullptr) {}
 
   Mesh(vector<vertex_ptn> vertices)
       : vertices(vertices),
         indices(),
         vertex_count(uint(vertices.size())),
-        index_count(vertex_count) {
+        index_count(vertex_count),
+        vertex_format(kVertexFormatPtn),
+        position_offset(kVec3fZeros),
+        position_scale(1.0f),
+        bounds_min(kVec3fZeros),
+        bounds_max(kVec3fZeros),
+        mapped_vertices(nullptr),
+        mapped_indices(nullptr) {
     for (uint i = 0; i < index_count; i++)
       indices.push_back(i);
+    ComputeBounds();
+  }
+
+  Mesh(vector<vertex_ptn> vertices, vector<uint> indices)
+      : vertices(vertices),
+        vertex_count(uint(vertices.size())),
+        indices(indices),
+        index_count(uint(indices.size())),
+        vertex_format(kVertexFormatPtn),
+        position_offset(kVec3fZeros),
+        position_scale(1.0f),
+        bounds_min(kVec3fZeros),
+        bounds_max(kVec3fZeros),
+        mapped_vertices(nullptr),
+        mapped_indices(nullptr) {
+    ComputeBounds();
   }
 
   Mesh(const Mesh& other)
       : vertices(other.vertices),
         vertex_count(other.vertex_count),
         indices(other.indices),
-        index_count(other.index_count) {}
+        index_count(other.index_count),
+        vertex_format(other.vertex_format),
+        packed_vertices(other.packed_vertices),
+        position_offset(other.position_offset),
+        position_scale(other.position_scale),
+        subsets(other.subsets),
+        bounds_min(other.bounds_min),
+        bounds_max(other.bounds_max),
+        mapping(other.mapping),
+        mapped_vertices(other.mapped_vertices),
+        mapped_indices(other.mapped_indices) {}
+
+  Mesh& operator=(const Mesh& other) = default;
+
+  // Hot reload swaps freshly loaded contents in without copying them
+  Mesh(Mesh&& other) = default;
+  Mesh& operator=(Mesh&& other) = default;
+
+  bool IsMapped() const {
+    return mapping != nullptr;
+  }
+
+  const void* GetVertexData() const {
+    if (mapped_vertices) {
+      return mapped_vertices;
+    }
+    if (vertex_format == kVertexFormatPtnPacked) {
+      return packed_vertices.data();
+    }
+    return vertices.data();
+  }
+
+  uint GetVertexStride() const {
+    if (vertex_format == kVertexFormatPtnPacked) {
+      return sizeof(vertex_ptn_packed);
+    }
+    return sizeof(vertex_ptn);
+  }
+
+  const uint* GetIndexData() const {
+    if (mapped_indices) {
+      return mapped_indices;
+    }
+    return indices.data();
+  }
+
+  // Fits the bounds to the unpacked vertices
+  void ComputeBounds() {
+    if (vertices.empty()) return;
+
+    bounds_min = vertices[0].position;
+    bounds_max = vertices[0].position;
+    for (const auto& vertex : vertices) {
+      bounds_min = vec3f::Min(bounds_min, vertex.position);
+      bounds_max = vec3f::Max(bounds_max, vertex.position);
+    }
+  }
+
+  // Maps packed snorm positions back to object space. Scale is uniform so
+  // normals stay correct after being transformed by the world matrix.
+  float4x4 GetDequantizationMatrix() const {
+    return float4x4::FromTranslationVector(position_offset) *
+           float4x4::FromScaleVector(float3(position_scale));
+  }
 
  public:
   vector<vertex_ptn> vertices;
@@ -73,6 +167,23 @@ struct Mesh {
 
   vector<uint> indices;
   uint index_count;
+
+  // Only used when vertex_format is kVertexFormatPtnPacked,
+  // see VertexPacker
+  VertexFormat vertex_format;
+  vector<vertex_ptn_packed> packed_vertices;
+  float3 position_offset;
+  float position_scale;
+
+  vector<MeshSubset> subsets;
+  float3 bounds_min;
+  float3 bounds_max;
+
+  // Set for meshes loaded from .vmesh files, vertex and index data point
+  // into the file data instead of the vectors above, see VMesh
+  sptr<FileData> mapping;
+  const byte* mapped_vertices;
+  const uint* mapped_indices;
 };
 }  // namespace voodoo
 
@@ -30,7 +30,11 @@ class MeshManager : public AssetManager<Mesh> {
   }
 
  private:
-  virtual sptr<Mesh> Load(const string& filename) override;
+  virtual sptr<Mesh> Load(const string& filename,
+                          sptr<FileData> file) override;
+  virtual size_t GetAssetSize(const Mesh& mesh) const override;
+
+  sptr<Mesh> LoadText(const string& filename, const FileData& file);
 };
 }  // namespace voodoo
 
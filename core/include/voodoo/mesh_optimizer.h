@@ -0,0 +1,57 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_MESH_OPTIMIZER_H_
+#define VOODOO_MESH_OPTIMIZER_H_
+
+#include "mesh.h"
+
+namespace voodoo {
+struct VertexCacheStats {
+  VertexCacheStats() : acmr(0), atvr(0) {}
+
+  // Average cache miss ratio: transformed vertices per triangle
+  float acmr;
+  // Average transformed vertex ratio: transformed vertices per vertex
+  float atvr;
+};
+
+// Triangle and vertex reordering for indexed triangle list meshes.
+// Every pass keeps the mesh renderable on its own, so they can be used
+// separately, but Optimize() runs them in the intended order. Meshes
+// should be optimised before VertexPacker::Pack, memory-mapped meshes
+// are left untouched.
+class MeshOptimizer final {
+ public:
+  static constexpr uint kCacheSize = 16;
+
+  static VertexCacheStats AnalyzeVertexCache(const Mesh& mesh,
+                                             uint cache_size = kCacheSize);
+
+  static void Optimize(Mesh& mesh);
+
+  // Forsyth's linear-speed vertex cache optimisation
+  static void OptimizeVertexCache(Mesh& mesh);
+
+  // Splits cache-optimised triangle order into clusters and sorts them
+  // front to back from outside the mesh, keeping ACMR within threshold
+  static void OptimizeOverdraw(Mesh& mesh, float threshold = 1.05f);
+
+  // Renumbers vertices in the order they are first referenced
+  static void OptimizeVertexFetch(Mesh& mesh);
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_MESH_OPTIMIZER_H_
@@ -0,0 +1,70 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_MIP_GENERATOR_H_
+#define VOODOO_MIP_GENERATOR_H_
+
+#include "image.h"
+#include "std_mappings.h"
+
+namespace voodoo {
+enum MipFilter {
+  kMipFilterBox = 0,
+  // Kaiser windowed sinc, keeps detail that the box filter blurs away
+  kMipFilterKaiser = 1,
+};
+
+struct MipOptions {
+  MipOptions()
+      : filter(kMipFilterKaiser),
+        srgb(true),
+        coverage_channel(-1),
+        coverage_cutoff(0.5f) {}
+
+  MipFilter filter;
+
+  // The first three channels hold sRGB encoded color and are filtered in
+  // linear space. Data textures and masks should turn this off. Single
+  // and dual channel images are always filtered as stored.
+  bool srgb;
+
+  // Channel whose alpha test coverage at the cutoff is kept equal to that
+  // of the full resolution level, so that cutout textures do not fade or
+  // thin out in the distance. Negative for none.
+  int coverage_channel;
+  float coverage_cutoff;
+};
+
+struct MipStats {
+  ullong images, pixels;
+  double time;
+};
+
+// Builds mip chains on the CPU. Rows of each level are filtered in
+// parallel on the shared thread pool.
+class MipGenerator final {
+ public:
+  // Replaces image.mips with every level below the full resolution one,
+  // down to 1x1
+  static void Generate(Image& image, const MipOptions& options = MipOptions());
+
+  static uint GetLevelCount(int width, int height);
+
+  // Totals of every Generate() call, pixels count the generated levels
+  static MipStats GetStats();
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_MIP_GENERATOR_H_
@@ -0,0 +1,75 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_NAME_ID_H_
+#define VOODOO_NAME_ID_H_
+
+#include "hash.h"
+#include "std_mappings.h"
+
+namespace voodoo {
+// 64-bit FNV-1a hash of a name, so that names compare and hash as
+// integers. Ids of literals are computed at compile time, e.g.
+//   constexpr NameId kCamera = "Camera"_id;
+// Hashing alone does not record the string, Intern() does, for GetString()
+// to find it again when debugging. Interning two names of the same hash
+// is reported as an error.
+class NameId final {
+ public:
+  constexpr NameId() : value_(Hash(std::string_view())) {}
+  constexpr NameId(const char* name) : value_(Hash(name)) {}
+  constexpr NameId(std::string_view name) : value_(Hash(name)) {}
+  NameId(const string& name) : value_(Hash(name)) {}
+
+  static NameId Intern(std::string_view name);
+
+  // The interned string, empty for names never interned
+  const string& GetString() const;
+
+  constexpr ullong GetValue() const { return value_; }
+
+  constexpr bool operator==(NameId other) const {
+    return value_ == other.value_;
+  }
+
+  constexpr bool operator!=(NameId other) const {
+    return value_ != other.value_;
+  }
+
+  constexpr bool operator<(NameId other) const {
+    return value_ < other.value_;
+  }
+
+  static constexpr ullong Hash(std::string_view name) { return Fnv1a(name); }
+
+ private:
+  ullong value_;
+};
+
+constexpr NameId operator""_id(const char* name, size_t length) {
+  return NameId(std::string_view(name, length));
+}
+}  // namespace voodoo
+
+namespace std {
+template <>
+struct hash<voodoo::NameId> {
+  size_t operator()(voodoo::NameId id) const {
+    return static_cast<size_t>(id.GetValue());
+  }
+};
+}  // namespace std
+
+#endif  // VOODOO_NAME_ID_H_
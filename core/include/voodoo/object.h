@@ -16,6 +16,7 @@
 #ifndef VOODOO_OBJECT_H_
 #define VOODOO_OBJECT_H_
 
+#include "name_id.h"
 #include "std_mappings.h"
 
 namespace voodoo {
@@ -27,14 +28,17 @@ class Object : public enable_shared_from_this<Object> {
   virtual ~Object() = default;
 
   uint GetInstanceId() const;
-  string GetName() const;
+
+  // Interned, the reference stays valid
+  const string& GetName() const;
+  NameId GetNameId() const;
 
  private:
   static uint GenerateInstanceId();
 
  protected:
   uint instance_id_;
-  string name_;
+  NameId name_;
 };
 }  // namespace voodoo
 
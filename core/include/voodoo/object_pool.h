@@ -0,0 +1,159 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_OBJECT_POOL_H_
+#define VOODOO_OBJECT_POOL_H_
+
+#include "std_mappings.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace voodoo {
+// Fixed size slots carved from slabs of contiguous memory. Allocation and
+// release are O(1), released slots are reused before new ones. The slabs
+// are freed together when the pool is. Not thread safe.
+class ObjectPool final {
+ public:
+  static constexpr size_t kSlabSize = 64 * 1024;
+
+  ObjectPool(size_t size, size_t alignment);
+  ~ObjectPool();
+
+  // No copy
+  ObjectPool(const ObjectPool& other) = delete;
+  ObjectPool& operator=(const ObjectPool& other) = delete;
+
+  void* Allocate();
+  void Free(void* pointer);
+
+  size_t GetSlotSize() const;
+  size_t GetLiveCount() const;
+  size_t GetSlabCount() const;
+  size_t GetReservedBytes() const;
+
+ private:
+  struct FreeSlot {
+    FreeSlot* next;
+  };
+
+  size_t slot_size_;
+  size_t alignment_;
+  size_t slab_slots_;
+  vector<void*> slabs_;
+
+  // Released slots, then those of the newest slab never handed out
+  FreeSlot* free_;
+  byte* next_;
+  byte* end_;
+
+  size_t live_;
+};
+
+struct ObjectArenaStats {
+  size_t objects;
+  size_t slabs;
+
+  // Of the slabs, used or not
+  size_t bytes;
+};
+
+// A pool per allocated type. Scenes own one for their game objects and
+// components, others come from the global one. Objects keep their arena
+// alive through their allocator, so its memory is released in bulk once
+// the last of them is.
+class ObjectArena final {
+ public:
+  static const sptr<ObjectArena>& GetGlobal();
+
+  ObjectArena() = default;
+
+  // No copy
+  ObjectArena(const ObjectArena& other) = delete;
+  ObjectArena& operator=(const ObjectArena& other) = delete;
+
+  template <class T>
+  void* Allocate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return GetPool<T>().Allocate();
+  }
+
+  template <class T>
+  void Free(void* pointer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    GetPool<T>().Free(pointer);
+  }
+
+  ObjectArenaStats GetStats() const;
+
+ private:
+  template <class T>
+  ObjectPool& GetPool() {
+    static const size_t index = next_pool_index_++;
+    if (index >= pools_.size()) pools_.resize(index + 1);
+    if (!pools_[index])
+      pools_[index] = std::make_unique<ObjectPool>(sizeof(T), alignof(T));
+    return *pools_[index];
+  }
+
+ private:
+  // Types are numbered on first use, the same in every arena
+  static std::atomic<size_t> next_pool_index_;
+
+  mutable std::mutex mutex_;
+  vector<uptr<ObjectPool>> pools_;
+};
+
+// Takes single objects from an ObjectArena, for std::allocate_shared which
+// then places the object and its control block in one pooled slot
+template <class T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  explicit PoolAllocator(const sptr<ObjectArena>& arena) : arena_(arena) {}
+
+  template <class U>
+  PoolAllocator(const PoolAllocator<U>& other) : arena_(other.arena_) {}
+
+  T* allocate(size_t count) {
+    if (count != 1) return std::allocator<T>().allocate(count);
+    return static_cast<T*>(arena_->Allocate<T>());
+  }
+
+  void deallocate(T* pointer, size_t count) {
+    if (count != 1) return std::allocator<T>().deallocate(pointer, count);
+    arena_->Free<T>(pointer);
+  }
+
+  template <class U>
+  bool operator==(const PoolAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+
+  template <class U>
+  bool operator!=(const PoolAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+
+ private:
+  template <class U>
+  friend class PoolAllocator;
+
+  sptr<ObjectArena> arena_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_OBJECT_POOL_H_
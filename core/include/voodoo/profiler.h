@@ -0,0 +1,157 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_PROFILER_H_
+#define VOODOO_PROFILER_H_
+
+#include "std_mappings.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+// Times the rest of the enclosing scope as a zone named by a string literal,
+// nested zones make up a hierarchy per thread. Defining
+// VOODOO_PROFILE_DISABLED compiles the zones out, otherwise they cost a
+// flag check while the profiler is disabled at run time.
+#ifndef VOODOO_PROFILE_DISABLED
+#define VOODOO_PROFILE_CONCAT_(a, b) a##b
+#define VOODOO_PROFILE_CONCAT(a, b) VOODOO_PROFILE_CONCAT_(a, b)
+#define VOODOO_PROFILE_SCOPE(name) \
+  ::voodoo::ProfileScope VOODOO_PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+#define VOODOO_PROFILE_SCOPE(name) \
+  do {                             \
+  } while (false)
+#endif
+
+namespace voodoo {
+// Per frame times of a zone over the recent frames, in milliseconds. A zone
+// entered several times in a frame counts with its total time.
+struct ProfileZoneStats {
+  string name;
+
+  // Shallowest nesting the zone was seen at, zero for outermost zones
+  uint depth;
+
+  double calls;
+  float min, avg, max, p99;
+};
+
+class ProfileScope final {
+ public:
+  explicit ProfileScope(const char* name);
+  ~ProfileScope();
+
+  // No copy
+  ProfileScope(const ProfileScope& other) = delete;
+  ProfileScope& operator=(const ProfileScope& other) = delete;
+
+ private:
+  const char* name_;
+  ullong begin_;
+  uint depth_;
+};
+
+class Profiler final {
+ public:
+  // Frames kept for the statistics
+  static constexpr uint kFrameHistory = 240;
+
+  // Zones kept by a capture before it stops recording, reserved up front
+  // so that capturing doesn't allocate during frames
+  static constexpr size_t kMaxCaptureZones = 1 << 18;
+
+  ~Profiler();
+
+  static Profiler& Get();
+
+  static bool IsEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  static void SetEnabled(bool enabled);
+
+  // Collects the zones of every thread and closes the frame, called by the
+  // engine on the main thread
+  void EndFrame();
+
+  // Keeps the zones from now until frame_count frames have ended, and
+  // EndCapture() writes them as a Chrome trace (chrome://tracing or
+  // ui.perfetto.dev). Called on the EndFrame() thread.
+  void BeginCapture(uint frame_count);
+  bool EndCapture(const string& filename);
+
+  // Ordered by when the zones were first entered, so children follow their
+  // parents
+  vector<ProfileZoneStats> GetZoneStats() const;
+
+  // Writes the zone statistics to the log
+  void Dump() const;
+
+  // Zones lost to full thread buffers
+  ullong GetDroppedCount() const;
+
+ private:
+  friend ProfileScope;
+
+  struct Zone {
+    const char* name;
+    ullong begin, end;
+    uint depth;
+    uint thread;
+  };
+
+  // Written by its thread alone and read by EndFrame()
+  struct ThreadBuffer;
+
+  struct ZoneHistory {
+    string name;
+    uint depth;
+    ullong first_begin;
+    float times[kFrameHistory];
+    uint calls[kFrameHistory];
+  };
+
+  Profiler();
+
+  static ullong Now();
+  static ThreadBuffer& GetThreadBuffer();
+
+  void Add(const Zone& zone, uint slot);
+
+ private:
+  static std::atomic<bool> enabled_;
+
+  std::mutex threads_mutex_;
+  vector<sptr<ThreadBuffer>> threads_;
+  uint thread_count_;
+
+  // Only used by the thread calling EndFrame()
+  vector<ZoneHistory> zones_;
+  unordered_map<const char*, size_t> zone_indices_;
+  uint frame_;
+
+  bool capturing_;
+  uint capture_end_frame_;
+  ullong capture_begin_;
+  vector<Zone> capture_;
+
+  mutable std::mutex stats_mutex_;
+  std::atomic<ullong> dropped_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_PROFILER_H_
@@ -17,6 +17,8 @@
 #define VOODOO_SCENE_H_
 
 #include "color.h"
+#include "name_id.h"
+#include "object_pool.h"
 
 namespace voodoo {
 class GameObject;
@@ -24,6 +26,8 @@ class Camera;
 
 class Scene final : public enable_shared_from_this<Scene> {
  public:
+  using GameObjectMap = flat_hash_map<NameId, sptr<GameObject>>;
+
   Scene();
 
   sptr<Camera> GetCamera();
@@ -33,9 +37,17 @@ class Scene final : public enable_shared_from_this<Scene> {
 
   sptr<GameObject> AddGameObject(sptr<GameObject> game_object);
   sptr<GameObject> AddGameObject(const string& name);
-  sptr<GameObject> GetGameObject(const string& name);
+  sptr<GameObject> GetGameObject(NameId name);
+
+  // A view, copy it to add or remove game objects while iterating
+  map_values<GameObjectMap> GetGameObjects() const;
+
+  // Game objects and their components are allocated from here
+  const sptr<ObjectArena>& GetArena() const;
 
-  vector<sptr<GameObject>> GetGameObjects() const;
+  // Releases the game objects and the camera. Game objects, components and
+  // the scene reference each other, so nothing is freed without this.
+  void Unload();
 
  private:
   sptr<GameObject> InsertGameObject(sptr<GameObject> game_object);
@@ -43,7 +55,8 @@ class Scene final : public enable_shared_from_this<Scene> {
  private:
   color clear_color_;
   sptr<Camera> camera_;
-  map<string, sptr<GameObject>> game_objects_;
+  GameObjectMap game_objects_;
+  sptr<ObjectArena> arena_;
 };
 }  // namespace voodoo
 
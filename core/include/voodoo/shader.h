@@ -18,10 +18,23 @@
 
 #include "color.h"
 #include "directx.h"
+#include "vertex.h"
 
 namespace voodoo {
 struct ShaderBuffer {
   ShaderBuffer(const uint& size) : data(new byte[size]), size(size) {}
+  ~ShaderBuffer() { delete[] data; }
+
+  // No copy
+  ShaderBuffer(const ShaderBuffer& other) = delete;
+  ShaderBuffer& operator=(const ShaderBuffer& other) = delete;
+
+  // Used by hot reload to replace contents in place
+  ShaderBuffer& operator=(ShaderBuffer&& other) noexcept {
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    return *this;
+  }
 
   byte* data;
   uint size;
@@ -50,14 +63,29 @@ class Shader {
   Shader(sptr<ID3D11Device> device, sptr<ID3D11DeviceContext> device_context);
   ~Shader();
 
-  bool Init(const string& vs_path, const string& ps_path, bool light);
+  bool Init(const string& vs_path, const string& ps_path, bool light,
+            VertexFormat vertex_format = kVertexFormatPtn);
+
+  // Sets the shaders, sampler and constant buffers. Draws that follow with
+  // the same shader only need Update(), and SetTexture() when the texture
+  // changes.
+  bool Bind();
   bool Update(const float4x4& world_matrix,
               const float4x4& view_matrix,
-              const float4x4& projection_matrix,
-              ID3D11ShaderResourceView* texture);
+              const float4x4& projection_matrix);
+  void SetTexture(ID3D11ShaderResourceView* texture);
+
+  // Builds the shader again from the same files and settings, and only
+  // replaces the current objects when everything was created
+  bool Reload();
+
+  const string& GetVSPath() const;
+  const string& GetPSPath() const;
 
  private:
-  bool CreateInputLayout(sptr<ShaderBuffer> buffer);
+  void Release();
+
+  bool CreateInputLayout(sptr<ShaderBuffer> buffer, VertexFormat vertex_format);
   bool CreateMatrixBuffer();
   bool CreateLightBuffer();
   bool CreateSamplerState();
@@ -75,7 +103,10 @@ class Shader {
   ID3D11Buffer* light_buffer_;
   ID3D11Buffer* pixel_buffer_;
 
+  string vs_path_;
+  string ps_path_;
   bool light_;
+  VertexFormat vertex_format_;
 };
 }  // namespace voodoo
 
@@ -30,7 +30,9 @@ public:
   }
 
 private:
-  virtual sptr<ShaderBuffer> Load(const string& filename) override;
+  virtual sptr<ShaderBuffer> Load(const string& filename,
+                                  sptr<FileData> file) override;
+  virtual size_t GetAssetSize(const ShaderBuffer& buffer) const override;
 };
 }
 
@@ -16,16 +16,35 @@
 #ifndef VOODOO_STD_MAPPINGS_H_
 #define VOODOO_STD_MAPPINGS_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VOODOO_FLAT_HASH_SSE
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace voodoo {
 // Fundamentals
 typedef __int64 int64;
+typedef short int16;
+typedef unsigned short uint16;
 typedef unsigned int uint;
 typedef unsigned long ulong;
 typedef long long llong;
@@ -61,6 +80,308 @@ using multimap = std::multimap<Key_T, Value_T>;
 template <class Key_T, class Value_T>
 using unordered_map = std::unordered_map<Key_T, Value_T>;
 
+// Iterates the values of a map in place, for handing out a container's
+// contents without copying them
+template <class Map_T>
+class map_values {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename Map_T::mapped_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    iterator() = default;
+    explicit iterator(typename Map_T::const_iterator it) : it_(it) {}
+
+    reference operator*() const { return it_->second; }
+    pointer operator->() const { return &it_->second; }
+
+    iterator& operator++() {
+      ++it_;
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator previous = *this;
+      ++it_;
+      return previous;
+    }
+
+    bool operator==(const iterator& other) const { return it_ == other.it_; }
+    bool operator!=(const iterator& other) const { return it_ != other.it_; }
+
+   private:
+    typename Map_T::const_iterator it_;
+  };
+
+  explicit map_values(const Map_T& map) : map_(&map) {}
+
+  iterator begin() const { return iterator(map_->begin()); }
+  iterator end() const { return iterator(map_->end()); }
+  size_t size() const { return map_->size(); }
+  bool empty() const { return map_->empty(); }
+
+ private:
+  const Map_T* map_;
+};
+
+// Hash of flat_hash_map. Strings hash as string_view, so lookups take
+// either, or a literal, without building a string.
+template <class Key_T>
+struct flat_hash : std::hash<Key_T> {};
+
+template <>
+struct flat_hash<std::string> {
+  using is_transparent = void;
+
+  size_t operator()(std::string_view key) const {
+    return std::hash<std::string_view>()(key);
+  }
+};
+
+// Open addressing hash map. Entries are stored contiguously in insertion
+// order and the table keeps their index. Each table slot has a control
+// byte, empty, deleted or 7 bits of the key's hash, and a lookup compares
+// the control bytes of 16 slots at once before comparing any key.
+// Iteration is in insertion order until an erase, which moves the last
+// entry into the gap. Unlike std::map, inserting and erasing invalidate
+// iterators and references to entries, and keys are not const.
+template <class Key_T, class Value_T, class Hash_T = flat_hash<Key_T>,
+          class Equal_T = std::equal_to<>>
+class flat_hash_map {
+ public:
+  using key_type = Key_T;
+  using mapped_type = Value_T;
+  using value_type = std::pair<Key_T, Value_T>;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  flat_hash_map() = default;
+
+  flat_hash_map(std::initializer_list<value_type> values) {
+    reserve(values.size());
+    for (const auto& value : values) insert(value);
+  }
+
+  iterator begin() { return entries_.begin(); }
+  iterator end() { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+
+  size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  void clear() {
+    entries_.clear();
+    slots_.clear();
+    control_.clear();
+    group_mask_ = 0;
+    tombstones_ = 0;
+  }
+
+  void reserve(size_t count) {
+    entries_.reserve(count);
+    if (count > GetMaxLoad()) Rehash(count);
+  }
+
+  template <class K>
+  iterator find(const K& key) {
+    size_t slot = FindSlot(key, Hash(key));
+    return slot == kNone ? end() : begin() + slots_[slot];
+  }
+
+  template <class K>
+  const_iterator find(const K& key) const {
+    size_t slot = FindSlot(key, Hash(key));
+    return slot == kNone ? end() : begin() + slots_[slot];
+  }
+
+  template <class K>
+  size_t count(const K& key) const {
+    return FindSlot(key, Hash(key)) == kNone ? 0 : 1;
+  }
+
+  template <class K, class... Types>
+  std::pair<iterator, bool> try_emplace(K&& key, Types&&... args) {
+    size_t hash = Hash(key);
+    size_t slot = FindSlot(key, hash);
+    if (slot != kNone) return {begin() + slots_[slot], false};
+
+    if (entries_.size() + tombstones_ + 1 > GetMaxLoad())
+      Rehash(std::max<size_t>(entries_.size() * 2, kGroupSize));
+
+    entries_.emplace_back(std::piecewise_construct,
+                          std::forward_as_tuple(std::forward<K>(key)),
+                          std::forward_as_tuple(std::forward<Types>(args)...));
+    Place(hash, static_cast<uint32_t>(entries_.size() - 1));
+    return {end() - 1, true};
+  }
+
+  template <class K, class V>
+  std::pair<iterator, bool> emplace(K&& key, V&& value) {
+    return try_emplace(std::forward<K>(key), std::forward<V>(value));
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return try_emplace(std::move(value.first), std::move(value.second));
+  }
+
+  template <class K>
+  Value_T& operator[](K&& key) {
+    return try_emplace(std::forward<K>(key)).first->second;
+  }
+
+  // Returns the iterator to the entry moved into the erased one's place
+  iterator erase(const_iterator position) {
+    size_t index = position - entries_.cbegin();
+    EraseSlot(FindSlot(position->first, Hash(position->first)));
+    return begin() + index;
+  }
+
+  iterator erase(iterator position) {
+    return erase(const_iterator(position));
+  }
+
+  template <class K>
+  size_t erase(const K& key) {
+    size_t slot = FindSlot(key, Hash(key));
+    if (slot == kNone) return 0;
+    EraseSlot(slot);
+    return 1;
+  }
+
+ private:
+  static constexpr size_t kGroupSize = 16;
+  static constexpr size_t kNone = ~size_t(0);
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+
+  // Mixed as the standard hashes of integers and pointers may be the
+  // identity, whose low bits alone would pick the slots and control bytes
+  template <class K>
+  static size_t Hash(const K& key) {
+    uint64_t hash = uint64_t(Hash_T()(key)) * 0x9e3779b97f4a7c15ull;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+  }
+
+  // Bit i is set where control byte i of the group equals value
+  static uint32_t Match(const int8_t* group, int8_t value) {
+#ifdef VOODOO_FLAT_HASH_SSE
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(value))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupSize; i++)
+      mask |= uint32_t(group[i] == value) << i;
+    return mask;
+#endif
+  }
+
+  // Empty and deleted slots, the only ones with the sign bit set
+  static uint32_t MatchFree(const int8_t* group) {
+#ifdef VOODOO_FLAT_HASH_SSE
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupSize; i++)
+      mask |= uint32_t(group[i] < 0) << i;
+    return mask;
+#endif
+  }
+
+  static uint32_t LowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+  }
+
+  size_t GetMaxLoad() const { return control_.size() / 8 * 7; }
+
+  // Groups are probed in triangular steps, which visit all of them as
+  // their count is a power of two
+  template <class K>
+  size_t FindSlot(const K& key, size_t hash) const {
+    if (control_.empty()) return kNone;
+
+    int8_t h2 = static_cast<int8_t>(hash & 0x7f);
+    size_t group = (hash >> 7) & group_mask_;
+    for (size_t step = 1;; step++) {
+      size_t first = group * kGroupSize;
+      const int8_t* control = control_.data() + first;
+      for (uint32_t mask = Match(control, h2); mask; mask &= mask - 1) {
+        size_t slot = first + LowestBit(mask);
+        if (Equal_T()(entries_[slots_[slot]].first, key)) return slot;
+      }
+      if (Match(control, kEmpty)) return kNone;
+      group = (group + step) & group_mask_;
+    }
+  }
+
+  void Place(size_t hash, uint32_t index) {
+    size_t group = (hash >> 7) & group_mask_;
+    for (size_t step = 1;; step++) {
+      size_t first = group * kGroupSize;
+      uint32_t mask = MatchFree(control_.data() + first);
+      if (mask) {
+        size_t slot = first + LowestBit(mask);
+        if (control_[slot] == kDeleted) tombstones_--;
+        control_[slot] = static_cast<int8_t>(hash & 0x7f);
+        slots_[slot] = index;
+        return;
+      }
+      group = (group + step) & group_mask_;
+    }
+  }
+
+  void EraseSlot(size_t slot) {
+    size_t index = slots_[slot];
+    control_[slot] = kDeleted;
+    tombstones_++;
+
+    size_t last = entries_.size() - 1;
+    if (index != last) {
+      size_t last_slot =
+          FindSlot(entries_[last].first, Hash(entries_[last].first));
+      entries_[index] = std::move(entries_[last]);
+      slots_[last_slot] = static_cast<uint32_t>(index);
+    }
+    entries_.pop_back();
+  }
+
+  // Sizes the table for count entries and places every entry again
+  void Rehash(size_t count) {
+    size_t groups = 1;
+    while (groups * kGroupSize / 8 * 7 < count) groups *= 2;
+
+    control_.assign(groups * kGroupSize, kEmpty);
+    slots_.assign(groups * kGroupSize, 0);
+    group_mask_ = groups - 1;
+    tombstones_ = 0;
+    for (size_t i = 0; i < entries_.size(); i++)
+      Place(Hash(entries_[i].first), static_cast<uint32_t>(i));
+  }
+
+ private:
+  std::vector<value_type> entries_;
+  std::vector<uint32_t> slots_;
+  std::vector<int8_t> control_;
+  size_t group_mask_ = 0;
+  size_t tombstones_ = 0;
+};
+
 // Smart pointers
 template <class T>
 using sptr = std::shared_ptr<T>;
@@ -27,9 +27,15 @@ struct Texture {
   Texture(std::shared_ptr<ID3D11Device> device, std::shared_ptr<Image> image);
   ~Texture();
 
+  // Replaces the GPU resources with ones created from the image
+  void Create(ID3D11Device* device, const Image& image);
+
  public:
   ID3D11Texture2D* texture;
   ID3D11ShaderResourceView* srv;
+
+  // Lets hot reload find the textures of a reloaded image
+  std::weak_ptr<Image> source;
 };
 }  // namespace voodoo
 
@@ -0,0 +1,53 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_TEXTURE_ATLAS_H_
+#define VOODOO_TEXTURE_ATLAS_H_
+
+#include "math.h"
+
+namespace voodoo {
+// Where a source texture ended up. Texture coordinates in [0, 1] of the
+// source map to offset + uv * scale on the page.
+struct AtlasRegion {
+  uint page;
+  float2 offset;
+  float2 scale;
+};
+
+// Manifest of textures packed into shared pages by the editor, so that
+// materials of different source textures bind the same page. Pages are
+// .vtex files and, like the textures, are named relative to the manifest.
+struct TextureAtlas {
+ public:
+  static constexpr uint kVersion = 1;
+
+  // Reads a .vatlas file through the file system
+  static sptr<TextureAtlas> Load(const string& filename);
+  bool Save(const string& filename) const;
+
+  // Null when the texture was not packed
+  const AtlasRegion* Find(const string& texture) const;
+
+  // Page paths as seen from the working directory
+  string GetPagePath(const string& filename, uint page) const;
+
+ public:
+  vector<string> pages;
+  map<string, AtlasRegion> regions;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_TEXTURE_ATLAS_H_
@@ -0,0 +1,128 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_TEXTURE_STREAMER_H_
+#define VOODOO_TEXTURE_STREAMER_H_
+
+#include "graphics_api.h"
+#include "io_queue.h"
+#include "scene.h"
+#include "texture.h"
+#include "vtex.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace voodoo {
+struct TextureStreamingStats {
+  uint textures;
+
+  // GPU memory of the streamed textures, zero budget is unlimited
+  ullong resident_bytes, budget;
+
+  // Reads in flight or waiting to be applied
+  uint pending;
+
+  // Uploaded in total, and per second over the last second
+  ullong streamed_bytes;
+  double bandwidth;
+
+  uint upgrades, evictions;
+};
+
+// Streams the mip levels of cooked .vtex textures. Textures start out with
+// only their low resolution tail resident. Every frame the level each one
+// needs is derived from the screen size of the renderers drawing it, and
+// finer levels are read and uploaded asynchronously, most visible first,
+// as long as the resident bytes stay within the budget. Levels no longer
+// needed are dropped again after a while.
+//
+// Reads go through the I/O queue and levels are copied from the file's
+// memory mapping on the thread pool, so only the pages of the levels read
+// are touched. The textures are recreated on the main thread, existing
+// references to them stay valid.
+class TextureStreamer final {
+ public:
+  explicit TextureStreamer(sptr<GraphicsAPI> graphics_api);
+  ~TextureStreamer();
+
+  // Creates the texture with its tail resident, throws like VTex::Load()
+  sptr<Texture> Load(const string& filename);
+
+  void SetBudget(ullong bytes);
+
+  // Requests and applies levels, called once per frame on the main thread
+  void Update(const sptr<Scene>& scene, int screen_height);
+
+  TextureStreamingStats GetStats() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Stream {
+    string filename;
+    std::weak_ptr<Texture> texture;
+    VTexHeader header;
+
+    // First level resident, of the tail and wanted by this frame
+    uint resident, tail, wanted;
+
+    // Screen pixels the texture covers at most, orders the requests
+    float pixels;
+
+    Clock::time_point last_needed;
+    bool pending, failed;
+    IoRequest request;
+
+    // Tells a texture from a later one at the same address
+    uint id;
+  };
+
+  struct Upload {
+    const Texture* texture;
+    uint id;
+    uint level;
+    sptr<Image> image;
+  };
+
+  void Request(Stream& stream, uint level, IoPriority priority);
+  void Apply(Upload& upload);
+
+  ullong GetBytes(const Stream& stream, uint level) const;
+  static float GetRadius(const Mesh& mesh);
+
+ private:
+  sptr<GraphicsAPI> graphics_api_;
+  ullong budget_;
+  uint next_id_;
+
+  map<const Texture*, Stream> streams_;
+
+  // Shared with the loads in flight
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  vector<Upload> uploads_;
+  uint in_flight_;
+
+  ullong streamed_bytes_;
+  uint upgrades_, evictions_;
+  Clock::time_point window_start_;
+  ullong window_bytes_;
+  double bandwidth_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_TEXTURE_STREAMER_H_
@@ -0,0 +1,77 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_THREAD_POOL_H_
+#define VOODOO_THREAD_POOL_H_
+
+#include "std_mappings.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace voodoo {
+// Fixed set of worker threads executing tasks in submission order
+class ThreadPool final {
+ public:
+  // Zero thread count leaves one hardware thread for the main loop
+  explicit ThreadPool(uint thread_count = 0);
+  ~ThreadPool();
+
+  // No copy
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  // Temporal singleton shared by asset loading
+  static ThreadPool& Get() {
+    static ThreadPool instance;
+    return instance;
+  }
+
+  template <class F>
+  std::future<std::invoke_result_t<F>> Submit(F&& task) {
+    using Result = std::invoke_result_t<F>;
+    auto packaged =
+        std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+    auto future = packaged->get_future();
+    Enqueue([packaged]() { (*packaged)(); });
+    return future;
+  }
+
+  // Runs task(i) for every i below count and returns when all are done.
+  // The calling thread takes part, so this may be used from inside a task
+  // without waiting on workers that are busy. Tasks must not throw.
+  void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+  uint GetThreadCount() const;
+
+ private:
+  void Enqueue(std::function<void()> task);
+  void Work();
+
+ private:
+  vector<std::thread> threads_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopping_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_THREAD_POOL_H_
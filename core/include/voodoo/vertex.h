@@ -19,6 +19,11 @@
 #include "math.h"
 
 namespace voodoo {
+enum VertexFormat {
+  kVertexFormatPtn = 0,
+  kVertexFormatPtnPacked = 1,
+};
+
 // Potition
 struct vertex_p {
   vertex_p() = default;
@@ -121,6 +126,15 @@ struct vertex_pctnt : public vertex_pctn {
 
   float4 tangent;
 };
+
+// Packed position, texture, normal (16 bytes instead of 32).
+// Position is snorm16 relative to per-mesh bounds with unused w, texture is
+// a pair of half floats and normal is octahedral-encoded snorm16.
+struct vertex_ptn_packed {
+  int16 position[4];
+  uint16 texture[2];
+  int16 normal[2];
+};
 }  // namespace voodoo
 
 #endif
\ No newline at end of file
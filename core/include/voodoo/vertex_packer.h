@@ -0,0 +1,66 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_VERTEX_PACKER_H_
+#define VOODOO_VERTEX_PACKER_H_
+
+#include "mesh.h"
+
+namespace voodoo {
+uint16 float_to_half(float value);
+float half_to_float(uint16 value);
+
+// Octahedral normal encoding, components are snorm of the given bit depth
+vec2i oct_encode(const vec3f& normal, int bits);
+vec3f oct_decode(const vec2i& encoded, int bits);
+
+struct VertexPackingStats {
+  VertexPackingStats()
+      : source_bytes(0),
+        packed_bytes(0),
+        max_position_error(0),
+        max_texture_error(0),
+        max_normal_error(0),
+        max_normal_error_8bit(0) {}
+
+  uint source_bytes;
+  uint packed_bytes;
+
+  // Object space units
+  float max_position_error;
+  // Texture coordinate units
+  float max_texture_error;
+  // Degrees, for 2x16 and 2x8 bit octahedral normals
+  float max_normal_error;
+  float max_normal_error_8bit;
+};
+
+class VertexPacker final {
+ public:
+  // Converts mesh vertices to vertex_ptn_packed and releases the
+  // full precision copy
+  static void Pack(Mesh& mesh);
+
+  // Measures memory and precision of packing without modifying the mesh
+  static VertexPackingStats Analyze(const Mesh& mesh);
+
+ private:
+  static void CalculateQuantization(const Mesh& mesh, float3& offset, float& scale);
+  static vertex_ptn_packed PackVertex(const vertex_ptn& vertex,
+                                      const float3& offset, const float& scale);
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_VERTEX_PACKER_H_
@@ -0,0 +1,61 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_VMESH_H_
+#define VOODOO_VMESH_H_
+
+#include "mesh.h"
+
+namespace voodoo {
+// Binary mesh file layout. Blocks are referenced by byte offsets from the
+// start of the file and aligned to VMesh::kAlignment, so vertex and index
+// data can be used straight from a memory mapping.
+struct VMeshHeader {
+  uint magic;
+  uint version;
+
+  uint vertex_format;
+  uint vertex_stride;
+  uint vertex_count;
+  uint index_count;
+  uint subset_count;
+  uint reserved;
+
+  float bounds_min[3];
+  float bounds_max[3];
+  float position_offset[3];
+  float position_scale;
+
+  uint vertex_offset;
+  uint index_offset;
+  uint subset_offset;
+  uint file_size;
+};
+
+class VMesh final {
+ public:
+  static constexpr uint kMagic = 0x48534d56;  // "VMSH"
+  static constexpr uint kVersion = 1;
+  static constexpr uint kAlignment = 16;
+
+  // Reads the file through the file system and hands out pointers into it
+  // without parsing or copying
+  static sptr<Mesh> Load(const string& filename);
+  static sptr<Mesh> Load(const string& filename, sptr<FileData> file);
+  static bool Save(const Mesh& mesh, const string& filename);
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_VMESH_H_
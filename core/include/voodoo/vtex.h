@@ -0,0 +1,64 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_VTEX_H_
+#define VOODOO_VTEX_H_
+
+#include "file_system.h"
+#include "image.h"
+
+namespace voodoo {
+// Cooked texture file layout. The header is followed by every mip level,
+// largest first, each aligned to VTex::kAlignment and laid out as the GPU
+// expects it, so levels are uploaded without conversion.
+struct VTexHeader {
+  uint magic;
+  uint version;
+
+  uint format;
+  uint width;
+  uint height;
+  uint channels;
+  uint level_count;
+  uint reserved;
+
+  ullong data_offset;
+  ullong file_size;
+};
+
+class VTex final {
+ public:
+  static constexpr uint kMagic = 0x58455456;  // "VTEX"
+  static constexpr uint kVersion = 1;
+  static constexpr uint kAlignment = 16;
+
+  static sptr<Image> Load(const string& filename);
+
+  // Levels above first_level are skipped, the image then starts at that
+  // level. Only the pages of the levels read are touched in a mapping.
+  static sptr<Image> Load(const string& filename, const FileData& file,
+                          uint first_level = 0);
+
+  // Validated header, throws like Load()
+  static VTexHeader ReadHeader(const string& filename, const FileData& file);
+
+  // Writes the image with its mips in their current format
+  static bool Save(const Image& image, const string& filename);
+
+  static size_t GetSize(const Image& image);
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_VTEX_H_
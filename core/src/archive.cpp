@@ -0,0 +1,312 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/archive.h"
+
+#include "../include/voodoo/hash.h"
+#include "../include/voodoo/logger.h"
+#include "../include/voodoo/lz.h"
+#include "../include/voodoo/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace voodoo {
+namespace {
+ullong align(ullong offset, ullong alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+Archive::Archive(const string& filename)
+    : filename_(filename),
+      mapping_(std::make_shared<MappedFile>(filename)),
+      chunks_(nullptr),
+      names_(nullptr),
+      chunk_size_(0) {
+  using namespace std;
+  const byte* data = mapping_->GetData();
+  size_t size = mapping_->GetSize();
+
+  ArchiveHeader header;
+  if (size < sizeof(header)) {
+    throw runtime_error("Invalid archive: \"" + filename + "\"");
+  }
+  memcpy(&header, data, sizeof(header));
+
+  if (header.magic != kMagic || header.version != kVersion) {
+    throw runtime_error("Unsupported archive: \"" + filename + "\"");
+  }
+
+  const runtime_error corrupted("Corrupted archive: \"" + filename + "\"");
+  ullong entry_end =
+      header.entry_offset + ullong(header.entry_count) * sizeof(ArchiveEntry);
+  ullong chunk_end =
+      header.chunk_offset + ullong(header.chunk_count) * sizeof(ArchiveChunk);
+  if (header.file_size != size || header.chunk_size == 0 ||
+      header.entry_offset % kAlignment != 0 ||
+      header.chunk_offset % kAlignment != 0 || entry_end > size ||
+      chunk_end > size || header.name_offset + header.name_size > size) {
+    throw corrupted;
+  }
+
+  entries_.resize(header.entry_count);
+  if (header.entry_count > 0) {
+    memcpy(entries_.data(), data + header.entry_offset,
+           sizeof(ArchiveEntry) * header.entry_count);
+  }
+  chunks_ = reinterpret_cast<const ArchiveChunk*>(data + header.chunk_offset);
+  names_ = reinterpret_cast<const char*>(data + header.name_offset);
+  chunk_size_ = header.chunk_size;
+
+  // Chunks of an entry are contiguous and all but the last are full, which
+  // Read() relies on
+  for (const auto& entry : entries_) {
+    if (ullong(entry.name_offset) + entry.name_size > header.name_size ||
+        ullong(entry.first_chunk) + entry.chunk_count > header.chunk_count) {
+      throw corrupted;
+    }
+
+    ullong total = 0, next_offset = 0;
+    for (uint i = 0; i < entry.chunk_count; i++) {
+      const ArchiveChunk& chunk = chunks_[entry.first_chunk + i];
+      bool last = i + 1 == entry.chunk_count;
+      if (chunk.offset + chunk.compressed_size > size ||
+          chunk.size > chunk_size_ || (!last && chunk.size != chunk_size_) ||
+          (i > 0 && chunk.offset != next_offset)) {
+        throw corrupted;
+      }
+      total += chunk.size;
+      next_offset = chunk.offset + chunk.compressed_size;
+    }
+
+    if (total != entry.size) throw corrupted;
+  }
+}
+
+const ArchiveEntry* Archive::Find(const string& name) const {
+  ullong hash = Fnv1a(name);
+  auto it = std::lower_bound(
+      entries_.begin(), entries_.end(), hash,
+      [](const ArchiveEntry& entry, ullong hash) { return entry.hash < hash; });
+
+  for (; it != entries_.end() && it->hash == hash; it++) {
+    if (it->name_size == name.size() &&
+        memcmp(names_ + it->name_offset, name.data(), name.size()) == 0) {
+      return &*it;
+    }
+  }
+
+  return nullptr;
+}
+
+string Archive::GetName(const ArchiveEntry& entry) const {
+  return string(names_ + entry.name_offset, entry.name_size);
+}
+
+const vector<ArchiveEntry>& Archive::GetEntries() const { return entries_; }
+
+sptr<FileData> Archive::Read(const ArchiveEntry& entry) const {
+  using namespace std;
+  const ArchiveChunk* chunks = chunks_ + entry.first_chunk;
+  const byte* data = mapping_->GetData();
+
+  bool stored = true;
+  for (uint i = 0; i < entry.chunk_count; i++)
+    stored = stored && chunks[i].compressed_size == chunks[i].size;
+
+  // Stored chunks are contiguous, so the entry is used in place
+  if (stored) {
+    const byte* begin = entry.chunk_count > 0 ? data + chunks[0].offset : data;
+    return make_shared<FileData>(mapping_, begin, size_t(entry.size));
+  }
+
+  vector<byte> buffer(size_t(entry.size));
+  atomic<bool> valid(true);
+  ThreadPool::Get().ParallelFor(entry.chunk_count, [&](size_t i) {
+    const ArchiveChunk& chunk = chunks[i];
+    byte* destination = buffer.data() + i * chunk_size_;
+    if (chunk.compressed_size == chunk.size) {
+      memcpy(destination, data + chunk.offset, chunk.size);
+    } else if (!Lz::Decompress(data + chunk.offset, chunk.compressed_size,
+                               destination, chunk.size)) {
+      valid = false;
+    }
+  });
+
+  if (!valid) {
+    throw runtime_error("Corrupted archive entry: \"" + GetName(entry) +
+                        "\" in \"" + filename_ + "\"");
+  }
+
+  return make_shared<FileData>(std::move(buffer));
+}
+
+bool Archive::Write(const string& filename,
+                    const vector<ArchiveSource>& sources,
+                    ArchiveStats* stats) {
+  using namespace std;
+
+  struct Item {
+    const ArchiveSource* source;
+    ullong hash;
+    sptr<MappedFile> file;
+  };
+
+  vector<Item> items;
+  for (const auto& source : sources) {
+    Item item;
+    item.source = &source;
+    item.hash = Fnv1a(source.name);
+    try {
+      item.file = make_shared<MappedFile>(source.path);
+    } catch (const exception& e) {
+      VOODOO_LOG_ERROR(kLogCategoryAssets, "{}", e.what());
+      return false;
+    }
+    items.push_back(item);
+  }
+
+  // Sorted by hash for binary search, names break ties
+  sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+    return a.hash != b.hash ? a.hash < b.hash
+                            : a.source->name < b.source->name;
+  });
+  for (size_t i = 1; i < items.size(); i++) {
+    if (items[i].source->name == items[i - 1].source->name) {
+      VOODOO_LOG_ERROR(kLogCategoryAssets, "Duplicate archive entry: \"{}\"",
+                       items[i].source->name);
+      return false;
+    }
+  }
+
+  struct Job {
+    size_t item;
+    size_t offset;
+    uint size;
+
+    // Empty when the chunk is stored
+    vector<byte> data;
+  };
+
+  vector<ArchiveEntry> entries(items.size());
+  vector<Job> jobs;
+  string names;
+  for (size_t i = 0; i < items.size(); i++) {
+    size_t size = items[i].file->GetSize();
+    ArchiveEntry& entry = entries[i];
+    entry.hash = items[i].hash;
+    entry.size = size;
+    entry.name_offset = static_cast<uint>(names.size());
+    entry.name_size = static_cast<uint>(items[i].source->name.size());
+    entry.first_chunk = static_cast<uint>(jobs.size());
+    entry.chunk_count = static_cast<uint>((size + kChunkSize - 1) / kChunkSize);
+    names += items[i].source->name;
+
+    for (size_t offset = 0; offset < size; offset += kChunkSize) {
+      Job job;
+      job.item = i;
+      job.offset = offset;
+      job.size = static_cast<uint>(min<size_t>(kChunkSize, size - offset));
+      jobs.push_back(move(job));
+    }
+  }
+
+  // Chunks that shrink by less than 1/16 are not worth decompressing
+  ThreadPool::Get().ParallelFor(jobs.size(), [&](size_t i) {
+    Job& job = jobs[i];
+    if (!items[job.item].source->compress) return;
+
+    vector<byte> data(Lz::GetBound(job.size));
+    size_t size = Lz::Compress(items[job.item].file->GetData() + job.offset,
+                               job.size, data.data());
+    if (size < job.size - job.size / 16) {
+      data.resize(size);
+      job.data.swap(data);
+    }
+  });
+
+  ArchiveHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.entry_count = static_cast<uint>(entries.size());
+  header.chunk_count = static_cast<uint>(jobs.size());
+  header.chunk_size = kChunkSize;
+  header.entry_offset = align(sizeof(header), kAlignment);
+  header.chunk_offset = align(
+      header.entry_offset + sizeof(ArchiveEntry) * entries.size(), kAlignment);
+  header.name_offset = header.chunk_offset + sizeof(ArchiveChunk) * jobs.size();
+  header.name_size = names.size();
+
+  // Entries start aligned, their chunks follow each other without gaps
+  vector<ArchiveChunk> chunks(jobs.size());
+  ullong offset = align(header.name_offset + header.name_size, kAlignment);
+  for (const auto& entry : entries) {
+    offset = align(offset, kAlignment);
+    for (uint i = 0; i < entry.chunk_count; i++) {
+      const Job& job = jobs[entry.first_chunk + i];
+      ArchiveChunk& chunk = chunks[entry.first_chunk + i];
+      chunk.offset = offset;
+      chunk.size = job.size;
+      chunk.compressed_size =
+          job.data.empty() ? job.size : static_cast<uint>(job.data.size());
+      offset += chunk.compressed_size;
+    }
+  }
+  header.file_size = offset;
+
+  bool result = FileSystem::Write(filename, [&](std::ostream& out) {
+    auto pad = [&out](ullong position) {
+      static const char zeros[kAlignment] = {};
+      ullong current = static_cast<ullong>(out.tellp());
+      out.write(zeros, position - current);
+    };
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad(header.entry_offset);
+    out.write(reinterpret_cast<const char*>(entries.data()),
+              sizeof(ArchiveEntry) * entries.size());
+    pad(header.chunk_offset);
+    out.write(reinterpret_cast<const char*>(chunks.data()),
+              sizeof(ArchiveChunk) * chunks.size());
+    out.write(names.data(), names.size());
+
+    for (const auto& entry : entries) {
+      if (entry.chunk_count == 0) continue;
+      pad(chunks[entry.first_chunk].offset);
+      for (uint i = 0; i < entry.chunk_count; i++) {
+        const Job& job = jobs[entry.first_chunk + i];
+        const byte* data = job.data.empty()
+                               ? items[job.item].file->GetData() + job.offset
+                               : job.data.data();
+        out.write(reinterpret_cast<const char*>(data),
+                  chunks[entry.first_chunk + i].compressed_size);
+      }
+    }
+  });
+  if (!result) return false;
+
+  if (stats) {
+    stats->entry_count = header.entry_count;
+    stats->source_size = 0;
+    for (const auto& entry : entries) stats->source_size += entry.size;
+    stats->archive_size = header.file_size;
+  }
+
+  return true;
+}
+}  // namespace voodoo
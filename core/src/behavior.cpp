@@ -15,17 +15,51 @@
 
 #include "../include/voodoo/behavior.h"
 
+#include <algorithm>
+
 namespace voodoo {
 bool Behavior::Init() {
+  if (!BehaviorStats::IsEnabled()) {
+    Start();
+    return true;
+  }
+
+  ullong begin = BehaviorStats::Now();
   Start();
+  ullong time = BehaviorStats::Now() - begin;
+
+  BehaviorCounters& counters = GetCounters();
+  counters.start_calls++;
+  counters.start_time += time;
+  counters.start_max = std::max(counters.start_max, time);
+
   return true;
 }
 
 bool Behavior::Tick() {
+  if (!BehaviorStats::IsEnabled()) {
+    Update();
+    return true;
+  }
+
+  ullong begin = BehaviorStats::Now();
   Update();
+  ullong time = BehaviorStats::Now() - begin;
+
+  BehaviorCounters& counters = GetCounters();
+  counters.update_calls++;
+  counters.update_time += time;
+  counters.frame_time += time;
+  counters.call_max = std::max(counters.call_max, time);
+
   return true;
 }
 
 void Behavior::Start() {}
 void Behavior::Update() {}
+
+BehaviorCounters& Behavior::GetCounters() {
+  if (!counters_) counters_ = &BehaviorStats::Get().GetCounters(*this);
+  return *counters_;
+}
 }  // namespace voodoo
\ No newline at end of file
@@ -0,0 +1,121 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/behavior_stats.h"
+
+#include "../include/voodoo/behavior.h"
+#include "../include/voodoo/logger.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace voodoo {
+namespace {
+float ToMilliseconds(ullong nanoseconds) {
+  return static_cast<float>(nanoseconds / 1e6);
+}
+}  // namespace
+
+bool BehaviorStats::enabled_ = true;
+
+BehaviorStats::BehaviorStats() : frame_count_(0) {}
+
+BehaviorStats& BehaviorStats::Get() {
+  static BehaviorStats instance;
+  return instance;
+}
+
+void BehaviorStats::SetEnabled(bool enabled) { enabled_ = enabled; }
+
+ullong BehaviorStats::Now() {
+  using namespace std::chrono;
+  return ullong(duration_cast<nanoseconds>(
+                    steady_clock::now().time_since_epoch())
+                    .count());
+}
+
+BehaviorCounters& BehaviorStats::GetCounters(const Behavior& behavior) {
+  std::type_index type = typeid(behavior);
+  auto it = types_.find(type);
+  if (it != types_.end()) return *it->second;
+
+  counters_.emplace_back();
+  BehaviorCounters& counters = counters_.back();
+  // Named by Component::Create(), else by the compiler
+  counters.type = behavior.GetName();
+  if (counters.type.empty()) counters.type = type.name();
+  counters.start_calls = counters.start_time = counters.start_max = 0;
+  counters.update_calls = counters.update_time = counters.call_max = 0;
+  counters.frame_time = counters.frame_max = 0;
+  types_[type] = &counters;
+
+  return counters;
+}
+
+void BehaviorStats::EndFrame() {
+  for (auto& counters : counters_) {
+    counters.frame_max = std::max(counters.frame_max, counters.frame_time);
+    counters.frame_time = 0;
+  }
+  frame_count_++;
+}
+
+void BehaviorStats::Reset() {
+  for (auto& counters : counters_) {
+    counters.start_calls = counters.start_time = counters.start_max = 0;
+    counters.update_calls = counters.update_time = counters.call_max = 0;
+    counters.frame_time = counters.frame_max = 0;
+  }
+  frame_count_ = 0;
+}
+
+vector<BehaviorTypeStats> BehaviorStats::GetStats() const {
+  vector<BehaviorTypeStats> stats;
+  for (const auto& counters : counters_) {
+    BehaviorTypeStats type_stats;
+    type_stats.type = counters.type;
+    type_stats.start_calls = counters.start_calls;
+    type_stats.start_time = ToMilliseconds(counters.start_time);
+    type_stats.start_max = ToMilliseconds(counters.start_max);
+    type_stats.update_calls = counters.update_calls;
+    type_stats.update_time = ToMilliseconds(counters.update_time);
+    type_stats.frame_avg =
+        frame_count_ > 0 ? type_stats.update_time / frame_count_ : 0.0f;
+    type_stats.frame_max = ToMilliseconds(counters.frame_max);
+    type_stats.call_max = ToMilliseconds(counters.call_max);
+    stats.push_back(type_stats);
+  }
+
+  std::sort(stats.begin(), stats.end(),
+            [](const BehaviorTypeStats& a, const BehaviorTypeStats& b) {
+              return a.frame_avg > b.frame_avg;
+            });
+
+  return stats;
+}
+
+void BehaviorStats::Dump() const {
+  VOODOO_LOG_INFO(kLogCategoryEngine,
+                  "Behavior times over {} frames, in ms:", frame_count_);
+  for (const auto& type : GetStats()) {
+    VOODOO_LOG_INFO(kLogCategoryEngine,
+                    "{}: Update {} calls, {} per frame (max {}), longest "
+                    "call {}; Start {} calls, {} (max {})",
+                    type.type, type.update_calls, type.frame_avg,
+                    type.frame_max, type.call_max, type.start_calls,
+                    type.start_time, type.start_max);
+  }
+}
+}  // namespace voodoo
@@ -0,0 +1,161 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/binary_log.h"
+
+#include <cstring>
+#include <iterator>
+
+namespace voodoo {
+BinaryLogWriter::BinaryLogWriter() : last_time_(0), size_(0), entry_count_(0) {}
+
+bool BinaryLogWriter::Open(const string& filename, ullong start_time) {
+  file_.open(filename, std::ios::binary | std::ios::trunc);
+  if (!file_) return false;
+
+  BinaryLogHeader header;
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.start_time = start_time;
+  file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file_.flush();
+
+  return bool(file_);
+}
+
+void BinaryLogWriter::Append(const BinaryLogEntry& entry) {
+  uint format_id = 0;
+  if (entry.format) {
+    auto it = format_ids_.find(entry.format);
+    if (it != format_ids_.end()) {
+      format_id = it->second;
+    } else {
+      format_id = static_cast<uint>(format_ids_.size()) + 1;
+      format_ids_[entry.format] = format_id;
+
+      size_t length = strlen(entry.format);
+      records_ += static_cast<char>(kBinaryLogRecordFormat);
+      LogArguments::AppendVarint(records_, format_id);
+      LogArguments::AppendVarint(records_, length);
+      records_.append(entry.format, length);
+    }
+  }
+
+  records_ += static_cast<char>(kBinaryLogRecordEntry);
+  records_ += static_cast<char>(entry.level | entry.category << 2);
+  llong delta = llong(entry.time - last_time_);
+  LogArguments::AppendVarint(records_, entry.thread);
+  LogArguments::AppendVarint(records_, LogArguments::ZigZag(delta));
+  LogArguments::AppendVarint(records_, format_id);
+  LogArguments::AppendVarint(records_, entry.text.size());
+  records_ += entry.text;
+
+  last_time_ = entry.time;
+  entry_count_++;
+}
+
+bool BinaryLogWriter::Write() {
+  if (records_.empty()) return true;
+
+  file_.write(records_.data(), records_.size());
+  file_.flush();
+  size_ += records_.size();
+  records_.clear();
+
+  return bool(file_);
+}
+
+ullong BinaryLogWriter::GetSize() const { return size_; }
+
+ullong BinaryLogWriter::GetEntryCount() const { return entry_count_; }
+
+BinaryLogReader::BinaryLogReader(const string& filename)
+    : offset_(0), start_time_(0), time_(0), truncated_(false) {
+  using namespace std;
+  ifstream file(filename, ios::binary);
+  if (!file) throw runtime_error("Failed to open \"" + filename + "\"");
+  data_.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+
+  BinaryLogHeader header;
+  if (data_.size() < sizeof(header)) {
+    throw runtime_error("Invalid binary log: \"" + filename + "\"");
+  }
+  memcpy(&header, data_.data(), sizeof(header));
+  if (header.magic != BinaryLogWriter::kMagic ||
+      header.version != BinaryLogWriter::kVersion) {
+    throw runtime_error("Unsupported binary log: \"" + filename + "\"");
+  }
+
+  offset_ = sizeof(header);
+  start_time_ = header.start_time;
+  formats_.push_back(string());
+}
+
+bool BinaryLogReader::Next(BinaryLogEntry& entry) {
+  while (offset_ < data_.size()) {
+    // Records are only taken once whole
+    size_t offset = offset_;
+    auto kind = static_cast<BinaryLogRecord>(data_[offset++]);
+
+    if (kind == kBinaryLogRecordFormat) {
+      ullong id, length;
+      if (!LogArguments::ReadVarint(data_, offset, id) ||
+          !LogArguments::ReadVarint(data_, offset, length) ||
+          length > data_.size() - offset)
+        break;
+      // Ids are handed out in order
+      if (id != formats_.size()) break;
+
+      formats_.push_back(data_.substr(offset, size_t(length)));
+      offset_ = offset + size_t(length);
+    } else if (kind == kBinaryLogRecordEntry) {
+      if (offset >= data_.size()) break;
+      auto flags = static_cast<byte>(data_[offset++]);
+
+      ullong thread, delta, format_id, size;
+      if (!LogArguments::ReadVarint(data_, offset, thread) ||
+          !LogArguments::ReadVarint(data_, offset, delta) ||
+          !LogArguments::ReadVarint(data_, offset, format_id) ||
+          !LogArguments::ReadVarint(data_, offset, size) ||
+          size > data_.size() - offset || format_id >= formats_.size())
+        break;
+      // Damaged flags are treated like a truncated record
+      if ((flags & 3) > kLogEntryLevelError ||
+          (flags >> 2) >= kLogCategoryCount)
+        break;
+
+      time_ += LogArguments::UnZigZag(delta);
+      entry.level = static_cast<LogEntryLevel>(flags & 3);
+      entry.category = static_cast<LogCategory>(flags >> 2);
+      entry.thread = static_cast<uint>(thread);
+      entry.time = time_;
+      entry.format = format_id ? formats_[size_t(format_id)].c_str() : nullptr;
+      entry.text.assign(data_, offset, size_t(size));
+      offset_ = offset + size_t(size);
+
+      return true;
+    } else {
+      break;
+    }
+  }
+
+  truncated_ = offset_ < data_.size();
+  return false;
+}
+
+ullong BinaryLogReader::GetStartTime() const { return start_time_; }
+
+bool BinaryLogReader::IsTruncated() const { return truncated_; }
+}  // namespace voodoo
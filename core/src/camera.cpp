@@ -35,4 +35,6 @@ float4x4 Camera::GetViewMatrix() {
 float4x4 Camera::GetProjectionMatrix() {
   return float4x4::Perspective(fov_, aspect_ratio_, z_near_, z_far_, -1.0f);
 }
+
+float Camera::GetFov() const { return fov_; }
 }  // namespace voodoo
\ No newline at end of file
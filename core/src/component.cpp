@@ -44,7 +44,7 @@ sptr<Component> Component::AddComponent(sptr<Component> component) {
   return game_object_->AddComponent(component);
 }
 
-void Component::SetName(const string& name) {
+void Component::SetName(NameId name) {
   name_ = name;
 }
 }  // namespace voodoo
\ No newline at end of file
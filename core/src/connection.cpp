@@ -15,6 +15,8 @@
 
 #include "../include/voodoo/connection.h"
 
+#include "../include/voodoo/memory_tracker.h"
+
 namespace voodoo {
 Connection::Connection() {}
 
@@ -165,16 +167,14 @@ bool Connection::GetString(std::string& data) {
 
   if (!GetInt32(bufferLength)) return false;
 
-  char* buffer = new char[bufferLength + 1];
-  buffer[bufferLength] = '\0';
+  if (bufferLength < 0) return false;
 
-  if (!Recieve(buffer, bufferLength)) {
-    delete[] buffer;
-    return false;
-  }
+  std::vector<char, TaggedAllocator<char, kMemoryTagNetwork>> buffer(
+      bufferLength + 1, '\0');
+
+  if (!Recieve(buffer.data(), bufferLength)) return false;
 
-  data = buffer;
-  delete[] buffer;
+  data = buffer.data();
 
   return true;
 }
@@ -196,6 +196,7 @@ bool Connection::ProcessPacket(PacketType packetType) {
 }
 
 void Connection::Thread() {
+  MemoryScope memory_scope(kMemoryTagNetwork);
   PacketType packetType;
 
   while (true) {
@@ -19,9 +19,14 @@
 
 // Components
 #include "../include/voodoo/camera.h"
+#include "../include/voodoo/frame_arena.h"
+#include "../include/voodoo/profiler.h"
 #include "../include/voodoo/renderer.h"
 #include "../include/voodoo/transform.h"
 
+#include <algorithm>
+#include <tuple>
+
 namespace voodoo {
 DirectX::DirectX()
     : swap_chain_(nullptr),
@@ -38,6 +43,7 @@ DirectX::~DirectX() {
     swap_chain_->SetFullscreenState(false, NULL);
   }
 
+  ReleaseMeshBuffers();
   safe_release(bs_default_);
   safe_release(bs_no_blend_);
   safe_release(rs_default_);
@@ -112,42 +118,109 @@ bool DirectX::Init(const sptr<Window>& window) {
 }
 
 bool DirectX::Render(const sptr<Scene>& scene) {
-  vector<sptr<const Renderer>> renderers;
+  VOODOO_PROFILE_SCOPE("Render");
   auto camera = scene->GetCamera();
   BeginScene(scene->GetClearColor());
 
-  for (auto& game_object : scene->GetGameObjects()) {
-    if (game_object->IsActive()) {
-      auto r = game_object->GetComponent<Renderer>();
-      if (r) renderers.push_back(r);
-    }
-  }
+  // Draws are grouped by texture and mesh so that each is bound once per
+  // run. Materials of textures packed into the same atlas page share the
+  // texture and so a single bind. Shaders keep the order they first
+  // appear in, as later ones may blend over earlier ones. The scene order
+  // ends the key, it keeps the sort stable without stable_sort's buffer.
+  using DrawKey =
+      std::tuple<size_t, ID3D11ShaderResourceView*, const Mesh*, size_t>;
+  auto game_objects = scene->GetGameObjects();
+  frame_vector<pair<DrawKey, sptr<const Renderer>>> renderers;
+  frame_vector<const Shader*> shader_order;
+  renderers.reserve(game_objects.size());
+  for (auto& game_object : game_objects) {
+    if (!game_object->IsActive()) continue;
+
+    auto renderer = game_object->GetComponent<Renderer>();
+    if (!renderer) continue;
 
-  for (auto& renderer : renderers) {
+    auto material = renderer->GetMaterial();
+    const Shader* shader = material->shader.get();
+    size_t order = std::find(shader_order.begin(), shader_order.end(),
+                             shader) -
+                   shader_order.begin();
+    if (order == shader_order.size()) shader_order.push_back(shader);
+
+    renderers.emplace_back(DrawKey(order, material->texture->srv,
+                                   renderer->GetMesh().get(), renderers.size()),
+                           renderer);
+  }
+  std::sort(renderers.begin(), renderers.end(),
+            [](const pair<DrawKey, sptr<const Renderer>>& a,
+               const pair<DrawKey, sptr<const Renderer>>& b) {
+              return a.first < b.first;
+            });
+
+  render_stats_ = {0, 0, 0, 0, 0};
+  Shader* bound_shader = nullptr;
+  ID3D11ShaderResourceView* bound_srv = nullptr;
+  Mesh* bound_mesh = nullptr;
+
+  auto vm = camera->GetViewMatrix();
+  auto pm = camera->GetProjectionMatrix();
+  for (auto& draw : renderers) {
+    auto& renderer = draw.second;
     auto wm = renderer->GetTransform()->GetWorldMatrix();
-    auto vm = camera->GetViewMatrix();
-    auto pm = camera->GetProjectionMatrix();
 
     auto material = renderer->GetMaterial();
     auto mesh = renderer->GetMesh();
+    if (mesh->vertex_format == kVertexFormatPtnPacked) {
+      wm = wm * mesh->GetDequantizationMatrix();
+    }
     auto shader = material->shader;
     auto srv = material->texture->srv;
-    auto buffers = mesh_buffers_[mesh];
-    auto v_buffer = buffers.first;
-    auto i_buffer = buffers.second;
 
-    if (!shader->Update(wm, vm, pm, srv)) {
-      throw std::runtime_error("Failed to update shader");
+    bool new_batch = render_stats_.draws == 0;
+    if (shader.get() != bound_shader) {
+      if (!shader->Bind()) {
+        throw std::runtime_error("Failed to bind shader");
+      }
+      bound_shader = shader.get();
+      render_stats_.shader_binds++;
+      new_batch = true;
     }
 
-    uint stride = sizeof(mesh->vertices[0]);
-    uint offset = 0;
+    if (srv != bound_srv) {
+      shader->SetTexture(srv);
+      bound_srv = srv;
+      render_stats_.texture_binds++;
+      new_batch = true;
+    }
 
-    device_context_->IASetVertexBuffers(0, 1, &v_buffer, &stride, &offset);
-    device_context_->IASetIndexBuffer(i_buffer, DXGI_FORMAT_R32_UINT, 0);
-    device_context_->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    if (!shader->Update(wm, vm, pm)) {
+      throw std::runtime_error("Failed to update shader");
+    }
+
+    if (mesh.get() != bound_mesh) {
+      auto it = mesh_buffers_.find(mesh.get());
+      if (it == mesh_buffers_.end() || !it->second.IsOf(mesh)) {
+        if (!CreateMeshBuffers(mesh)) {
+          throw std::runtime_error("Failed to create mesh buffers");
+        }
+        it = mesh_buffers_.find(mesh.get());
+      }
+      auto v_buffer = it->second.vertices;
+      auto i_buffer = it->second.indices;
+
+      uint stride = mesh->GetVertexStride();
+      uint offset = 0;
+
+      device_context_->IASetVertexBuffers(0, 1, &v_buffer, &stride, &offset);
+      device_context_->IASetIndexBuffer(i_buffer, DXGI_FORMAT_R32_UINT, 0);
+      device_context_->IASetPrimitiveTopology(
+          D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+      bound_mesh = mesh.get();
+      render_stats_.mesh_binds++;
+    }
 
     device_context_->DrawIndexed(mesh->index_count, 0, 0);
+    render_stats_.draws++;
+    if (new_batch) render_stats_.batches++;
   }
 
   EndScene();
@@ -160,14 +233,14 @@ bool DirectX::CreateMeshBuffers(sptr<Mesh> mesh) {
 
   D3D11_BUFFER_DESC desc;
   desc.Usage = D3D11_USAGE_DEFAULT;
-  desc.ByteWidth = sizeof(mesh->vertices[0]) * mesh->vertex_count;
+  desc.ByteWidth = mesh->GetVertexStride() * mesh->vertex_count;
   desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
   desc.CPUAccessFlags = 0;
   desc.MiscFlags = 0;
   desc.StructureByteStride = 0;
 
   D3D11_SUBRESOURCE_DATA data;
-  data.pSysMem = mesh->vertices.data();
+  data.pSysMem = mesh->GetVertexData();
   data.SysMemPitch = 0;
   data.SysMemSlicePitch = 0;
 
@@ -177,10 +250,10 @@ bool DirectX::CreateMeshBuffers(sptr<Mesh> mesh) {
     return false;
   }
 
-  desc.ByteWidth = sizeof(mesh->indices[0]) * mesh->index_count;
+  desc.ByteWidth = sizeof(uint) * mesh->index_count;
   desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 
-  data.pSysMem = mesh->indices.data();
+  data.pSysMem = mesh->GetIndexData();
 
   ID3D11Buffer* i;
   hr = device_->CreateBuffer(&desc, &data, &i);
@@ -188,12 +261,26 @@ bool DirectX::CreateMeshBuffers(sptr<Mesh> mesh) {
     return false;
   }
 
-  auto mesh_buffer = MeshBuffer(Buffer(v), Buffer(i));
-  mesh_buffers_.insert(pair<sptr<Mesh>, MeshBuffer>(mesh, mesh_buffer));
+  // Buffers of a reloaded mesh, or of a freed mesh at the same address,
+  // are replaced
+  MeshBuffer& buffer = mesh_buffers_[mesh.get()];
+  safe_release(buffer.vertices);
+  safe_release(buffer.indices);
+  buffer.mesh = mesh;
+  buffer.vertices = v;
+  buffer.indices = i;
 
   return true;
 }
 
+void DirectX::ReleaseMeshBuffers() {
+  for (auto& buffer : mesh_buffers_) {
+    safe_release(buffer.second.vertices);
+    safe_release(buffer.second.indices);
+  }
+  mesh_buffers_.clear();
+}
+
 void DirectX::ToggleWireframeMode() {
   wireframe_mode_enabled_ = !wireframe_mode_enabled_;
   device_context_->RSSetState(wireframe_mode_enabled_
@@ -216,6 +303,7 @@ void DirectX::BeginScene(const color& clear_color) {
 }
 
 void DirectX::EndScene() {
+  VOODOO_PROFILE_SCOPE("Present");
   if (vsync_enabled_) {
     swap_chain_->Present(1, 0);
   } else {
@@ -17,12 +17,21 @@
 
 #include "../include/voodoo/behavior.h"
 #include "../include/voodoo/directx.h"
+#include "../include/voodoo/frame_arena.h"
 #include "../include/voodoo/logger.h"
+#include "../include/voodoo/memory_tracker.h"
+#include "../include/voodoo/profiler.h"
 #include "../include/voodoo/renderer.h"
 
-#include <sstream>
+#include <cwchar>
+#include <iterator>
 
 namespace voodoo {
+namespace {
+// Frames a scene runs unchanged before its frames must not allocate
+const uint kWarmUpFrames = 120;
+}  // namespace
+
 bool Engine::Init(HINSTANCE instance, const wstring& name) {
   name_ = name;
 
@@ -38,17 +47,31 @@ bool Engine::Init(HINSTANCE instance, const wstring& name) {
     return false;
   }
 
+  hot_reload_ = std::make_shared<HotReload>(graphics_api_);
+  texture_streamer_ = std::make_shared<TextureStreamer>(graphics_api_);
+
   return true;
 }
 
 bool Engine::LoadScene(sptr<Scene> scene) {
+  VOODOO_PROFILE_SCOPE("LoadScene");
+  if (scene_ && scene_ != scene) {
+    scene_->Unload();
+    graphics_api_->ReleaseMeshBuffers();
+  }
   scene_ = scene;
+  steady_frames_ = 0;
   vector<sptr<Renderer>> renderers;
-  for (auto& game_object : scene_->GetGameObjects()) {
+  // Copied, behaviors may add game objects and components as they start
+  auto objects = scene_->GetGameObjects();
+  frame_vector<sptr<GameObject>> game_objects(objects.begin(), objects.end());
+  for (auto& game_object : game_objects) {
     if (auto renderer = game_object->GetComponent<Renderer>()) {
       renderers.push_back(renderer);
     }
-    for (auto& component : game_object->GetComponents()) {
+    auto components = game_object->GetComponents();
+    for (auto& component : frame_vector<sptr<Component>>(components.begin(),
+                                                          components.end())) {
       if (auto behavior = d_cast<Behavior>(component)) {
         if (!behavior->Init()) {
           Log::Error("Failed to init object");
@@ -73,10 +96,20 @@ int Engine::Run() {
       TranslateMessage(&msg);
       DispatchMessage(&msg);
     } else {
-      Time::Tick();
-      UpdateCaption();
-      if (!Update()) return false;
-      graphics_api_->Render(scene_);
+      {
+        VOODOO_PROFILE_SCOPE("Frame");
+        Time::Tick();
+        UpdateCaption();
+        hot_reload_->Update(scene_);
+        if (!Update()) return false;
+        BehaviorStats::Get().EndFrame();
+        texture_streamer_->Update(scene_, window_->GetHeight());
+        graphics_api_->Render(scene_);
+      }
+      FrameArena::Get().Reset();
+      Profiler::Get().EndFrame();
+      MemoryTracker::EndFrame();
+      CheckFrameAllocations();
     }
   }
 
@@ -88,10 +121,29 @@ void Engine::UpdateCaption() {
   static float time;
 
   if ((Time::GetTime() - time) >= 1) {
-    wostringstream caption;
-    caption.precision(6);
-    caption << name_ << " | FPS: " << fps << " (" << 1000 / fps << "ms)";
-    SetWindowText(window_->GetHandle(), caption.str().c_str());
+    // Formatted in place, the frame should not allocate
+    wchar_t caption[512];
+    size_t length = 0;
+    auto append = [&caption, &length](const wchar_t* format, auto... args) {
+      int written = swprintf(caption + length, std::size(caption) - length,
+                             format, args...);
+      if (written > 0) length += written;
+    };
+
+    const RenderStats& stats = graphics_api_->GetRenderStats();
+    append(L"%ls | FPS: %g (%gms) | Draws: %u, Batches: %u, Texture Binds: %u",
+           name_.c_str(), fps, 1000 / fps, stats.draws, stats.batches,
+           stats.texture_binds);
+    TextureStreamingStats streaming = texture_streamer_->GetStats();
+    if (streaming.textures > 0) {
+      append(L" | Streamed: %lluKB, Pending: %u",
+             streaming.resident_bytes / 1024, streaming.pending);
+    }
+    if (MemoryTracker::IsHooked()) {
+      append(L" | Allocs: %llu/frame",
+             MemoryTracker::GetFrameAllocationCount());
+    }
+    SetWindowText(window_->GetHandle(), caption);
     fps = 0;
     time = Time::GetTime();
   } else {
@@ -99,10 +151,48 @@ void Engine::UpdateCaption() {
   }
 }
 
+void Engine::CheckFrameAllocations() {
+  if (!MemoryTracker::IsHooked()) return;
+
+  // Loading, reloading and streaming assets or changing the scene
+  // allocate by design and start the warm-up again
+  const HotReloadStats& reload = hot_reload_->GetStats();
+  uint reloads = reload.reloads + reload.failures;
+  size_t objects = scene_->GetGameObjects().size();
+  TextureStreamingStats streaming = texture_streamer_->GetStats();
+  if (objects != checked_objects_ || reloads != checked_reloads_ ||
+      streaming.streamed_bytes != checked_streamed_bytes_ ||
+      streaming.pending != 0) {
+    checked_objects_ = objects;
+    checked_reloads_ = reloads;
+    checked_streamed_bytes_ = streaming.streamed_bytes;
+    steady_frames_ = 0;
+    return;
+  }
+
+  if (++steady_frames_ <= kWarmUpFrames) return;
+
+  // Reported once per warm-up at most
+  ullong allocations = MemoryTracker::GetFrameAllocationCount();
+  if (allocations != 0) {
+    VOODOO_LOG_WARNING(kLogCategoryEngine,
+                       "Steady frame made {} heap allocations, see "
+                       "MemoryTracker::Dump()",
+                       allocations);
+    steady_frames_ = 0;
+  }
+}
+
 bool Engine::Update() {
-  for (auto& game_object : scene_->GetGameObjects()) {
+  VOODOO_PROFILE_SCOPE("Update");
+  // Copied, behaviors may add game objects and components as they update
+  auto objects = scene_->GetGameObjects();
+  frame_vector<sptr<GameObject>> game_objects(objects.begin(), objects.end());
+  for (auto& game_object : game_objects) {
     if (game_object->IsActive()) {
-      for (auto& component : game_object->GetComponents()) {
+      auto components = game_object->GetComponents();
+      for (auto& component : frame_vector<sptr<Component>>(
+               components.begin(), components.end())) {
         if (auto behavior = d_cast<Behavior>(component)) {
           if (!behavior->Tick()) {
             Log::Error("Failed to update behavior");
@@ -122,5 +212,11 @@ sptr<Window> Engine::GetWindow() const { return window_; }
 
 sptr<GraphicsAPI> Engine::GetGraphicsAPI() const { return graphics_api_; }
 
+sptr<HotReload> Engine::GetHotReload() const { return hot_reload_; }
+
+sptr<TextureStreamer> Engine::GetTextureStreamer() const {
+  return texture_streamer_;
+}
+
 sptr<Scene> Engine::GetScene() const { return scene_; }
 }  // namespace voodoo
\ No newline at end of file
@@ -0,0 +1,195 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/file_system.h"
+
+#include "../include/voodoo/archive.h"
+#include "../include/voodoo/logger.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif  // _WIN32
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+namespace voodoo {
+FileData::FileData(sptr<MappedFile> mapping)
+    : FileData(mapping, mapping->GetData(), mapping->GetSize()) {}
+
+FileData::FileData(sptr<MappedFile> mapping, const byte* data, size_t size)
+    : mapping_(mapping), data_(data), size_(size) {}
+
+FileData::FileData(vector<byte>&& buffer)
+    : buffer_(std::move(buffer)),
+      data_(buffer_.data()),
+      size_(buffer_.size()) {}
+
+const byte* FileData::GetData() const { return data_; }
+
+size_t FileData::GetSize() const { return size_; }
+
+std::shared_mutex FileSystem::mutex_;
+vector<FileSystem::MountPoint> FileSystem::mounts_;
+
+bool FileSystem::Mount(const string& archive, const string& mount_point) {
+  MountPoint mount;
+  mount.prefix = Normalize(mount_point);
+  try {
+    mount.archive = std::make_shared<Archive>(archive);
+  } catch (const std::exception& e) {
+    VOODOO_LOG_ERROR(kLogCategoryAssets, "{}", e.what());
+    return false;
+  }
+
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  mounts_.push_back(mount);
+
+  return true;
+}
+
+void FileSystem::UnmountAll() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  mounts_.clear();
+}
+
+sptr<FileData> FileSystem::Read(const string& filename) {
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (!mounts_.empty()) {
+      string path = Normalize(filename);
+      for (auto it = mounts_.rbegin(); it != mounts_.rend(); it++) {
+        // Mounting at "." serves every relative path
+        const string& prefix = it->prefix;
+        string name;
+        if (prefix == ".") {
+          name = path;
+        } else if (path.size() > prefix.size() + 1 &&
+                   path.compare(0, prefix.size(), prefix) == 0 &&
+                   path[prefix.size()] == '/') {
+          name = path.substr(prefix.size() + 1);
+        } else {
+          continue;
+        }
+
+        auto entry = it->archive->Find(name);
+        if (entry) return it->archive->Read(*entry);
+      }
+    }
+  }
+
+  return std::make_shared<FileData>(std::make_shared<MappedFile>(filename));
+}
+
+bool FileSystem::Write(const string& filename, const byte* data,
+                       size_t size) {
+  return Write(filename, [data, size](std::ostream& out) {
+    out.write(reinterpret_cast<const char*>(data), size);
+  });
+}
+
+bool FileSystem::Write(const string& filename,
+                       const std::function<void(std::ostream&)>& write) {
+  string temporary = filename + ".tmp";
+  std::ofstream fout(temporary, std::ios::out | std::ios::binary);
+  if (fout.fail()) {
+    VOODOO_LOG_ERROR(kLogCategoryAssets, "Failed to write \"{}\"",
+                     temporary);
+    return false;
+  }
+
+  write(fout);
+  fout.close();
+  if (fout.fail()) {
+    VOODOO_LOG_ERROR(kLogCategoryAssets, "Failed to write \"{}\"",
+                     temporary);
+    std::error_code error;
+    std::filesystem::remove(temporary, error);
+    return false;
+  }
+
+  return Replace(temporary, filename);
+}
+
+#ifdef _WIN32
+bool FileSystem::Replace(const string& source, const string& target) {
+  namespace fs = std::filesystem;
+  static std::atomic<uint> aside_count(0);
+
+  // A file with mapped views can be neither deleted nor replaced, whatever
+  // its share mode, but it can be renamed. The old file is moved aside and
+  // deleted once nothing maps it, which later replaces retry.
+  fs::path path(target);
+  fs::path directory = path.has_parent_path() ? path.parent_path() : ".";
+  string prefix = path.filename().string() + ".old.";
+  std::error_code error;
+  for (const auto& entry : fs::directory_iterator(directory, error)) {
+    if (entry.path().filename().string().compare(0, prefix.size(), prefix) == 0)
+      DeleteFileA(entry.path().string().c_str());
+  }
+
+  string aside;
+  if (GetFileAttributesA(target.c_str()) != INVALID_FILE_ATTRIBUTES) {
+    aside = target + ".old." + std::to_string(GetCurrentProcessId()) + "." +
+            std::to_string(aside_count++);
+    if (!MoveFileExA(target.c_str(), aside.c_str(), 0)) {
+      VOODOO_LOG_ERROR(kLogCategoryAssets,
+                       "Failed to replace \"{}\", it is open without delete "
+                       "sharing (error {})",
+                       target, GetLastError());
+      DeleteFileA(source.c_str());
+      return false;
+    }
+  }
+
+  if (!MoveFileExA(source.c_str(), target.c_str(), 0)) {
+    VOODOO_LOG_ERROR(kLogCategoryAssets, "Failed to replace \"{}\" (error {})",
+                     target, GetLastError());
+    if (!aside.empty()) MoveFileExA(aside.c_str(), target.c_str(), 0);
+    DeleteFileA(source.c_str());
+    return false;
+  }
+
+  // Fails while the old file is still mapped
+  if (!aside.empty()) DeleteFileA(aside.c_str());
+
+  return true;
+}
+#else
+bool FileSystem::Replace(const string& source, const string& target) {
+  // Renaming over the target unlinks the old file, which mappings keep
+  // alive until they are closed
+  std::error_code error;
+  std::filesystem::rename(source, target, error);
+  if (error) {
+    VOODOO_LOG_ERROR(kLogCategoryAssets, "Failed to replace \"{}\": {}",
+                     target, error.message());
+    std::filesystem::remove(source, error);
+    return false;
+  }
+
+  return true;
+}
+#endif  // _WIN32
+
+string FileSystem::Normalize(const string& path) {
+  string normal =
+      std::filesystem::path(path).lexically_normal().generic_string();
+  if (normal.size() > 1 && normal.back() == '/') normal.pop_back();
+  return normal;
+}
+}  // namespace voodoo
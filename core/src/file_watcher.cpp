@@ -0,0 +1,194 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/file_watcher.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+#include <cstring>
+#include <filesystem>
+
+namespace voodoo {
+namespace {
+string Normalize(const std::filesystem::path& path) {
+  return path.lexically_normal().generic_string();
+}
+}  // namespace
+
+#ifdef _WIN32
+FileWatcher::FileWatcher(Callback callback)
+    : callback_(callback),
+      stopping_(false),
+      stop_event_(CreateEventA(nullptr, TRUE, FALSE, nullptr)) {}
+
+FileWatcher::~FileWatcher() {
+  stopping_ = true;
+  SetEvent(stop_event_);
+
+  for (auto& directory : directories_) {
+    directory->thread.join();
+    CloseHandle(directory->handle);
+  }
+
+  CloseHandle(stop_event_);
+}
+
+bool FileWatcher::Watch(const string& directory) {
+  HANDLE handle = CreateFileA(
+      directory.c_str(), FILE_LIST_DIRECTORY,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+      OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+      nullptr);
+  if (handle == INVALID_HANDLE_VALUE) return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto watched = std::make_unique<Directory>();
+  watched->path = directory;
+  watched->handle = handle;
+  watched->thread = std::thread(&FileWatcher::Work, this, std::ref(*watched));
+  directories_.push_back(std::move(watched));
+
+  return true;
+}
+
+void FileWatcher::Work(Directory& directory) {
+  // Notification records are DWORD aligned
+  DWORD buffer[16 * 1024];
+  const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE |
+                       FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+
+  OVERLAPPED overlapped;
+  memset(&overlapped, 0, sizeof(overlapped));
+  overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+  HANDLE events[] = {overlapped.hEvent, stop_event_};
+
+  while (!stopping_) {
+    ResetEvent(overlapped.hEvent);
+    if (!ReadDirectoryChangesW(directory.handle, buffer, sizeof(buffer), TRUE,
+                               filter, nullptr, &overlapped, nullptr)) {
+      break;
+    }
+
+    DWORD size = 0;
+    if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0) {
+      CancelIoEx(directory.handle, &overlapped);
+      GetOverlappedResult(directory.handle, &overlapped, &size, TRUE);
+      break;
+    }
+
+    if (!GetOverlappedResult(directory.handle, &overlapped, &size, FALSE))
+      break;
+
+    // Zero size means the buffer overflowed and changes were lost
+    auto record = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer);
+    while (size != 0) {
+      if (record->Action == FILE_ACTION_ADDED ||
+          record->Action == FILE_ACTION_MODIFIED ||
+          record->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+        std::filesystem::path name(
+            std::wstring(record->FileName,
+                         record->FileNameLength / sizeof(WCHAR)));
+        callback_(Normalize(std::filesystem::path(directory.path) / name));
+      }
+
+      if (record->NextEntryOffset == 0) break;
+      record = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(
+          reinterpret_cast<const byte*>(record) + record->NextEntryOffset);
+    }
+  }
+
+  CloseHandle(overlapped.hEvent);
+}
+#else
+FileWatcher::FileWatcher(Callback callback)
+    : callback_(callback), stopping_(false) {}
+
+FileWatcher::~FileWatcher() {
+  // Threads poll with a timeout and notice the flag
+  stopping_ = true;
+
+  for (auto& directory : directories_) {
+    directory->thread.join();
+    close(directory->descriptor);
+  }
+}
+
+bool FileWatcher::Watch(const string& directory) {
+  namespace fs = std::filesystem;
+
+  int descriptor = inotify_init1(IN_NONBLOCK);
+  if (descriptor < 0) return false;
+
+  auto watched = std::make_unique<Directory>();
+  watched->path = directory;
+  watched->descriptor = descriptor;
+
+  // Watches are not recursive, so every subdirectory gets its own
+  const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+  std::error_code error;
+  int watch = inotify_add_watch(descriptor, directory.c_str(), mask);
+  if (watch < 0) {
+    close(descriptor);
+    return false;
+  }
+  watched->subdirectories[watch] = directory;
+
+  for (fs::recursive_directory_iterator it(directory, error), end; it != end;
+       it.increment(error)) {
+    if (error) break;
+    if (!it->is_directory(error)) continue;
+
+    string path = it->path().string();
+    watch = inotify_add_watch(descriptor, path.c_str(), mask);
+    if (watch >= 0) watched->subdirectories[watch] = path;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  watched->thread = std::thread(&FileWatcher::Work, this, std::ref(*watched));
+  directories_.push_back(std::move(watched));
+
+  return true;
+}
+
+void FileWatcher::Work(Directory& directory) {
+  alignas(inotify_event) char buffer[16 * 1024];
+  pollfd descriptor = {directory.descriptor, POLLIN, 0};
+
+  while (!stopping_) {
+    if (poll(&descriptor, 1, 50) <= 0) continue;
+
+    ssize_t size = read(directory.descriptor, buffer, sizeof(buffer));
+    for (ssize_t offset = 0; offset < size;) {
+      auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+      offset += sizeof(inotify_event) + event->len;
+
+      auto it = directory.subdirectories.find(event->wd);
+      if (event->len == 0 || (event->mask & IN_ISDIR) ||
+          it == directory.subdirectories.end()) {
+        continue;
+      }
+
+      callback_(Normalize(std::filesystem::path(it->second) / event->name));
+    }
+  }
+}
+#endif  // _WIN32
+}  // namespace voodoo
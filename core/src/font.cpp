@@ -127,5 +127,10 @@ float Font::GetWidth() { return width_; }
 
 float Font::GetHeight() { return height_; }
 
+void Font::SetAtlasSize(float width, float height) {
+  width_ = width;
+  height_ = height;
+}
+
 Font::CharData Font::GetCharData(const char& c) { return characters_[c]; }
 }  // namespace voodoo
\ No newline at end of file
@@ -0,0 +1,71 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/frame_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace voodoo {
+FrameArena& FrameArena::Get() {
+  static FrameArena instance;
+  return instance;
+}
+
+FrameArena::FrameArena(size_t capacity)
+    : block_(new byte[capacity]),
+      capacity_(capacity),
+      position_(block_.get()),
+      end_(block_.get() + capacity),
+      used_(0),
+      peak_(0) {}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+  auto position = reinterpret_cast<uintptr_t>(position_);
+  auto address = (position + alignment - 1) & ~uintptr_t(alignment - 1);
+  if (address + size > reinterpret_cast<uintptr_t>(end_)) {
+    size_t block_size = std::max(capacity_, size + alignment);
+    overflow_.emplace_back(new byte[block_size]);
+    position_ = overflow_.back().get();
+    end_ = position_ + block_size;
+    return Allocate(size, alignment);
+  }
+
+  used_ += address + size - position;
+  position_ = reinterpret_cast<byte*>(address + size);
+  return reinterpret_cast<void*>(address);
+}
+
+void FrameArena::Reset() {
+  peak_ = std::max(peak_, used_);
+
+  // One block of the peak with some headroom replaces those of this frame
+  if (!overflow_.empty()) {
+    overflow_.clear();
+    capacity_ = std::max(capacity_, peak_ + peak_ / 2);
+    block_.reset(new byte[capacity_]);
+  }
+
+  position_ = block_.get();
+  end_ = position_ + capacity_;
+  used_ = 0;
+}
+
+size_t FrameArena::GetUsed() const { return used_; }
+
+size_t FrameArena::GetPeak() const { return std::max(peak_, used_); }
+
+size_t FrameArena::GetCapacity() const { return capacity_; }
+}  // namespace voodoo
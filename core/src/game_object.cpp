@@ -53,30 +53,35 @@ sptr<Transform> GameObject::GetTransform() const {
   return GetComponent<Transform>();
 }
 
-vector<sptr<Component>> GameObject::GetComponents() const {
-  vector<sptr<Component>> components;
-  for (auto& it : components_)
-    components.push_back(it.second);
-  return components;
+map_values<GameObject::ComponentMap> GameObject::GetComponents() const {
+  return map_values<ComponentMap>(components_);
 }
 
 sptr<Component> GameObject::AddComponent(sptr<Component> component) {
-  auto name = component->GetName();
-  if (GetComponentByName(name)) {
-    Log::Warning("GameObject " + GetName() + " already have " + name + " component");
+  if (GetComponentByName(component->GetNameId())) {
+    VOODOO_LOG_WARNING(kLogCategoryEngine,
+                       "GameObject {} already have {} component", GetName(),
+                       component->GetName());
     return nullptr;
   }
   return InsertComponent(component);
 }
 
-sptr<Component> GameObject::GetComponentByName(const string& name) const {
+void GameObject::Release() {
+  components_.clear();
+  parent_ = nullptr;
+  scene_ = nullptr;
+}
+
+sptr<Component> GameObject::GetComponentByName(NameId name) const {
   auto it = components_.find(name);
   return it != components_.end() ? it->second : nullptr;
 }
 
 sptr<Component> GameObject::InsertComponent(sptr<Component> component) {
   component->SetGameObject(d_cast<GameObject>(shared_from_this()));
-  components_.insert(pair<string, sptr<Component>>(component->GetName(), component));
+  components_.insert(
+      pair<NameId, sptr<Component>>(component->GetNameId(), component));
   return component;
 }
 }  // namespace voodoo
\ No newline at end of file
@@ -0,0 +1,217 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/hot_reload.h"
+
+#include "../include/voodoo/game_object.h"
+#include "../include/voodoo/image_manager.h"
+#include "../include/voodoo/logger.h"
+#include "../include/voodoo/mesh_manager.h"
+#include "../include/voodoo/profiler.h"
+#include "../include/voodoo/renderer.h"
+#include "../include/voodoo/shader_buffer_manager.h"
+#include "../include/voodoo/texture.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <set>
+
+namespace voodoo {
+namespace {
+const std::chrono::milliseconds kSettleTime(20);
+
+string Normalize(const string& path) {
+  return std::filesystem::path(path).lexically_normal().generic_string();
+}
+}  // namespace
+
+HotReload::HotReload(sptr<GraphicsAPI> graphics_api)
+    : graphics_api_(graphics_api),
+      stats_({0, 0, 0.0f, 0.0f}),
+      watcher_(std::make_unique<FileWatcher>(
+          [this](const string& filename) { OnChange(filename); })) {}
+
+HotReload::~HotReload() {
+  watcher_.reset();
+
+  // Loads in flight refer to this object
+  for (auto& load : loads_) load.wait();
+}
+
+bool HotReload::Watch(const string& directory) {
+  if (!watcher_->Watch(directory)) {
+    VOODOO_LOG_ERROR(kLogCategoryAssets, "Failed to watch directory: \"{}\"",
+                     directory);
+    return false;
+  }
+
+  return true;
+}
+
+void HotReload::AddListener(Listener listener) {
+  listeners_.push_back(listener);
+}
+
+void HotReload::Update(const sptr<Scene>& scene) {
+  VOODOO_PROFILE_SCOPE("HotReload");
+  vector<Reload> reloads;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto now = Clock::now();
+    for (auto it = changes_.begin(); it != changes_.end();) {
+      if (now - it->second.last < kSettleTime ||
+          loading_.count(it->first) != 0) {
+        it++;
+        continue;
+      }
+
+      string filename = it->first;
+      Clock::time_point changed = it->second.first;
+      loading_.insert(filename);
+      loads_.push_back(ThreadPool::Get().Submit(
+          [this, filename, changed]() { LoadAssets(filename, changed); }));
+      it = changes_.erase(it);
+    }
+
+    loads_.erase(
+        std::remove_if(loads_.begin(), loads_.end(),
+                       [](const std::future<void>& load) {
+                         return load.wait_for(std::chrono::seconds(0)) ==
+                                std::future_status::ready;
+                       }),
+        loads_.end());
+
+    reloads.swap(reloads_);
+  }
+
+  for (auto& reload : reloads) Apply(reload, scene);
+}
+
+const HotReloadStats& HotReload::GetStats() const { return stats_; }
+
+void HotReload::OnChange(const string& filename) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto now = Clock::now();
+  auto it = changes_.find(filename);
+  if (it == changes_.end()) {
+    changes_[filename] = {now, now};
+  } else {
+    it->second.last = now;
+  }
+}
+
+void HotReload::LoadAssets(const string& filename, Clock::time_point changed) {
+  Reload reload;
+  reload.filename = filename;
+  reload.changed = changed;
+  reload.failed = false;
+
+  // Only assets that are resident get reloaded, anything else loads
+  // from the new file on its next retrieval anyway
+  try {
+    MeshManager::Get().Reload(filename, reload.mesh, reload.fresh_mesh);
+    ImageManager::Get().Reload(filename, reload.image, reload.fresh_image);
+    ShaderBufferManager::Get().Reload(filename, reload.shader_buffer,
+                                      reload.fresh_shader_buffer);
+  } catch (const std::exception& e) {
+    VOODOO_LOG_WARNING(kLogCategoryAssets, "Failed to reload \"{}\": {}",
+                       filename, e.what());
+    reload.failed = true;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  reloads_.push_back(reload);
+  loading_.erase(filename);
+}
+
+void HotReload::Apply(Reload& reload, const sptr<Scene>& scene) {
+  if (reload.failed) {
+    stats_.failures++;
+    return;
+  }
+
+  if (reload.fresh_mesh) *reload.mesh = std::move(*reload.fresh_mesh);
+  if (reload.fresh_image) *reload.image = std::move(*reload.fresh_image);
+  if (reload.fresh_shader_buffer)
+    *reload.shader_buffer = std::move(*reload.fresh_shader_buffer);
+
+  for (auto& listener : listeners_) listener(reload.filename);
+
+  // Every resource is recreated once even when shared by renderers
+  std::set<const void*> recreated;
+  auto first = [&recreated](const void* resource) {
+    return recreated.insert(resource).second;
+  };
+
+  bool result = true;
+  for (auto& game_object : scene->GetGameObjects()) {
+    auto renderer = game_object->GetComponent<Renderer>();
+    if (!renderer) continue;
+
+    auto mesh = renderer->GetMesh();
+    if (reload.fresh_mesh && mesh == reload.mesh && first(mesh.get())) {
+      if (!graphics_api_->CreateMeshBuffers(mesh)) result = false;
+    }
+
+    auto material = renderer->GetMaterial();
+    if (!material) continue;
+
+    auto texture = material->texture;
+    if (reload.fresh_image && texture &&
+        texture->source.lock() == reload.image && first(texture.get())) {
+      try {
+        texture->Create(graphics_api_->GetDevice().get(), *reload.image);
+      } catch (const std::exception&) {
+        result = false;
+      }
+    }
+
+    auto shader = material->shader;
+    if (shader && (Normalize(shader->GetVSPath()) == reload.filename ||
+                   Normalize(shader->GetPSPath()) == reload.filename)) {
+      if (first(shader.get()) && !shader->Reload()) result = false;
+    }
+  }
+
+  // Files without resident assets or dependent resources are ignored
+  bool swapped =
+      reload.fresh_mesh || reload.fresh_image || reload.fresh_shader_buffer;
+  if (!swapped && recreated.empty()) return;
+
+  if (!result) {
+    // Shaders kept their old objects, the cache keeps the matching
+    // bytecode so that shaders created later work too
+    if (reload.fresh_shader_buffer)
+      *reload.shader_buffer = std::move(*reload.fresh_shader_buffer);
+
+    VOODOO_LOG_ERROR(kLogCategoryAssets,
+                     "Failed to recreate GPU resources of \"{}\"",
+                     reload.filename);
+    stats_.failures++;
+    return;
+  }
+
+  std::chrono::duration<float, std::milli> latency =
+      Clock::now() - reload.changed;
+  stats_.reloads++;
+  stats_.last_latency = latency.count();
+  stats_.max_latency = std::max(stats_.max_latency, latency.count());
+
+  VOODOO_LOG_INFO(kLogCategoryAssets, "Reloaded \"{}\" in {} ms",
+                  reload.filename, latency.count());
+}
+}  // namespace voodoo
@@ -15,22 +15,104 @@
 
 #include "../include/voodoo/image_manager.h"
 
-// See stb_image.h documentation for this macro explanation.
+#include "../include/voodoo/file_system.h"
+#include "../include/voodoo/memory_tracker.h"
+#include "../include/voodoo/profiler.h"
+#include "../include/voodoo/vtex.h"
+
+#include <cstring>
+
+namespace {
+// Image releases its pixels with delete[], so stb allocates with new[] too,
+// which also counts its memory when the global new is tracked
+void* StbMalloc(size_t size) { return new (std::nothrow) voodoo::byte[size]; }
+
+void StbFree(void* pointer) { delete[] static_cast<voodoo::byte*>(pointer); }
+
+void* StbRealloc(void* pointer, size_t old_size, size_t new_size) {
+  void* resized = StbMalloc(new_size);
+  if (resized && pointer) {
+    std::memcpy(resized, pointer, old_size < new_size ? old_size : new_size);
+  }
+  if (resized) StbFree(pointer);
+  return resized;
+}
+}  // namespace
+
+// See stb_image.h documentation for these macros explanation.
+#define STBI_MALLOC(size) StbMalloc(size)
+#define STBI_REALLOC_SIZED(pointer, old_size, new_size) \
+  StbRealloc(pointer, old_size, new_size)
+#define STBI_FREE(pointer) StbFree(pointer)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 namespace voodoo {
-sptr<Image> ImageManager::Load(const string& filename) {
+sptr<Image> ImageManager::Load(const string& filename, sptr<FileData> file) {
   using namespace std;
-  // Image data will always be stored in 4-chanelled format
-  // but despite this actual channels count will be stored
-  // as member value.
+  VOODOO_PROFILE_SCOPE("LoadImage");
+  MemoryScope memory_scope(kMemoryTagImages);
+  // Cooked textures come with their mips and may be block compressed
+  auto extension = filename.substr(filename.find_last_of('.') + 1);
+  if (extension == "vtex") {
+    return VTex::Load(filename, *file);
+  }
+
+  // Gray and gray-alpha images stay as one and two channels, RGB is widened
+  // to RGBA as textures have no 24-bit format. The file's channel count is
+  // kept as member value.
+  auto options = GetImageOptions(filename);
+  int size = static_cast<int>(file->GetSize());
   int width, height, channels;
-  byte* data = stbi_load(filename.c_str(), &width, &height, &channels, 4);
+  if (!stbi_info_from_memory(file->GetData(), size, &width, &height,
+                             &channels)) {
+    throw runtime_error("Failed to read image file: \"" + filename + "\"");
+  }
+
+  int components = options.channels > 0 ? options.channels : channels;
+  if (components >= 3) components = 4;
+  byte* data = stbi_load_from_memory(file->GetData(), size, &width, &height,
+                                     &channels, components);
+
   if (data == NULL) {
     throw runtime_error("Failed to read image file: \"" + filename + "\"");
   }
 
-  return make_shared<Image>(width, height, channels, data);
+  ImageFormat format = components == 1   ? kImageFormatR8
+                       : components == 2 ? kImageFormatRg8
+                                         : kImageFormatRgba8;
+  auto image = make_shared<Image>(width, height, channels, format, data);
+  MipGenerator::Generate(*image, options.mips);
+
+  ullong bytes = GetImageLevelSize(format, width, height);
+  for (const auto& level : image->mips) bytes += level.data.size();
+  total_images_++;
+  total_bytes_ += bytes;
+  total_rgba8_bytes_ += bytes / components * 4;
+
+  return image;
+}
+
+size_t ImageManager::GetAssetSize(const Image& image) const {
+  size_t size = sizeof(Image) +
+                GetImageLevelSize(image.format, image.width, image.height);
+  for (const auto& level : image.mips) size += level.data.size();
+  return size;
+}
+
+void ImageManager::SetImageOptions(const string& filename,
+                                   const ImageOptions& options) {
+  std::lock_guard<std::mutex> lock(options_mutex_);
+  options_[filename] = options;
+}
+
+ImageMemoryStats ImageManager::GetMemoryStats() const {
+  return {total_images_, total_bytes_, total_rgba8_bytes_};
+}
+
+ImageOptions ImageManager::GetImageOptions(const string& filename) {
+  std::lock_guard<std::mutex> lock(options_mutex_);
+  auto it = options_.find(filename);
+  return it != options_.end() ? it->second : ImageOptions();
 }
 }  // namespace voodoo
\ No newline at end of file
@@ -0,0 +1,258 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/io_queue.h"
+
+#include "../include/voodoo/profiler.h"
+#include "../include/voodoo/thread_pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace voodoo {
+struct IoRead {
+  struct Waiter {
+    std::chrono::steady_clock::time_point time;
+    IoCallback callback;
+  };
+
+  string filename;
+  uint priority;
+  ullong sequence;
+  bool started;
+
+  // Indexed by ticket, cancelled waiters have no callback
+  vector<Waiter> waiters;
+  uint waiting;
+};
+
+IoRequest::IoRequest() : queue_(nullptr), ticket_(0) {}
+
+bool IoRequest::Cancel() {
+  if (!queue_ || !read_) return false;
+  return queue_->Cancel(read_, ticket_);
+}
+
+IoQueue::IoQueue(uint thread_count)
+    : sequence_(0),
+      stopping_(false),
+      requests_(0),
+      coalesced_(0),
+      cancelled_(0),
+      failed_(0),
+      bytes_(0),
+      busy_time_(0),
+      latency_next_(0) {
+  // Callbacks hand decoding to the thread pool, including the ones run by
+  // the destructor. Constructing the pool first makes it outlive the queue.
+  ThreadPool::Get();
+
+  thread_count = std::max(thread_count, 1u);
+  for (uint i = 0; i < thread_count; i++)
+    threads_.emplace_back(&IoQueue::Work, this);
+}
+
+IoQueue::~IoQueue() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+
+  for (auto& thread : threads_) thread.join();
+
+  // Reads that never started still owe their callers an answer
+  for (const auto& pending : pending_) {
+    auto error = std::make_exception_ptr(std::runtime_error(
+        "I/O queue stopped: \"" + pending.second->filename + "\""));
+    for (const auto& waiter : pending.second->waiters)
+      if (waiter.callback) waiter.callback(nullptr, error);
+  }
+}
+
+IoRequest IoQueue::Read(const string& filename, IoPriority priority,
+                        IoCallback callback) {
+  IoRequest request;
+  request.queue_ = this;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_++;
+    if (reads_.empty()) busy_start_ = Clock::now();
+
+    auto& read = reads_[filename];
+    if (read) {
+      coalesced_++;
+      if (!read->started && uint(priority) < read->priority) {
+        auto node = pending_.extract({read->priority, read->sequence});
+        read->priority = priority;
+        node.key() = {read->priority, read->sequence};
+        pending_.insert(std::move(node));
+      }
+    } else {
+      read = std::make_shared<IoRead>();
+      read->filename = filename;
+      read->priority = priority;
+      read->sequence = sequence_++;
+      read->started = false;
+      read->waiting = 0;
+      pending_.emplace(Order(read->priority, read->sequence), read);
+    }
+
+    request.read_ = read;
+    request.ticket_ = uint(read->waiters.size());
+    read->waiters.push_back({Clock::now(), std::move(callback)});
+    read->waiting++;
+  }
+  condition_.notify_one();
+
+  return request;
+}
+
+IoStats IoQueue::GetStats() const {
+  IoStats stats;
+  vector<float> latencies;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.requests = requests_;
+    stats.coalesced = coalesced_;
+    stats.cancelled = cancelled_;
+    stats.failed = failed_;
+    stats.bytes = bytes_;
+
+    auto busy_time = busy_time_;
+    if (!reads_.empty()) busy_time += Clock::now() - busy_start_;
+    stats.busy_time =
+        std::chrono::duration<double, std::milli>(busy_time).count();
+
+    latencies = latencies_;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) -> double {
+    if (latencies.empty()) return 0.0;
+    return latencies[size_t(p * (latencies.size() - 1))];
+  };
+  stats.latency_p50 = percentile(0.5);
+  stats.latency_p90 = percentile(0.9);
+  stats.latency_p99 = percentile(0.99);
+  stats.latency_max = percentile(1.0);
+
+  return stats;
+}
+
+void IoQueue::ResetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  requests_ = coalesced_ = cancelled_ = failed_ = bytes_ = 0;
+  busy_time_ = Clock::duration(0);
+  busy_start_ = Clock::now();
+  latencies_.clear();
+  latency_next_ = 0;
+}
+
+bool IoQueue::Cancel(const sptr<IoRead>& read, uint ticket) {
+  IoCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (read->started || !read->waiters[ticket].callback) return false;
+
+    callback = std::move(read->waiters[ticket].callback);
+    read->waiters[ticket].callback = nullptr;
+    cancelled_++;
+
+    if (--read->waiting == 0) {
+      pending_.erase({read->priority, read->sequence});
+      reads_.erase(read->filename);
+      if (reads_.empty()) busy_time_ += Clock::now() - busy_start_;
+    }
+  }
+
+  callback(nullptr, std::make_exception_ptr(std::runtime_error(
+                        "Read cancelled: \"" + read->filename + "\"")));
+  return true;
+}
+
+void IoQueue::Work() {
+  while (true) {
+    sptr<IoRead> read;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock,
+                      [this]() { return stopping_ || !pending_.empty(); });
+      if (stopping_) return;
+
+      read = pending_.begin()->second;
+      pending_.erase(pending_.begin());
+      read->started = true;
+    }
+
+    VOODOO_PROFILE_SCOPE("IoRead");
+    sptr<FileData> file;
+    std::exception_ptr error;
+    try {
+      file = FileSystem::Read(read->filename);
+      Touch(*file);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    Complete(read, file, error);
+  }
+}
+
+void IoQueue::Complete(const sptr<IoRead>& read, sptr<FileData> file,
+                       std::exception_ptr error) {
+  vector<IoRead::Waiter> waiters;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = reads_.find(read->filename);
+    if (it != reads_.end() && it->second == read) reads_.erase(it);
+
+    auto now = Clock::now();
+    if (reads_.empty()) busy_time_ += now - busy_start_;
+
+    if (error) {
+      failed_++;
+    } else {
+      bytes_ += file->GetSize();
+    }
+
+    waiters = std::move(read->waiters);
+    for (const auto& waiter : waiters) {
+      if (!waiter.callback) continue;
+
+      float latency =
+          std::chrono::duration<float, std::milli>(now - waiter.time).count();
+      if (latencies_.size() < kLatencySampleCount) {
+        latencies_.push_back(latency);
+      } else {
+        latencies_[latency_next_] = latency;
+        latency_next_ = (latency_next_ + 1) % kLatencySampleCount;
+      }
+    }
+  }
+
+  for (const auto& waiter : waiters)
+    if (waiter.callback) waiter.callback(file, error);
+}
+
+void IoQueue::Touch(const FileData& file) {
+  constexpr size_t kPageSize = 4096;
+
+  const volatile byte* data = file.GetData();
+  byte sum = 0;
+  for (size_t i = 0; i < file.GetSize(); i += kPageSize) sum += data[i];
+  (void)sum;
+}
+}  // namespace voodoo
@@ -15,10 +15,54 @@
 
 #include "../include/voodoo/logger.h"
 
+#include "../include/voodoo/binary_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
 namespace voodoo {
-Log::Log() {
+namespace {
+// Power of two, so positions map to entries with a mask
+constexpr size_t kEntryCount = 4096;
+constexpr size_t kEntryMask = kEntryCount - 1;
+
+// Batches are written at least this often, and whenever they grow larger
+const std::chrono::milliseconds kWriteInterval(10);
+constexpr size_t kBatchSize = 64 * 1024;
+
+const char* GetPrefix(LogEntryLevel level) {
+  switch (level) {
+    case kLogEntryLevelWarning:
+      return "Warning: ";
+    case kLogEntryLevelError:
+      return "Error: ";
+    default:
+      return "";
+  }
+}
+}  // namespace
+
+Log::Log()
+    : start_(std::chrono::steady_clock::now()),
+      binary_open_(false),
+      entries_(new Entry[kEntryCount]),
+      push_position_(0),
+      pop_position_(0),
+      written_(0),
+      flush_position_(0),
+      stopping_(false),
+      overflow_policy_(kLogOverflowPolicyBlock),
+      dropped_(0) {
   log_file_.open("log.txt");
 
+  // An entry is free for the push at its sequence, and holds a message for
+  // the pop one past it
+  for (size_t i = 0; i < kEntryCount; i++)
+    entries_[i].sequence.store(i, std::memory_order_relaxed);
+
 #ifdef VOODOO_LOG_CONSOLE_ENABLED
   using namespace std;
   if (AllocConsole()) {
@@ -32,9 +76,18 @@ Log::Log() {
   cout_buffer_ = cout.rdbuf(&console_buffer_);
   cerr_buffer_ = cerr.rdbuf(&console_buffer_);
 #endif  // VOODOO_LOG_CONSOLE_ENABLED
+
+  writer_ = std::thread(&Log::Work, this);
 }
 
 Log::~Log() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  writer_.join();
+
   log_file_.close();
 
 #ifdef VOODOO_LOG_CONSOLE_ENABLED
@@ -49,47 +102,294 @@ Log& Log::Get() {
   return instance;
 }
 
+std::atomic<LogEntryLevel> Log::levels_[kLogCategoryCount] = {
+    {kLogEntryLevelInfo},
+    {kLogEntryLevelInfo},
+    {kLogEntryLevelInfo},
+    {kLogEntryLevelInfo},
+};
+
 void Log::Info(std::string message) {
-  Write(message, kLogEntryLevelInfo);
+  Write(std::move(message), kLogEntryLevelInfo);
 }
 
 void Log::Warning(std::string message) {
-  Write(message, kLogEntryLevelWarning);
+  Write(std::move(message), kLogEntryLevelWarning);
 }
 
 void Log::Error(std::string message) {
-  Write(message, kLogEntryLevelError);
+  Write(std::move(message), kLogEntryLevelError);
 }
 
 void Log::Write(std::string message) {
-  Info(message);
+  Info(std::move(message));
 }
 
 void Log::Write(std::string message, LogEntryLevel level) {
+  if (!IsEnabled(level, kLogCategoryEngine)) return;
+  Write(level, kLogCategoryEngine, nullptr, message);
+}
+
+void Log::Write(LogEntryLevel level, LogCategory category, const char* format,
+                string& text) {
+  if (!Get().Push(level, category, format, text)) return;
+
+  // Errors often come right before a crash
+  if (level == kLogEntryLevelError) Flush();
+}
+
+void Log::Throw(std::string message) {
   using namespace std;
-  string prefix;
-  switch (level) {
-    case kLogEntryLevelWarning:
-      prefix = "Warning: ";
-      break;
-    case kLogEntryLevelError:
-      prefix = "Error: ";
-      break;
-    default:
-      prefix = "";
-      break;
+  Error(message);
+  throw runtime_error(message);
+}
+
+void Log::SetLevel(LogEntryLevel level) {
+  for (auto& category_level : levels_)
+    category_level.store(level, std::memory_order_relaxed);
+}
+
+void Log::SetLevel(LogCategory category, LogEntryLevel level) {
+  levels_[category].store(level, std::memory_order_relaxed);
+}
+
+void Log::Flush() {
+  Log& log = Get();
+  std::unique_lock<std::mutex> lock(log.mutex_);
+  size_t position = log.push_position_.load(std::memory_order_acquire);
+  log.flush_position_ = std::max(log.flush_position_, position);
+  log.condition_.notify_all();
+  log.condition_.wait(lock, [&log, position]() {
+    return log.written_.load(std::memory_order_acquire) >= position;
+  });
+}
+
+bool Log::OpenBinary(const string& filename) {
+  using namespace std::chrono;
+  Log& log = Get();
+  std::lock_guard<std::mutex> lock(log.mutex_);
+  if (log.binary_) return false;
+
+  // Wall clock time of start_
+  auto since_start = steady_clock::now() - log.start_;
+  auto start_time = duration_cast<nanoseconds>(
+      system_clock::now().time_since_epoch() - since_start);
+
+  auto binary = std::make_unique<BinaryLogWriter>();
+  if (!binary->Open(filename, ullong(start_time.count()))) return false;
+
+  log.binary_ = std::move(binary);
+  log.binary_open_.store(true, std::memory_order_release);
+
+  return true;
+}
+
+void Log::SetOverflowPolicy(LogOverflowPolicy policy) {
+  Get().overflow_policy_.store(policy, std::memory_order_relaxed);
+}
+
+ullong Log::GetDroppedCount() {
+  return Get().dropped_.load(std::memory_order_relaxed);
+}
+
+uint Log::GetThreadId() {
+  // Small numbers in order of the first entry, unlike std::thread::id
+  static std::atomic<uint> next_id(0);
+  thread_local uint id = next_id++;
+  return id;
+}
+
+string& Log::GetArgumentBuffer() {
+  // Keeps its capacity, so arguments are encoded without allocating
+  thread_local string arguments;
+  return arguments;
+}
+
+bool Log::Push(LogEntryLevel level, LogCategory category, const char* format,
+               string& text) {
+  size_t position = push_position_.load(std::memory_order_relaxed);
+  Entry* entry;
+  for (;;) {
+    entry = &entries_[position & kEntryMask];
+    size_t sequence = entry->sequence.load(std::memory_order_acquire);
+    auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+    if (difference == 0) {
+      if (push_position_.compare_exchange_weak(position, position + 1,
+                                               std::memory_order_relaxed))
+        break;
+    } else if (difference < 0) {
+      // Full, the writer is a whole queue behind. Errors are never dropped.
+      if (level != kLogEntryLevelError &&
+          overflow_policy_.load(std::memory_order_relaxed) ==
+              kLogOverflowPolicyDrop) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      condition_.notify_all();
+      std::this_thread::yield();
+      position = push_position_.load(std::memory_order_relaxed);
+    } else {
+      position = push_position_.load(std::memory_order_relaxed);
+    }
+  }
+
+  entry->level = level;
+  entry->category = category;
+  entry->thread = GetThreadId();
+  entry->time = ullong(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count());
+  entry->format = format;
+  if (format) {
+    entry->text.assign(text);
+  } else {
+    entry->text = std::move(text);
   }
+  entry->sequence.store(position + 1, std::memory_order_release);
+
+  return true;
+}
+
+void Log::Work() {
+  using namespace std;
+  string batch;
+  ullong dropped = 0;
+  BinaryLogEntry binary_entry;
+  for (;;) {
+    bool binary = binary_open_.load(memory_order_acquire);
+    size_t count = 0;
+    for (;;) {
+      Entry& entry = entries_[pop_position_ & kEntryMask];
+      if (entry.sequence.load(memory_order_acquire) != pop_position_ + 1)
+        break;
+
+      if (binary) {
+        binary_entry.level = entry.level;
+        binary_entry.category = entry.category;
+        binary_entry.thread = entry.thread;
+        binary_entry.time = entry.time;
+        binary_entry.format = entry.format;
+        binary_entry.text.swap(entry.text);
+        binary_->Append(binary_entry);
+        binary_entry.text.swap(entry.text);
+      }
 
-  Get().log_file_ << prefix << message << endl;
+      if (!binary || entry.level != kLogEntryLevelInfo) {
+        batch += GetPrefix(entry.level);
+        if (entry.format) {
+          batch += LogArguments::Format(entry.format, entry.text);
+        } else {
+          batch += entry.text;
+        }
+        batch += '\n';
+      }
+      entry.text.clear();
+      entry.sequence.store(pop_position_ + kEntryCount, memory_order_release);
+      pop_position_++;
+      count++;
 
+      if (batch.size() >= kBatchSize || count == kEntryCount) break;
+    }
+
+    ullong total_dropped = dropped_.load(memory_order_relaxed);
+    if (total_dropped != dropped) {
+      batch += "Warning: " + to_string(total_dropped - dropped) +
+               " log entries dropped\n";
+      dropped = total_dropped;
+    }
+
+    if (!batch.empty()) {
+      log_file_.write(batch.data(), batch.size());
+      log_file_.flush();
 #ifdef VOODOO_LOG_CONSOLE_ENABLED
-  cout << prefix << message << endl;
+      cout << batch << flush;
 #endif  // VOODOO_LOG_CONSOLE_ENABLED
+      batch.clear();
+    }
+    if (binary) binary_->Write();
+
+    unique_lock<mutex> lock(mutex_);
+    if (count > 0) {
+      written_.fetch_add(count, memory_order_release);
+      condition_.notify_all();
+      continue;
+    }
+
+    // Stops once everything pushed before the destructor is written
+    if (stopping_ &&
+        written_.load(memory_order_relaxed) ==
+            push_position_.load(memory_order_acquire))
+      break;
+
+    // Woken early by flushes and by logging threads waiting on a full queue
+    condition_.wait_for(lock, kWriteInterval, [this]() {
+      const Entry& entry = entries_[pop_position_ & kEntryMask];
+      return stopping_ ||
+             written_.load(memory_order_relaxed) < flush_position_ ||
+             entry.sequence.load(memory_order_acquire) == pop_position_ + 1;
+    });
+  }
 }
 
-void Log::Throw(std::string message) {
+bool LogArguments::ReadVarint(const string& data, size_t& offset,
+                              ullong& value) {
+  value = 0;
+  for (uint shift = 0; shift < 64; shift += 7) {
+    if (offset >= data.size()) return false;
+    auto bits = static_cast<byte>(data[offset++]);
+    value |= ullong(bits & 0x7f) << shift;
+    if (!(bits & 0x80)) return true;
+  }
+  return false;
+}
+
+string LogArguments::Format(const char* format, const string& arguments) {
   using namespace std;
-  Error(message);
-  throw runtime_error(message);
+  string text;
+  size_t offset = 0;
+  for (const char* c = format; *c; c++) {
+    if (c[0] != '{' || c[1] != '}') {
+      text += *c;
+      continue;
+    }
+    c++;
+
+    if (offset >= arguments.size()) {
+      text += "{}";
+      continue;
+    }
+
+    // Stops at arguments cut short, which only a corrupted log has
+    auto type = static_cast<LogArgumentType>(arguments[offset++]);
+    ullong value;
+    if (type == kLogArgumentTypeDouble) {
+      double number;
+      if (sizeof(number) > arguments.size() - offset) break;
+      memcpy(&number, arguments.data() + offset, sizeof(number));
+      offset += sizeof(number);
+
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "%g", number);
+      text += buffer;
+    } else if (type == kLogArgumentTypeBool) {
+      if (offset >= arguments.size()) break;
+      text += arguments[offset++] ? "true" : "false";
+    } else if (!ReadVarint(arguments, offset, value)) {
+      break;
+    } else if (type == kLogArgumentTypeInt) {
+      text += to_string(UnZigZag(value));
+    } else if (type == kLogArgumentTypeUint) {
+      text += to_string(value);
+    } else if (type == kLogArgumentTypeString) {
+      if (value > arguments.size() - offset) break;
+      text.append(arguments, offset, size_t(value));
+      offset += size_t(value);
+    } else {
+      break;
+    }
+  }
+
+  return text;
 }
-}  // namespace voodoo
\ No newline at end of file
+}  // namespace voodoo
@@ -0,0 +1,191 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/lz.h"
+
+#include <cstring>
+
+namespace voodoo {
+namespace {
+// A sequence is a token holding 4 bits of literal length and 4 bits of
+// match length, optional length continuation bytes, the literals, a
+// 16-bit little-endian match offset and the match length continuation.
+// The last sequence has literals only.
+const uint kMinMatch = 4;
+const uint kHashBits = 14;
+const size_t kMaxOffset = 65535;
+
+// Matches stop this far from the end so the final sequence always
+// carries literals
+const size_t kLastLiterals = 5;
+
+inline uint Read32(const byte* p) {
+  uint value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint Hash(uint value) {
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+inline byte* WriteLength(byte* p, size_t length) {
+  for (; length >= 255; length -= 255) *p++ = 255;
+  *p++ = static_cast<byte>(length);
+  return p;
+}
+
+inline bool ReadLength(const byte*& p, const byte* end, size_t& length) {
+  byte value;
+  do {
+    if (p == end) return false;
+    value = *p++;
+    length += value;
+  } while (value == 255);
+  return true;
+}
+
+byte* WriteSequence(byte* p, const byte* literals, size_t literal_length,
+                    size_t offset, size_t match_length) {
+  byte* token = p++;
+  *token = static_cast<byte>(std::min<size_t>(literal_length, 15) << 4);
+  if (literal_length >= 15) p = WriteLength(p, literal_length - 15);
+
+  memcpy(p, literals, literal_length);
+  p += literal_length;
+
+  // Literal-only final sequence
+  if (match_length == 0) return p;
+
+  *p++ = static_cast<byte>(offset);
+  *p++ = static_cast<byte>(offset >> 8);
+
+  match_length -= kMinMatch;
+  *token |= static_cast<byte>(std::min<size_t>(match_length, 15));
+  if (match_length >= 15) p = WriteLength(p, match_length - 15);
+
+  return p;
+}
+}  // namespace
+
+size_t Lz::GetBound(size_t size) { return size + size / 255 + 16; }
+
+size_t Lz::Compress(const byte* source, size_t size, byte* destination) {
+  uint table[1 << kHashBits];
+  memset(table, 0, sizeof(table));
+
+  const byte* anchor = source;
+  byte* p = destination;
+
+  if (size > kMinMatch + kLastLiterals) {
+    const byte* match_limit = source + size - kLastLiterals;
+    const byte* ip = source + 1;
+
+    while (ip + kMinMatch <= match_limit) {
+      uint value = Read32(ip);
+      uint& slot = table[Hash(value)];
+      const byte* candidate = source + slot;
+      slot = static_cast<uint>(ip - source);
+
+      if (candidate >= ip || size_t(ip - candidate) > kMaxOffset ||
+          Read32(candidate) != value) {
+        ip++;
+        continue;
+      }
+
+      // Extend backwards over pending literals, then forwards
+      while (ip > anchor && candidate > source && ip[-1] == candidate[-1]) {
+        ip--;
+        candidate--;
+      }
+
+      const byte* match_end = ip + kMinMatch;
+      const byte* candidate_end = candidate + kMinMatch;
+      while (match_end < match_limit && *match_end == *candidate_end) {
+        match_end++;
+        candidate_end++;
+      }
+
+      p = WriteSequence(p, anchor, ip - anchor, ip - candidate,
+                        match_end - ip);
+
+      // Positions inside the match are only partially indexed
+      if (match_end - 2 > source)
+        table[Hash(Read32(match_end - 2))] =
+            static_cast<uint>(match_end - 2 - source);
+      ip = anchor = match_end;
+    }
+  }
+
+  p = WriteSequence(p, anchor, source + size - anchor, 0, 0);
+
+  return p - destination;
+}
+
+bool Lz::Decompress(const byte* source, size_t size, byte* destination,
+                    size_t destination_size) {
+  const byte* ip = source;
+  const byte* end = source + size;
+  byte* op = destination;
+  byte* op_end = destination + destination_size;
+
+  while (ip < end) {
+    byte token = *ip++;
+
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(ip, end, literal_length))
+      return false;
+    if (literal_length > size_t(end - ip) ||
+        literal_length > size_t(op_end - op)) {
+      return false;
+    }
+
+    // Short runs are copied with fixed size moves when there is room to
+    // spare at both ends
+    if (literal_length <= 16 && end - ip >= 16 && op_end - op >= 16) {
+      memcpy(op, ip, 16);
+    } else if (literal_length > 0) {
+      memcpy(op, ip, literal_length);
+    }
+    ip += literal_length;
+    op += literal_length;
+
+    // The final sequence ends the block without a match
+    if (ip == end) break;
+
+    if (end - ip < 2) return false;
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > size_t(op - destination)) return false;
+
+    size_t match_length = token & 15;
+    if (match_length == 15 && !ReadLength(ip, end, match_length))
+      return false;
+    match_length += kMinMatch;
+    if (match_length > size_t(op_end - op)) return false;
+
+    // Overlapping matches repeat the preceding bytes
+    const byte* match = op - offset;
+    if (offset >= 8 && size_t(op_end - op) >= match_length + 8) {
+      for (size_t i = 0; i < match_length; i += 8) memcpy(op + i, match + i, 8);
+      op += match_length;
+    } else {
+      for (size_t i = 0; i < match_length; i++) *op++ = *match++;
+    }
+  }
+
+  return op == op_end;
+}
+}  // namespace voodoo
@@ -0,0 +1,117 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+#include <stdexcept>
+
+namespace voodoo {
+#ifdef _WIN32
+MappedFile::MappedFile(const string& filename)
+    : file_(INVALID_HANDLE_VALUE),
+      mapping_(nullptr),
+      data_(nullptr),
+      size_(0) {
+  using namespace std;
+  // Writers move files aside while they are mapped, see FileSystem::Write
+  file_ = CreateFileA(filename.c_str(), GENERIC_READ,
+                      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                      nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                      nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) {
+    throw runtime_error("Failed to open file: \"" + filename + "\"");
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file_, &size)) {
+    CloseHandle(file_);
+    throw runtime_error("Failed to get file size: \"" + filename + "\"");
+  }
+  size_ = static_cast<size_t>(size.QuadPart);
+
+  // Empty files can't be mapped
+  if (size_ == 0) return;
+
+  mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping_) {
+    CloseHandle(file_);
+    throw runtime_error("Failed to map file: \"" + filename + "\"");
+  }
+
+  data_ = static_cast<const byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if (!data_) {
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+    throw runtime_error("Failed to map file view: \"" + filename + "\"");
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data_) UnmapViewOfFile(data_);
+  if (mapping_) CloseHandle(mapping_);
+  if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+}
+#else
+MappedFile::MappedFile(const string& filename)
+    : descriptor_(-1),
+      data_(nullptr),
+      size_(0) {
+  using namespace std;
+  descriptor_ = open(filename.c_str(), O_RDONLY);
+  if (descriptor_ < 0) {
+    throw runtime_error("Failed to open file: \"" + filename + "\"");
+  }
+
+  struct stat info;
+  if (fstat(descriptor_, &info) != 0) {
+    close(descriptor_);
+    throw runtime_error("Failed to get file size: \"" + filename + "\"");
+  }
+  size_ = static_cast<size_t>(info.st_size);
+
+  // Empty files can't be mapped
+  if (size_ == 0) return;
+
+  void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor_, 0);
+  if (data == MAP_FAILED) {
+    close(descriptor_);
+    throw runtime_error("Failed to map file: \"" + filename + "\"");
+  }
+  data_ = static_cast<const byte*>(data);
+}
+
+MappedFile::~MappedFile() {
+  if (data_) munmap(const_cast<byte*>(data_), size_);
+  if (descriptor_ >= 0) close(descriptor_);
+}
+#endif  // _WIN32
+
+const byte* MappedFile::GetData() const {
+  return data_;
+}
+
+size_t MappedFile::GetSize() const {
+  return size_;
+}
+}  // namespace voodoo
@@ -0,0 +1,343 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/memory_tracker.h"
+
+#include "../include/voodoo/logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#if !defined VOODOO_MEMORY_TRACKING && defined _DEBUG
+#define VOODOO_MEMORY_TRACKING
+#endif
+
+#if defined VOODOO_MEMORY_TRACKING && defined _WIN32 && defined _DEBUG
+#define VOODOO_MEMORY_CALLSTACKS
+// CaptureStackBackTrace()
+#include <windows.h>
+#endif
+
+namespace voodoo {
+namespace {
+// Precedes every tracked block
+struct AllocationHeader {
+  void* block;
+  size_t size;
+  MemoryTag tag;
+};
+
+// Constant initialized, so usable by allocations before main()
+struct TagCounters {
+  std::atomic<llong> live_bytes;
+  std::atomic<ullong> peak_bytes;
+  std::atomic<llong> live_allocations;
+  std::atomic<ullong> allocations;
+  std::atomic<ullong> frame_allocations, frame_bytes;
+  std::atomic<ullong> last_frame_allocations, last_frame_bytes;
+};
+
+TagCounters counters[kMemoryTagCount];
+thread_local MemoryTag current_tag = kMemoryTagGeneral;
+
+const char* kTagNames[] = {"General", "Meshes", "Images", "Components",
+                           "Network"};
+
+#ifdef VOODOO_MEMORY_CALLSTACKS
+// Allocations this large always have their stack kept, others one in
+// kStackSampleInterval
+constexpr size_t kStackSampleSize = 64 * 1024;
+constexpr ullong kStackSampleInterval = 1024;
+constexpr uint kStackDepth = 16;
+constexpr uint kStackCount = 256;
+
+struct StackSample {
+  ulong hash;
+  MemoryTag tag;
+  void* frames[kStackDepth];
+  uint16 frame_count;
+  ullong allocations, bytes;
+};
+
+// Filled under a spin lock, a mutex could allocate
+StackSample stacks[kStackCount];
+std::atomic_flag stacks_lock = ATOMIC_FLAG_INIT;
+std::atomic<ullong> stack_counter(0);
+
+void SampleStack(size_t size, MemoryTag tag) {
+  if (size < kStackSampleSize &&
+      stack_counter.fetch_add(1, std::memory_order_relaxed) %
+              kStackSampleInterval != 0)
+    return;
+
+  void* frames[kStackDepth];
+  ulong hash;
+  uint16 frame_count = CaptureStackBackTrace(2, kStackDepth, frames, &hash);
+
+  while (stacks_lock.test_and_set(std::memory_order_acquire)) {
+  }
+  for (auto& stack : stacks) {
+    if (stack.allocations == 0) {
+      stack.hash = hash;
+      stack.tag = tag;
+      std::copy(frames, frames + frame_count, stack.frames);
+      stack.frame_count = frame_count;
+    } else if (stack.hash != hash || stack.tag != tag) {
+      continue;
+    }
+    stack.allocations++;
+    stack.bytes += size;
+    break;
+  }
+  stacks_lock.clear(std::memory_order_release);
+}
+#endif  // VOODOO_MEMORY_CALLSTACKS
+}  // namespace
+
+MemoryScope::MemoryScope(MemoryTag tag) : previous_(current_tag) {
+  current_tag = tag;
+}
+
+MemoryScope::~MemoryScope() { current_tag = previous_; }
+
+void* MemoryTracker::Allocate(size_t size, size_t alignment, MemoryTag tag) {
+  using namespace std;
+  alignment = max(alignment, alignof(max_align_t));
+  void* block = malloc(sizeof(AllocationHeader) + alignment - 1 + size);
+  if (!block) return nullptr;
+
+  auto address = reinterpret_cast<uintptr_t>(block) + sizeof(AllocationHeader);
+  address = (address + alignment - 1) & ~uintptr_t(alignment - 1);
+  auto header = reinterpret_cast<AllocationHeader*>(address) - 1;
+  header->block = block;
+  header->size = size;
+  header->tag = tag;
+
+  TagCounters& tag_counters = counters[tag];
+  llong live = tag_counters.live_bytes.fetch_add(llong(size),
+                                                 memory_order_relaxed) +
+               llong(size);
+  ullong peak = tag_counters.peak_bytes.load(memory_order_relaxed);
+  while (live > 0 && ullong(live) > peak &&
+         !tag_counters.peak_bytes.compare_exchange_weak(
+             peak, ullong(live), memory_order_relaxed)) {
+  }
+  tag_counters.live_allocations.fetch_add(1, memory_order_relaxed);
+  tag_counters.allocations.fetch_add(1, memory_order_relaxed);
+  tag_counters.frame_allocations.fetch_add(1, memory_order_relaxed);
+  tag_counters.frame_bytes.fetch_add(size, memory_order_relaxed);
+
+#ifdef VOODOO_MEMORY_CALLSTACKS
+  SampleStack(size, tag);
+#endif
+
+  return reinterpret_cast<void*>(address);
+}
+
+void MemoryTracker::Free(void* pointer) {
+  if (!pointer) return;
+
+  auto header = static_cast<AllocationHeader*>(pointer) - 1;
+  TagCounters& tag_counters = counters[header->tag];
+  tag_counters.live_bytes.fetch_sub(llong(header->size),
+                                    std::memory_order_relaxed);
+  tag_counters.live_allocations.fetch_sub(1, std::memory_order_relaxed);
+
+  free(header->block);
+}
+
+MemoryTag MemoryTracker::GetCurrentTag() { return current_tag; }
+
+bool MemoryTracker::IsHooked() {
+#ifdef VOODOO_MEMORY_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+void MemoryTracker::EndFrame() {
+  for (auto& tag_counters : counters) {
+    tag_counters.last_frame_allocations.store(
+        tag_counters.frame_allocations.exchange(0, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    tag_counters.last_frame_bytes.store(
+        tag_counters.frame_bytes.exchange(0, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+}
+
+MemoryTagStats MemoryTracker::GetStats(MemoryTag tag) {
+  const TagCounters& tag_counters = counters[tag];
+  MemoryTagStats stats;
+  stats.name = kTagNames[tag];
+  stats.live_bytes = tag_counters.live_bytes.load(std::memory_order_relaxed);
+  stats.peak_bytes = tag_counters.peak_bytes.load(std::memory_order_relaxed);
+  stats.live_allocations =
+      tag_counters.live_allocations.load(std::memory_order_relaxed);
+  stats.allocations = tag_counters.allocations.load(std::memory_order_relaxed);
+  stats.frame_allocations =
+      tag_counters.last_frame_allocations.load(std::memory_order_relaxed);
+  stats.frame_bytes =
+      tag_counters.last_frame_bytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+vector<MemoryTagStats> MemoryTracker::GetReport() {
+  vector<MemoryTagStats> report;
+  for (int i = 0; i < kMemoryTagCount; i++)
+    report.push_back(GetStats(static_cast<MemoryTag>(i)));
+  return report;
+}
+
+ullong MemoryTracker::GetFrameAllocationCount() {
+  ullong allocations = 0;
+  for (const auto& tag_counters : counters)
+    allocations +=
+        tag_counters.last_frame_allocations.load(std::memory_order_relaxed);
+  return allocations;
+}
+
+void MemoryTracker::Dump() {
+  VOODOO_LOG_INFO(kLogCategoryEngine, "Memory, {}:",
+                  IsHooked() ? "every allocation"
+                             : "tagged allocators only");
+  for (const auto& stats : GetReport()) {
+    VOODOO_LOG_INFO(kLogCategoryEngine,
+                    "{}: {} KB in {} blocks, peak {} KB, {} allocations, "
+                    "last frame {} allocations of {} bytes",
+                    stats.name, stats.live_bytes / 1024,
+                    stats.live_allocations, stats.peak_bytes / 1024,
+                    stats.allocations, stats.frame_allocations,
+                    stats.frame_bytes);
+  }
+
+#ifdef VOODOO_MEMORY_CALLSTACKS
+  // Copied first, logging allocates
+  vector<StackSample> samples;
+  while (stacks_lock.test_and_set(std::memory_order_acquire)) {
+  }
+  for (const auto& stack : stacks) {
+    if (stack.allocations > 0) samples.push_back(stack);
+  }
+  stacks_lock.clear(std::memory_order_release);
+
+  std::sort(samples.begin(), samples.end(),
+            [](const StackSample& a, const StackSample& b) {
+              return a.bytes > b.bytes;
+            });
+  samples.resize(std::min(samples.size(), size_t(8)));
+  for (const auto& sample : samples) {
+    string frames;
+    for (uint16 i = 0; i < sample.frame_count; i++) {
+      char address[24];
+      snprintf(address, sizeof(address), " %p", sample.frames[i]);
+      frames += address;
+    }
+    VOODOO_LOG_INFO(kLogCategoryEngine,
+                    "Sampled {}: {} allocations of {} bytes from{}",
+                    kTagNames[sample.tag], sample.allocations, sample.bytes,
+                    frames);
+  }
+#endif  // VOODOO_MEMORY_CALLSTACKS
+}
+}  // namespace voodoo
+
+#ifdef VOODOO_MEMORY_TRACKING
+// Replacements of the global allocation functions. The non-throwing and
+// array forms of operator delete forward to these by default, but not on
+// every standard library, so all of them are replaced.
+namespace {
+void* AllocateTracked(size_t size, size_t alignment) {
+  using namespace voodoo;
+  void* pointer = MemoryTracker::Allocate(size ? size : 1, alignment,
+                                          MemoryTracker::GetCurrentTag());
+  if (!pointer) throw std::bad_alloc();
+  return pointer;
+}
+}  // namespace
+
+void* operator new(size_t size) {
+  return AllocateTracked(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](size_t size) {
+  return AllocateTracked(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  return AllocateTracked(size, size_t(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return AllocateTracked(size, size_t(alignment));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return voodoo::MemoryTracker::Allocate(
+      size ? size : 1, __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+      voodoo::MemoryTracker::GetCurrentTag());
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return voodoo::MemoryTracker::Allocate(
+      size ? size : 1, __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+      voodoo::MemoryTracker::GetCurrentTag());
+}
+
+void operator delete(void* pointer) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+
+void operator delete(void* pointer, size_t size) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer, size_t size) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+
+void operator delete(void* pointer, size_t size,
+                     std::align_val_t alignment) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer, size_t size,
+                       std::align_val_t alignment) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+  voodoo::MemoryTracker::Free(pointer);
+}
+#endif  // VOODOO_MEMORY_TRACKING
@@ -15,30 +15,53 @@
 
 #include "../include/voodoo/mesh_manager.h"
 
-#include <fstream>
+#include "../include/voodoo/memory_tracker.h"
+#include "../include/voodoo/profiler.h"
+#include "../include/voodoo/vmesh.h"
 
-namespace voodoo {
-sptr<Mesh> MeshManager::Load(const string& filename) {
-  using namespace std;
-  ifstream fin;
-  fin.open(filename);
+#include <sstream>
 
-  if (fin.fail()) {
-    throw runtime_error("Failed to process mesh file: \"" + filename + "\"");
+namespace voodoo {
+sptr<Mesh> MeshManager::Load(const string& filename, sptr<FileData> file) {
+  VOODOO_PROFILE_SCOPE("LoadMesh");
+  MemoryScope memory_scope(kMemoryTagMeshes);
+  auto extension = filename.substr(filename.find_last_of('.') + 1);
+  if (extension == "vmesh") {
+    return VMesh::Load(filename, file);
   }
 
-  char input;
-  unsigned long v_count;
+  return LoadText(filename, *file);
+}
 
-  fin.get(input);
-  while (input != ':') fin.get(input);
+size_t MeshManager::GetAssetSize(const Mesh& mesh) const {
+  return sizeof(Mesh) +
+         static_cast<size_t>(mesh.GetVertexStride()) * mesh.vertex_count +
+         sizeof(uint) * mesh.index_count +
+         sizeof(MeshSubset) * mesh.subsets.size();
+}
 
-  fin >> v_count;
+sptr<Mesh> MeshManager::LoadText(const string& filename,
+                                 const FileData& file) {
+  using namespace std;
+  istringstream fin(string(reinterpret_cast<const char*>(file.GetData()),
+                           file.GetSize()));
 
-  fin.get(input);
-  while (input != ':') fin.get(input);
-  fin.get(input);
-  fin.get(input);
+  // Header is a list of "Label: value" lines terminated by "Data:".
+  // Index Count is optional, meshes without it are not indexed.
+  string label;
+  uint v_count = 0;
+  uint i_count = 0;
+  while (getline(fin >> ws, label, ':') && label != "Data") {
+    if (label == "Vertex Count") {
+      fin >> v_count;
+    } else if (label == "Index Count") {
+      fin >> i_count;
+    }
+  }
+
+  if (fin.fail()) {
+    throw runtime_error("Invalid mesh file header: \"" + filename + "\"");
+  }
 
   vector<vertex_ptn> vertices;
   vertices.resize(v_count);
@@ -50,7 +73,21 @@ sptr<Mesh> MeshManager::Load(const string& filename) {
     fin >> vertices[i].normal.x >> vertices[i].normal.y >> vertices[i].normal.z;
   }
 
-  fin.close();
+  if (i_count > 0) {
+    getline(fin >> ws, label, ':');
+    if (label != "Indices") {
+      throw runtime_error("Missing mesh indices: \"" + filename + "\"");
+    }
+
+    vector<uint> indices;
+    indices.resize(i_count);
+
+    for (unsigned int i = 0; i < i_count; i++) {
+      fin >> indices[i];
+    }
+
+    return make_shared<Mesh>(vertices, indices);
+  }
 
   return make_shared<Mesh>(vertices);
 }
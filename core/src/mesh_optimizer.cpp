@@ -0,0 +1,342 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace voodoo {
+namespace {
+const uint kInvalidIndex = ~0u;
+
+// Tuning values from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+const uint kForsythCacheSize = 32;
+const float kCacheDecayPower = 1.5f;
+const float kLastFaceScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+float GetVertexScore(int cache_position, uint remaining_valence) {
+  if (remaining_valence == 0) return -1.0f;
+
+  float score = 0.0f;
+  if (cache_position >= 0) {
+    if (cache_position < 3) {
+      score = kLastFaceScore;
+    } else {
+      float scaler = 1.0f / (kForsythCacheSize - 3);
+      score = 1.0f - (cache_position - 3) * scaler;
+      score = std::pow(score, kCacheDecayPower);
+    }
+  }
+
+  score += kValenceBoostScale *
+           std::pow(static_cast<float>(remaining_valence), -kValenceBoostPower);
+  return score;
+}
+
+// FIFO post-transform cache model. A vertex is resident while fewer than
+// cache size misses have happened since it was last loaded.
+class FifoCache {
+ public:
+  FifoCache(uint vertex_count, uint size)
+      : timestamps_(vertex_count, 0), time_(size + 1), size_(size) {}
+
+  uint Access(uint vertex) {
+    if (time_ - timestamps_[vertex] > size_) {
+      timestamps_[vertex] = time_++;
+      return 1;
+    }
+    return 0;
+  }
+
+  uint AccessFace(const uint* face) {
+    return Access(face[0]) + Access(face[1]) + Access(face[2]);
+  }
+
+  void Reset() { time_ += size_ + 1; }
+
+ private:
+  vector<uint> timestamps_;
+  uint time_;
+  uint size_;
+};
+}  // namespace
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const Mesh& mesh,
+                                                   uint cache_size) {
+  VertexCacheStats stats;
+  uint face_count = mesh.index_count / 3;
+  if (face_count == 0 || mesh.vertex_count == 0) return stats;
+
+  const uint* indices = mesh.GetIndexData();
+  FifoCache cache(mesh.vertex_count, cache_size);
+  uint misses = 0;
+  for (uint i = 0; i < face_count; i++) {
+    misses += cache.AccessFace(&indices[i * 3]);
+  }
+
+  stats.acmr = static_cast<float>(misses) / face_count;
+  stats.atvr = static_cast<float>(misses) / mesh.vertex_count;
+  return stats;
+}
+
+void MeshOptimizer::Optimize(Mesh& mesh) {
+  OptimizeVertexCache(mesh);
+  OptimizeOverdraw(mesh);
+  OptimizeVertexFetch(mesh);
+}
+
+void MeshOptimizer::OptimizeVertexCache(Mesh& mesh) {
+  using namespace std;
+  const uint face_count = mesh.index_count / 3;
+  const uint vertex_count = mesh.vertex_count;
+  if (face_count == 0 || mesh.IsMapped()) return;
+
+  const auto& indices = mesh.indices;
+
+  // Vertex to face adjacency, only faces not emitted yet are kept
+  vector<uint> valence(vertex_count, 0);
+  for (uint i = 0; i < face_count * 3; i++) valence[indices[i]]++;
+
+  vector<uint> offsets(vertex_count + 1, 0);
+  for (uint v = 0; v < vertex_count; v++) offsets[v + 1] = offsets[v] + valence[v];
+
+  vector<uint> adjacency(face_count * 3);
+  vector<uint> fill(offsets.begin(), offsets.end() - 1);
+  for (uint f = 0; f < face_count; f++) {
+    for (uint k = 0; k < 3; k++) adjacency[fill[indices[f * 3 + k]]++] = f;
+  }
+
+  vector<int> cache_position(vertex_count, -1);
+  vector<float> vertex_score(vertex_count);
+  for (uint v = 0; v < vertex_count; v++) {
+    vertex_score[v] = GetVertexScore(-1, valence[v]);
+  }
+
+  vector<float> face_score(face_count);
+  vector<bool> emitted(face_count, false);
+  uint best_face = 0;
+  for (uint f = 0; f < face_count; f++) {
+    face_score[f] = vertex_score[indices[f * 3]] +
+                    vertex_score[indices[f * 3 + 1]] +
+                    vertex_score[indices[f * 3 + 2]];
+    if (face_score[f] > face_score[best_face]) best_face = f;
+  }
+
+  vector<uint> cache, next_cache;
+  cache.reserve(kForsythCacheSize + 3);
+  next_cache.reserve(kForsythCacheSize + 3);
+
+  vector<uint> result;
+  result.reserve(face_count * 3);
+
+  uint scan_cursor = 0;
+  for (uint emitted_count = 0; emitted_count < face_count; emitted_count++) {
+    if (best_face == kInvalidIndex) {
+      // Nothing adjacent to the cache is left, restart from the next
+      // unprocessed face in the original order
+      while (emitted[scan_cursor]) scan_cursor++;
+      best_face = scan_cursor;
+    }
+
+    const uint* face = &indices[best_face * 3];
+    emitted[best_face] = true;
+    result.insert(result.end(), face, face + 3);
+
+    for (uint k = 0; k < 3; k++) {
+      uint v = face[k];
+      auto begin = adjacency.begin() + offsets[v];
+      auto end = begin + valence[v];
+      auto it = find(begin, end, best_face);
+      *it = *(end - 1);
+      valence[v]--;
+    }
+
+    next_cache.clear();
+    for (uint k = 0; k < 3; k++) {
+      if (find(next_cache.begin(), next_cache.end(), face[k]) == next_cache.end())
+        next_cache.push_back(face[k]);
+    }
+    for (auto v : cache) {
+      if (v != face[0] && v != face[1] && v != face[2]) next_cache.push_back(v);
+    }
+
+    // Vertices pushed out of the cache keep their entries in next_cache
+    // until scores are updated, then the cache is trimmed
+    for (uint i = 0; i < next_cache.size(); i++) {
+      uint v = next_cache[i];
+      cache_position[v] = i < kForsythCacheSize ? static_cast<int>(i) : -1;
+
+      float score = GetVertexScore(cache_position[v], valence[v]);
+      float delta = score - vertex_score[v];
+      vertex_score[v] = score;
+
+      for (uint j = offsets[v]; j < offsets[v] + valence[v]; j++) {
+        face_score[adjacency[j]] += delta;
+      }
+    }
+
+    if (next_cache.size() > kForsythCacheSize) next_cache.resize(kForsythCacheSize);
+    cache.swap(next_cache);
+
+    best_face = kInvalidIndex;
+    float best_score = -1.0f;
+    for (auto v : cache) {
+      for (uint j = offsets[v]; j < offsets[v] + valence[v]; j++) {
+        uint f = adjacency[j];
+        if (face_score[f] > best_score) {
+          best_score = face_score[f];
+          best_face = f;
+        }
+      }
+    }
+  }
+
+  mesh.indices.swap(result);
+  mesh.index_count = static_cast<uint>(mesh.indices.size());
+}
+
+void MeshOptimizer::OptimizeOverdraw(Mesh& mesh, float threshold) {
+  using namespace std;
+  const uint face_count = mesh.index_count / 3;
+  if (face_count == 0 || mesh.vertex_format != kVertexFormatPtn || mesh.IsMapped()) return;
+
+  const auto& indices = mesh.indices;
+  FifoCache cache(mesh.vertex_count, kCacheSize);
+
+  // Hard boundaries are faces where the cache is already cold, so the
+  // order can be broken there without any cost
+  vector<uint> hard_clusters;
+  for (uint f = 0; f < face_count; f++) {
+    if (cache.AccessFace(&indices[f * 3]) == 3) hard_clusters.push_back(f);
+  }
+  if (hard_clusters.empty() || hard_clusters[0] != 0) {
+    hard_clusters.insert(hard_clusters.begin(), 0);
+  }
+
+  // Soft boundaries split hard clusters further while the running ACMR
+  // stays under threshold times the ACMR of the whole hard cluster
+  vector<uint> clusters;
+  for (uint c = 0; c < hard_clusters.size(); c++) {
+    uint start = hard_clusters[c];
+    uint end = c + 1 < hard_clusters.size() ? hard_clusters[c + 1] : face_count;
+
+    cache.Reset();
+    uint cluster_misses = 0;
+    for (uint f = start; f < end; f++) {
+      cluster_misses += cache.AccessFace(&indices[f * 3]);
+    }
+    float cluster_threshold = threshold * cluster_misses / (end - start);
+
+    cache.Reset();
+    clusters.push_back(start);
+    uint running_misses = 0;
+    uint running_faces = 0;
+    for (uint f = start; f < end; f++) {
+      running_misses += cache.AccessFace(&indices[f * 3]);
+      running_faces++;
+
+      if (f + 1 < end && running_misses <= cluster_threshold * running_faces) {
+        clusters.push_back(f + 1);
+        cache.Reset();
+        running_misses = 0;
+        running_faces = 0;
+      }
+    }
+  }
+
+  // View-independent sort key: clusters facing away from the mesh centre
+  // are likely to occlude the rest, so they are drawn first
+  const uint cluster_count = static_cast<uint>(clusters.size());
+  vector<vec3f> centroids(cluster_count, kVec3fZeros);
+  vector<vec3f> normals(cluster_count, kVec3fZeros);
+  vec3f mesh_centroid = kVec3fZeros;
+  float mesh_area = 0.0f;
+
+  for (uint c = 0; c < cluster_count; c++) {
+    uint start = clusters[c];
+    uint end = c + 1 < cluster_count ? clusters[c + 1] : face_count;
+
+    float cluster_area = 0.0f;
+    for (uint f = start; f < end; f++) {
+      const auto& p0 = mesh.vertices[indices[f * 3]].position;
+      const auto& p1 = mesh.vertices[indices[f * 3 + 1]].position;
+      const auto& p2 = mesh.vertices[indices[f * 3 + 2]].position;
+
+      auto normal = cross(p1 - p0, p2 - p0);
+      float area = normal.Length();
+
+      centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+      normals[c] += normal;
+      cluster_area += area;
+    }
+
+    mesh_centroid += centroids[c];
+    mesh_area += cluster_area;
+    if (cluster_area > 0.0f) centroids[c] /= cluster_area;
+  }
+  if (mesh_area > 0.0f) mesh_centroid /= mesh_area;
+
+  vector<float> sort_keys(cluster_count, 0.0f);
+  for (uint c = 0; c < cluster_count; c++) {
+    float length = normals[c].Length();
+    if (length > 0.0f) {
+      sort_keys[c] = vec3f::DotProduct(centroids[c] - mesh_centroid,
+                                       normals[c] / length);
+    }
+  }
+
+  vector<uint> order(cluster_count);
+  for (uint c = 0; c < cluster_count; c++) order[c] = c;
+  stable_sort(order.begin(), order.end(), [&sort_keys](uint l, uint r) {
+    return sort_keys[l] > sort_keys[r];
+  });
+
+  vector<uint> result;
+  result.reserve(face_count * 3);
+  for (auto c : order) {
+    uint start = clusters[c];
+    uint end = c + 1 < cluster_count ? clusters[c + 1] : face_count;
+    result.insert(result.end(),
+                  indices.begin() + start * 3,
+                  indices.begin() + end * 3);
+  }
+
+  mesh.indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(Mesh& mesh) {
+  if (mesh.vertex_format != kVertexFormatPtn || mesh.IsMapped()) return;
+
+  vector<uint> remap(mesh.vertex_count, kInvalidIndex);
+  vector<vertex_ptn> vertices;
+  vertices.reserve(mesh.vertex_count);
+
+  for (uint i = 0; i < mesh.index_count; i++) {
+    uint& index = mesh.indices[i];
+    if (remap[index] == kInvalidIndex) {
+      remap[index] = static_cast<uint>(vertices.size());
+      vertices.push_back(mesh.vertices[index]);
+    }
+    index = remap[index];
+  }
+
+  // Vertices not referenced by any face are dropped
+  mesh.vertices.swap(vertices);
+  mesh.vertex_count = static_cast<uint>(mesh.vertices.size());
+}
+}  // namespace voodoo
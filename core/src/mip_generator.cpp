@@ -0,0 +1,432 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/mip_generator.h"
+
+#include "../include/voodoo/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VOODOO_MIP_SSE
+#endif
+
+namespace voodoo {
+namespace {
+constexpr int kRowsPerTask = 16;
+
+// In destination pixels
+constexpr float kKaiserRadius = 2.0f;
+constexpr float kKaiserAlpha = 4.0f;
+
+constexpr int kSrgbTableSize = 16384;
+constexpr int kHistogramSize = 4096;
+
+std::atomic<ullong> total_images(0), total_pixels(0), total_nanoseconds(0);
+
+struct Tables {
+  Tables() {
+    for (int i = 0; i < 256; i++) {
+      float value = i / 255.0f;
+      unorm[i] = value;
+      identity[i] = byte(i);
+      linear[i] = value <= 0.04045f
+                      ? value / 12.92f
+                      : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    for (int i = 0; i < kSrgbTableSize; i++) {
+      float value = i / float(kSrgbTableSize - 1);
+      value = value <= 0.0031308f
+                  ? value * 12.92f
+                  : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+      srgb[i] = byte(value * 255.0f + 0.5f);
+    }
+  }
+
+  float unorm[256];
+  float linear[256];
+  byte identity[256];
+  byte srgb[kSrgbTableSize];
+};
+
+const Tables& GetTables() {
+  static Tables tables;
+  return tables;
+}
+
+// Four channel pixel arithmetic
+#ifdef VOODOO_MIP_SSE
+typedef __m128 Pixel;
+
+inline Pixel LoadPixel(const float* source) { return _mm_loadu_ps(source); }
+inline void StorePixel(float* target, Pixel pixel) {
+  _mm_storeu_ps(target, pixel);
+}
+inline Pixel ZeroPixel() { return _mm_setzero_ps(); }
+inline Pixel AddPixels(Pixel a, Pixel b) { return _mm_add_ps(a, b); }
+inline Pixel ScalePixel(Pixel pixel, float weight) {
+  return _mm_mul_ps(pixel, _mm_set1_ps(weight));
+}
+#else
+struct Pixel {
+  float v[4];
+};
+
+inline Pixel LoadPixel(const float* source) {
+  return {{source[0], source[1], source[2], source[3]}};
+}
+inline void StorePixel(float* target, Pixel pixel) {
+  for (int i = 0; i < 4; i++) target[i] = pixel.v[i];
+}
+inline Pixel ZeroPixel() { return {{0.0f, 0.0f, 0.0f, 0.0f}}; }
+inline Pixel AddPixels(Pixel a, Pixel b) {
+  return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+inline Pixel ScalePixel(Pixel pixel, float weight) {
+  return {{pixel.v[0] * weight, pixel.v[1] * weight, pixel.v[2] * weight,
+           pixel.v[3] * weight}};
+}
+#endif
+
+// Linear values, four floats per pixel
+struct Level {
+  int width, height;
+  vector<float> data;
+};
+
+// Filter taps of one axis, count weights for every destination pixel
+struct Taps {
+  int count;
+  vector<int> first;
+  vector<float> weights;
+};
+
+void ParallelRows(int height, const std::function<void(int, int)>& task) {
+  size_t bands = (height + kRowsPerTask - 1) / kRowsPerTask;
+  ThreadPool::Get().ParallelFor(bands, [&](size_t band) {
+    int begin = int(band) * kRowsPerTask;
+    task(begin, std::min(begin + kRowsPerTask, height));
+  });
+}
+
+// Single and dual channel formats hold data rather than colour, so they are
+// always filtered as stored
+bool IsLinearized(int channel, int components, const MipOptions& options) {
+  return options.srgb && components >= 3 && channel < 3 &&
+         channel != options.coverage_channel;
+}
+
+void Decode(const Image& image, const MipOptions& options, Level& level) {
+  const Tables& tables = GetTables();
+  level.width = image.width;
+  level.height = image.height;
+  level.data.resize(size_t(image.width) * image.height * 4);
+
+  // The working level is always four floats wide, missing channels stay zero
+  int components = GetComponentCount(image.format);
+  const float* table[4];
+  for (int c = 0; c < 4; c++) {
+    table[c] = IsLinearized(c, components, options) ? tables.linear
+                                                    : tables.unorm;
+  }
+
+  ParallelRows(image.height, [&](int begin, int end) {
+    size_t first = size_t(begin) * image.width;
+    size_t last = size_t(end) * image.width;
+    if (components == 4) {
+      for (size_t i = first * 4; i < last * 4; i += 4) {
+        for (int c = 0; c < 4; c++)
+          level.data[i + c] = table[c][image.data[i + c]];
+      }
+      return;
+    }
+    for (size_t p = first; p < last; p++) {
+      const byte* source = &image.data[p * components];
+      float* target = &level.data[p * 4];
+      for (int c = 0; c < 4; c++)
+        target[c] = c < components ? table[c][source[c]] : 0.0f;
+    }
+  });
+}
+
+void DownsampleBox(const Level& source, Level& target) {
+  ParallelRows(target.height, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      int y0 = std::min(2 * y, source.height - 1);
+      int y1 = std::min(2 * y + 1, source.height - 1);
+      const float* row0 = &source.data[size_t(y0) * source.width * 4];
+      const float* row1 = &source.data[size_t(y1) * source.width * 4];
+      float* output = &target.data[size_t(y) * target.width * 4];
+
+      for (int x = 0; x < target.width; x++) {
+        int x0 = std::min(2 * x, source.width - 1) * 4;
+        int x1 = std::min(2 * x + 1, source.width - 1) * 4;
+        Pixel top = AddPixels(LoadPixel(row0 + x0), LoadPixel(row0 + x1));
+        Pixel bottom = AddPixels(LoadPixel(row1 + x0), LoadPixel(row1 + x1));
+        Pixel sum = AddPixels(top, bottom);
+        StorePixel(output + x * 4, ScalePixel(sum, 0.25f));
+      }
+    }
+  });
+}
+
+float BesselI0(float x) {
+  float sum = 1.0f, term = 1.0f;
+  for (int k = 1; k < 32 && term > sum * 1e-7f; k++) {
+    term *= (x * x * 0.25f) / float(k * k);
+    sum += term;
+  }
+  return sum;
+}
+
+float Sinc(float x) {
+  const float kPi = 3.14159265358979f;
+  if (std::fabs(x) < 1e-5f) return 1.0f;
+  return std::sin(kPi * x) / (kPi * x);
+}
+
+void BuildKaiserTaps(int source_size, int target_size, Taps& taps) {
+  float scale = float(source_size) / float(target_size);
+  float support = kKaiserRadius * scale;
+  float normalizer = 1.0f / BesselI0(kKaiserAlpha);
+
+  taps.count = int(std::ceil(support * 2.0f)) + 1;
+  taps.first.resize(target_size);
+  taps.weights.assign(size_t(target_size) * taps.count, 0.0f);
+
+  for (int i = 0; i < target_size; i++) {
+    float center = (i + 0.5f) * scale - 0.5f;
+    int first = int(std::floor(center - support)) + 1;
+    taps.first[i] = first;
+
+    float* weights = &taps.weights[size_t(i) * taps.count];
+    float total = 0.0f;
+    for (int j = 0; j < taps.count; j++) {
+      float t = (first + j - center) / scale;
+      float window = t / kKaiserRadius;
+      if (std::fabs(window) >= 1.0f) continue;
+
+      float kaiser =
+          BesselI0(kKaiserAlpha * std::sqrt(1.0f - window * window)) *
+          normalizer;
+      weights[j] = Sinc(t) * kaiser;
+      total += weights[j];
+    }
+
+    for (int j = 0; j < taps.count; j++) weights[j] /= total;
+  }
+}
+
+void DownsampleKaiser(const Level& source, Level& target) {
+  Taps horizontal, vertical;
+  BuildKaiserTaps(source.width, target.width, horizontal);
+  BuildKaiserTaps(source.height, target.height, vertical);
+
+  // Separable, rows first into an intermediate of target width
+  Level rows;
+  rows.width = target.width;
+  rows.height = source.height;
+  rows.data.resize(size_t(rows.width) * rows.height * 4);
+
+  ParallelRows(rows.height, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      const float* input = &source.data[size_t(y) * source.width * 4];
+      float* output = &rows.data[size_t(y) * rows.width * 4];
+
+      for (int x = 0; x < rows.width; x++) {
+        const float* weights =
+            &horizontal.weights[size_t(x) * horizontal.count];
+        Pixel sum = ZeroPixel();
+        for (int j = 0; j < horizontal.count; j++) {
+          int column =
+              std::clamp(horizontal.first[x] + j, 0, source.width - 1);
+          Pixel pixel = LoadPixel(input + column * 4);
+          sum = AddPixels(sum, ScalePixel(pixel, weights[j]));
+        }
+        StorePixel(output + x * 4, sum);
+      }
+    }
+  });
+
+  ParallelRows(target.height, [&](int begin, int end) {
+    for (int y = begin; y < end; y++) {
+      const float* weights = &vertical.weights[size_t(y) * vertical.count];
+      float* output = &target.data[size_t(y) * target.width * 4];
+
+      for (int x = 0; x < target.width; x++) {
+        Pixel sum = ZeroPixel();
+        for (int j = 0; j < vertical.count; j++) {
+          int row = std::clamp(vertical.first[y] + j, 0, rows.height - 1);
+          const float* input = &rows.data[(size_t(row) * rows.width + x) * 4];
+          sum = AddPixels(sum, ScalePixel(LoadPixel(input), weights[j]));
+        }
+        StorePixel(output + x * 4, sum);
+      }
+    }
+  });
+}
+
+float GetCoverage(const Level& level, int channel, float cutoff) {
+  size_t covered = 0, count = size_t(level.width) * level.height;
+  for (size_t i = 0; i < count; i++)
+    covered += level.data[i * 4 + channel] >= cutoff;
+  return float(covered) / float(count);
+}
+
+// Scale of the channel at which the level covers as much as the target
+float GetCoverageScale(const Level& level, int channel, float cutoff,
+                       float coverage) {
+  vector<uint> histogram(kHistogramSize, 0);
+  size_t count = size_t(level.width) * level.height;
+  for (size_t i = 0; i < count; i++) {
+    float value = std::clamp(level.data[i * 4 + channel], 0.0f, 1.0f);
+    histogram[std::min(int(value * kHistogramSize), kHistogramSize - 1)]++;
+  }
+
+  // Threshold that about as many values reach as reached the cutoff at
+  // the top level. Small levels have few distinct values, so the bin that
+  // lands closest to the target is taken even if it falls short.
+  double wanted = double(coverage) * count;
+  size_t covered = 0;
+  int bin = kHistogramSize - 1;
+  for (; bin > 0; bin--) {
+    size_t next = covered + histogram[bin];
+    if (next >= wanted) {
+      if (next - wanted > wanted - covered) bin++;
+      break;
+    }
+    covered = next;
+  }
+
+  float threshold = std::max(bin / float(kHistogramSize), 1.0f / 255.0f);
+  return cutoff / threshold;
+}
+
+void Encode(const Level& level, int components, const MipOptions& options,
+            float coverage_scale, ImageLevel& output) {
+  const Tables& tables = GetTables();
+  output.width = level.width;
+  output.height = level.height;
+  output.data.resize(size_t(level.width) * level.height * components);
+
+  // Every channel is scaled to an index into its table up front
+  float scale[4], limit[4];
+  const byte* table[4];
+  for (int c = 0; c < 4; c++) {
+    bool linearized = IsLinearized(c, components, options);
+    limit[c] = linearized ? float(kSrgbTableSize - 1) : 255.0f;
+    scale[c] = limit[c];
+    if (c == options.coverage_channel) scale[c] *= coverage_scale;
+    table[c] = linearized ? tables.srgb : tables.identity;
+  }
+
+  ParallelRows(level.height, [&](int begin, int end) {
+    size_t first = size_t(begin) * level.width;
+    size_t last = size_t(end) * level.width;
+#ifdef VOODOO_MIP_SSE
+    const __m128 scales = _mm_loadu_ps(scale);
+    const __m128 limits = _mm_loadu_ps(limit);
+    const __m128 half = _mm_set1_ps(0.5f);
+    alignas(16) int index[4];
+    for (size_t p = first; p < last; p++) {
+      __m128 value =
+          _mm_add_ps(_mm_mul_ps(LoadPixel(&level.data[p * 4]), scales), half);
+      value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), limits);
+      _mm_store_si128(reinterpret_cast<__m128i*>(index),
+                      _mm_cvttps_epi32(value));
+      byte* target = &output.data[p * components];
+      for (int c = 0; c < components; c++) target[c] = table[c][index[c]];
+    }
+#else
+    for (size_t p = first; p < last; p++) {
+      byte* target = &output.data[p * components];
+      for (int c = 0; c < components; c++) {
+        float value = std::clamp(level.data[p * 4 + c] * scale[c] + 0.5f,
+                                 0.0f, limit[c]);
+        target[c] = table[c][int(value)];
+      }
+    }
+#endif
+  });
+}
+}  // namespace
+
+void MipGenerator::Generate(Image& image, const MipOptions& options) {
+  using namespace std::chrono;
+  auto start = steady_clock::now();
+
+  image.mips.clear();
+  uint level_count = GetLevelCount(image.width, image.height);
+  if (level_count <= 1 || !image.data || IsBlockCompressed(image.format))
+    return;
+  image.mips.reserve(level_count - 1);
+
+  int components = GetComponentCount(image.format);
+  bool coverage = options.coverage_channel >= 0 &&
+                  options.coverage_channel < components;
+
+  Level current, next;
+  Decode(image, options, current);
+  float target_coverage =
+      coverage ? GetCoverage(current, options.coverage_channel,
+                             options.coverage_cutoff)
+               : 0.0f;
+
+  ullong pixels = 0;
+  for (uint i = 1; i < level_count; i++) {
+    next.width = std::max(current.width / 2, 1);
+    next.height = std::max(current.height / 2, 1);
+    next.data.resize(size_t(next.width) * next.height * 4);
+
+    if (options.filter == kMipFilterKaiser) {
+      DownsampleKaiser(current, next);
+    } else {
+      DownsampleBox(current, next);
+    }
+
+    // Each level is filtered from the unscaled one above it, so coverage
+    // corrections do not accumulate down the chain
+    float coverage_scale =
+        coverage ? GetCoverageScale(next, options.coverage_channel,
+                                    options.coverage_cutoff, target_coverage)
+                 : 1.0f;
+
+    image.mips.emplace_back();
+    Encode(next, components, options, coverage_scale, image.mips.back());
+    pixels += ullong(next.width) * next.height;
+    std::swap(current, next);
+  }
+
+  total_images++;
+  total_pixels += pixels;
+  total_nanoseconds +=
+      duration_cast<nanoseconds>(steady_clock::now() - start).count();
+}
+
+uint MipGenerator::GetLevelCount(int width, int height) {
+  uint count = 1;
+  for (int size = std::max(width, height); size > 1; size /= 2) count++;
+  return count;
+}
+
+MipStats MipGenerator::GetStats() {
+  return {total_images, total_pixels, total_nanoseconds * 1e-6};
+}
+}  // namespace voodoo
@@ -0,0 +1,74 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/name_id.h"
+
+#include "../include/voodoo/logger.h"
+
+#include <deque>
+#include <shared_mutex>
+
+namespace voodoo {
+namespace {
+// Strings stay in place as the deque grows, so references to them last
+struct Names {
+  std::shared_mutex mutex;
+  flat_hash_map<ullong, const string*> ids;
+  std::deque<string> strings;
+};
+
+Names& GetNames() {
+  static Names names;
+  return names;
+}
+
+void ReportCollision(const string& interned, std::string_view name) {
+  VOODOO_LOG_ERROR(kLogCategoryEngine, "Names \"{}\" and \"{}\" hash alike",
+                   interned, string(name));
+}
+}  // namespace
+
+NameId NameId::Intern(std::string_view name) {
+  NameId id(name);
+  Names& names = GetNames();
+  {
+    std::shared_lock<std::shared_mutex> lock(names.mutex);
+    auto it = names.ids.find(id.value_);
+    if (it != names.ids.end()) {
+      if (*it->second != name) ReportCollision(*it->second, name);
+      return id;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(names.mutex);
+  auto result = names.ids.try_emplace(id.value_, nullptr);
+  if (result.second) {
+    names.strings.emplace_back(name);
+    result.first->second = &names.strings.back();
+  } else if (*result.first->second != name) {
+    ReportCollision(*result.first->second, name);
+  }
+
+  return id;
+}
+
+const string& NameId::GetString() const {
+  static const string empty;
+  Names& names = GetNames();
+  std::shared_lock<std::shared_mutex> lock(names.mutex);
+  auto it = names.ids.find(value_);
+  return it != names.ids.end() ? *it->second : empty;
+}
+}  // namespace voodoo
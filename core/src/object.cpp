@@ -21,16 +21,22 @@ Object::Object()
       name_() {}
 
 Object::Object(const string& name) : Object() {
-  name_ = name;
+  name_ = NameId::Intern(name);
 }
 
-Object::Object(const Object& other) : Object(other.name_) {}
+Object::Object(const Object& other) : Object() {
+  name_ = other.name_;
+}
 
 uint Object::GetInstanceId() const {
   return instance_id_;
 }
 
-string Object::GetName() const {
+const string& Object::GetName() const {
+  return name_.GetString();
+}
+
+NameId Object::GetNameId() const {
   return name_;
 }
 
@@ -0,0 +1,94 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/object_pool.h"
+
+#include <algorithm>
+#include <new>
+
+namespace voodoo {
+ObjectPool::ObjectPool(size_t size, size_t alignment)
+    : alignment_(std::max(alignment, alignof(FreeSlot))),
+      free_(nullptr),
+      next_(nullptr),
+      end_(nullptr),
+      live_(0) {
+  // Slots hold a free list link when released and stay aligned end to end
+  slot_size_ = std::max(size, sizeof(FreeSlot));
+  slot_size_ = (slot_size_ + alignment_ - 1) / alignment_ * alignment_;
+  slab_slots_ = std::max<size_t>(kSlabSize / slot_size_, 16);
+}
+
+ObjectPool::~ObjectPool() {
+  for (void* slab : slabs_)
+    ::operator delete(slab, std::align_val_t(alignment_));
+}
+
+void* ObjectPool::Allocate() {
+  void* slot;
+  if (free_) {
+    slot = free_;
+    free_ = free_->next;
+  } else {
+    if (next_ == end_) {
+      size_t size = slot_size_ * slab_slots_;
+      slabs_.push_back(::operator new(size, std::align_val_t(alignment_)));
+      next_ = static_cast<byte*>(slabs_.back());
+      end_ = next_ + size;
+    }
+    slot = next_;
+    next_ += slot_size_;
+  }
+
+  live_++;
+  return slot;
+}
+
+void ObjectPool::Free(void* pointer) {
+  auto slot = static_cast<FreeSlot*>(pointer);
+  slot->next = free_;
+  free_ = slot;
+  live_--;
+}
+
+size_t ObjectPool::GetSlotSize() const { return slot_size_; }
+
+size_t ObjectPool::GetLiveCount() const { return live_; }
+
+size_t ObjectPool::GetSlabCount() const { return slabs_.size(); }
+
+size_t ObjectPool::GetReservedBytes() const {
+  return slabs_.size() * slot_size_ * slab_slots_;
+}
+
+std::atomic<size_t> ObjectArena::next_pool_index_(0);
+
+const sptr<ObjectArena>& ObjectArena::GetGlobal() {
+  static const sptr<ObjectArena> instance = std::make_shared<ObjectArena>();
+  return instance;
+}
+
+ObjectArenaStats ObjectArena::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ObjectArenaStats stats = {0, 0, 0};
+  for (const auto& pool : pools_) {
+    if (!pool) continue;
+    stats.objects += pool->GetLiveCount();
+    stats.slabs += pool->GetSlabCount();
+    stats.bytes += pool->GetReservedBytes();
+  }
+  return stats;
+}
+}  // namespace voodoo
@@ -0,0 +1,305 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/profiler.h"
+
+#include "../include/voodoo/logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace voodoo {
+namespace {
+// Power of two, enough for the zones of a thread in a frame
+constexpr size_t kThreadZoneCount = 4096;
+constexpr size_t kThreadZoneMask = kThreadZoneCount - 1;
+}  // namespace
+
+struct Profiler::ThreadBuffer {
+  ThreadBuffer(uint thread)
+      : zones(new Zone[kThreadZoneCount]),
+        write(0),
+        read(0),
+        thread(thread),
+        depth(0),
+        alive(true) {}
+
+  std::unique_ptr<Zone[]> zones;
+  std::atomic<size_t> write, read;
+  uint thread;
+
+  // Zones open on the thread
+  uint depth;
+
+  // Cleared when the thread exits, its buffer goes once drained
+  std::atomic<bool> alive;
+};
+
+std::atomic<bool> Profiler::enabled_(true);
+
+ProfileScope::ProfileScope(const char* name) : name_(nullptr) {
+  if (!Profiler::IsEnabled()) return;
+
+  name_ = name;
+  depth_ = Profiler::GetThreadBuffer().depth++;
+  begin_ = Profiler::Now();
+}
+
+ProfileScope::~ProfileScope() {
+  if (!name_) return;
+
+  ullong end = Profiler::Now();
+  Profiler::ThreadBuffer& buffer = Profiler::GetThreadBuffer();
+  buffer.depth--;
+
+  size_t write = buffer.write.load(std::memory_order_relaxed);
+  if (write - buffer.read.load(std::memory_order_acquire) >=
+      kThreadZoneCount) {
+    Profiler::Get().dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  buffer.zones[write & kThreadZoneMask] = {name_, begin_, end, depth_,
+                                           buffer.thread};
+  buffer.write.store(write + 1, std::memory_order_release);
+}
+
+Profiler::Profiler()
+    : thread_count_(0),
+      frame_(0),
+      capturing_(false),
+      capture_end_frame_(0),
+      capture_begin_(0),
+      dropped_(0) {}
+
+Profiler::~Profiler() {}
+
+Profiler& Profiler::Get() {
+  static Profiler instance;
+  return instance;
+}
+
+void Profiler::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::EndFrame() {
+  std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+
+  // Entries of zones not seen this frame stay zero
+  uint slot = frame_ % kFrameHistory;
+  for (auto& zone : zones_) {
+    zone.times[slot] = 0.0f;
+    zone.calls[slot] = 0;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    for (auto it = threads_.begin(); it != threads_.end();) {
+      ThreadBuffer& buffer = **it;
+      bool alive = buffer.alive.load(std::memory_order_acquire);
+      size_t read = buffer.read.load(std::memory_order_relaxed);
+      size_t write = buffer.write.load(std::memory_order_acquire);
+      for (; read != write; read++)
+        Add(buffer.zones[read & kThreadZoneMask], slot);
+      buffer.read.store(read, std::memory_order_release);
+
+      if (!alive) {
+        it = threads_.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+
+  frame_++;
+  if (capturing_ && frame_ >= capture_end_frame_) capturing_ = false;
+}
+
+void Profiler::BeginCapture(uint frame_count) {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  capturing_ = true;
+  capture_end_frame_ = frame_ + frame_count;
+  capture_begin_ = Now();
+  capture_.clear();
+  capture_.reserve(kMaxCaptureZones);
+}
+
+bool Profiler::EndCapture(const string& filename) {
+  using namespace std;
+  vector<Zone> capture;
+  {
+    lock_guard<mutex> lock(stats_mutex_);
+    capturing_ = false;
+    capture.swap(capture_);
+  }
+
+  ofstream file(filename);
+  if (!file) {
+    VOODOO_LOG_ERROR(kLogCategoryEngine, "Failed to write trace \"{}\"",
+                     filename);
+    return false;
+  }
+
+  // Complete events, in microseconds since the capture began
+  file << "{\"traceEvents\": [";
+  file.precision(3);
+  file << fixed;
+  for (size_t i = 0; i < capture.size(); i++) {
+    const Zone& zone = capture[i];
+    string name;
+    for (const char* c = zone.name; *c; c++) {
+      if (*c == '"' || *c == '\\') name += '\\';
+      name += *c;
+    }
+
+    double begin = llong(zone.begin - capture_begin_) / 1e3;
+    file << (i ? ",\n" : "\n") << "{\"name\": \"" << name
+         << "\", \"ph\": \"X\", \"ts\": " << begin
+         << ", \"dur\": " << (zone.end - zone.begin) / 1e3
+         << ", \"pid\": 0, \"tid\": " << zone.thread << "}";
+  }
+  file << "\n]}\n";
+
+  return bool(file);
+}
+
+vector<ProfileZoneStats> Profiler::GetZoneStats() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  uint frame_count = std::min(frame_, kFrameHistory);
+
+  vector<const ZoneHistory*> zones;
+  for (const auto& zone : zones_) zones.push_back(&zone);
+  std::sort(zones.begin(), zones.end(),
+            [](const ZoneHistory* a, const ZoneHistory* b) {
+              return a->first_begin < b->first_begin;
+            });
+
+  vector<ProfileZoneStats> stats;
+  vector<float> times;
+  for (const ZoneHistory* history : zones) {
+    const ZoneHistory& zone = *history;
+    ProfileZoneStats zone_stats;
+    zone_stats.name = zone.name;
+    zone_stats.depth = zone.depth;
+    zone_stats.calls = 0.0;
+    zone_stats.min = zone_stats.avg = zone_stats.max = zone_stats.p99 = 0.0f;
+
+    if (frame_count > 0) {
+      times.assign(zone.times, zone.times + frame_count);
+      std::sort(times.begin(), times.end());
+
+      double total = 0.0;
+      ullong calls = 0;
+      for (uint i = 0; i < frame_count; i++) {
+        total += zone.times[i];
+        calls += zone.calls[i];
+      }
+
+      size_t p99 = size_t(std::ceil(0.99 * frame_count)) - 1;
+      zone_stats.calls = double(calls) / frame_count;
+      zone_stats.min = times.front();
+      zone_stats.avg = float(total / frame_count);
+      zone_stats.max = times.back();
+      zone_stats.p99 = times[p99];
+    }
+    stats.push_back(zone_stats);
+  }
+
+  return stats;
+}
+
+void Profiler::Dump() const {
+  auto stats = GetZoneStats();
+  VOODOO_LOG_INFO(kLogCategoryEngine,
+                  "Profile of the last {} frames, ms per frame:",
+                  std::min(frame_, kFrameHistory));
+  for (const auto& zone : stats) {
+    VOODOO_LOG_INFO(kLogCategoryEngine,
+                    "{}{}: avg {}, min {}, max {}, p99 {}, {} calls",
+                    string(zone.depth * 2, ' '), zone.name, zone.avg,
+                    zone.min, zone.max, zone.p99, zone.calls);
+  }
+  ullong dropped = GetDroppedCount();
+  if (dropped > 0) {
+    VOODOO_LOG_WARNING(kLogCategoryEngine, "{} profile zones dropped",
+                       dropped);
+  }
+}
+
+ullong Profiler::GetDroppedCount() const {
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+ullong Profiler::Now() {
+  using namespace std::chrono;
+  return ullong(duration_cast<nanoseconds>(
+                    steady_clock::now().time_since_epoch())
+                    .count());
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer() {
+  // Lets the buffer go with its thread
+  struct Owner {
+    ~Owner() {
+      if (buffer) buffer->alive.store(false, std::memory_order_release);
+    }
+
+    sptr<ThreadBuffer> buffer;
+  };
+  thread_local Owner owner;
+
+  if (!owner.buffer) {
+    Profiler& profiler = Get();
+    std::lock_guard<std::mutex> lock(profiler.threads_mutex_);
+    owner.buffer = std::make_shared<ThreadBuffer>(profiler.thread_count_++);
+    profiler.threads_.push_back(owner.buffer);
+  }
+
+  return *owner.buffer;
+}
+
+void Profiler::Add(const Zone& zone, uint slot) {
+  auto it = zone_indices_.find(zone.name);
+  size_t index;
+  if (it != zone_indices_.end()) {
+    index = it->second;
+  } else {
+    // The same name may come from literals at different addresses
+    index = 0;
+    while (index < zones_.size() && zones_[index].name != zone.name) index++;
+    if (index == zones_.size()) {
+      zones_.emplace_back();
+      ZoneHistory& history = zones_.back();
+      history.name = zone.name;
+      history.depth = zone.depth;
+      history.first_begin = zone.begin;
+      std::fill(std::begin(history.times), std::end(history.times), 0.0f);
+      std::fill(std::begin(history.calls), std::end(history.calls), 0u);
+    }
+    zone_indices_[zone.name] = index;
+  }
+
+  ZoneHistory& history = zones_[index];
+  history.depth = std::min(history.depth, zone.depth);
+  history.first_begin = std::min(history.first_begin, zone.begin);
+  history.times[slot] += (zone.end - zone.begin) / 1e6f;
+  history.calls[slot]++;
+
+  if (capturing_ && capture_.size() < kMaxCaptureZones)
+    capture_.push_back(zone);
+}
+}  // namespace voodoo
@@ -16,10 +16,13 @@
 #include "../include/voodoo/scene.h"
 #include "../include/voodoo/game_object.h"
 #include "../include/voodoo/logger.h"
+#include "../include/voodoo/memory_tracker.h"
 #include "../include/voodoo/transform.h"
 
 namespace voodoo {
-Scene::Scene() : clear_color_(color(100, 100, 100)) {}
+Scene::Scene()
+    : clear_color_(color(100, 100, 100)),
+      arena_(std::make_shared<ObjectArena>()) {}
 
 sptr<Camera> Scene::GetCamera() {
   return camera_;
@@ -34,9 +37,10 @@ color Scene::GetClearColor() {
 }
 
 sptr<GameObject> Scene::AddGameObject(sptr<GameObject> game_object) {
-  auto name = game_object->GetName();
-  if (!GetGameObject(name)) {
-    Log::Warning("GameObject with name \"" + name + "\" already exists");
+  if (GetGameObject(game_object->GetNameId())) {
+    VOODOO_LOG_WARNING(kLogCategoryEngine,
+                       "GameObject with name \"{}\" already exists",
+                       game_object->GetName());
     return nullptr;
   }
 
@@ -46,30 +50,40 @@ sptr<GameObject> Scene::AddGameObject(sptr<GameObject> game_object) {
 sptr<GameObject> Scene::AddGameObject(const string& name) {
   using namespace std;
   if (GetGameObject(name)) {
-    Log::Warning("GameObject with name \"" + name + "\" already exists");
+    VOODOO_LOG_WARNING(kLogCategoryEngine,
+                       "GameObject with name \"{}\" already exists", name);
     return nullptr;
   }
 
-  auto game_object = make_shared<GameObject>(name, shared_from_this());
+  MemoryScope memory_scope(kMemoryTagComponents);
+  auto game_object = allocate_shared<GameObject>(
+      PoolAllocator<GameObject>(arena_), name, shared_from_this());
   game_object->AddComponent<Transform>();
   return InsertGameObject(game_object);
 }
 
-sptr<GameObject> Scene::GetGameObject(const string& name) {
+sptr<GameObject> Scene::GetGameObject(NameId name) {
   auto it = game_objects_.find(name);
   return it != game_objects_.end() ? it->second : nullptr;
 }
 
-vector<sptr<GameObject>> Scene::GetGameObjects() const {
-  vector<sptr<GameObject>> game_objects;
-  for (auto& it : game_objects_)
-    game_objects.push_back(it.second);
-  return game_objects;
+map_values<Scene::GameObjectMap> Scene::GetGameObjects() const {
+  return map_values<GameObjectMap>(game_objects_);
+}
+
+const sptr<ObjectArena>& Scene::GetArena() const {
+  return arena_;
+}
+
+void Scene::Unload() {
+  for (auto& it : game_objects_) it.second->Release();
+  game_objects_.clear();
+  camera_.reset();
 }
 
 sptr<GameObject> Scene::InsertGameObject(sptr<GameObject> game_object) {
-  auto name = game_object->GetName();
-  game_objects_.insert(pair<string, sptr<GameObject>>(name, game_object));
+  game_objects_.insert(pair<NameId, sptr<GameObject>>(
+      game_object->GetNameId(), game_object));
   return game_object;
 }
 }  // namespace voodoo
\ No newline at end of file
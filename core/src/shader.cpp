@@ -37,45 +37,22 @@ Shader::Shader(sptr<ID3D11Device> device,
       sampler_state_(nullptr),
       matrix_buffer_(nullptr),
       light_buffer_(nullptr),
+      pixel_buffer_(nullptr),
       device_(device),
       device_context_(device_context) {}
 
-Shader::~Shader() {
-  if (vertex_shader_) {
-    vertex_shader_->Release();
-    vertex_shader_ = nullptr;
-  }
-
-  if (pixel_shader_) {
-    pixel_shader_->Release();
-    pixel_shader_ = nullptr;
-  }
-
-  if (input_layout_) {
-    input_layout_->Release();
-    input_layout_ = nullptr;
-  }
-
-  if (sampler_state_) {
-    sampler_state_->Release();
-    sampler_state_ = nullptr;
-  }
-
-  if (matrix_buffer_) {
-    matrix_buffer_->Release();
-    matrix_buffer_ = nullptr;
-  }
-
-  if (light_buffer_) {
-    light_buffer_->Release();
-    light_buffer_ = nullptr;
-  }
-}
+Shader::~Shader() { Release(); }
 
-bool Shader::Init(const string& vs_path, const string& ps_path, bool light) {
+bool Shader::Init(const string& vs_path, const string& ps_path, bool light,
+                  VertexFormat vertex_format) {
   HRESULT hr;
 
+  Release();
+
+  vs_path_ = vs_path;
+  ps_path_ = ps_path;
   light_ = light;
+  vertex_format_ = vertex_format;
 
   auto vs_buffer = ShaderBufferManager::Get().Retrieve(vs_path);
   auto ps_buffer = ShaderBufferManager::Get().Retrieve(ps_path);
@@ -89,7 +66,7 @@ bool Shader::Init(const string& vs_path, const string& ps_path, bool light) {
     return false;
   }
 
-  if (!CreateInputLayout(vs_buffer)) {
+  if (!CreateInputLayout(vs_buffer, vertex_format)) {
     return false;
   }
 
@@ -132,27 +109,11 @@ bool Shader::Init(const string& vs_path, const string& ps_path, bool light) {
   return true;
 }
 
-bool Shader::Update(const float4x4& world_matrix,
-                    const float4x4& view_matrix,
-                    const float4x4& projection_matrix,
-                    ID3D11ShaderResourceView* texture) {
+bool Shader::Bind() {
   HRESULT hr;
 
   D3D11_MAPPED_SUBRESOURCE mapped_resource;
 
-  hr = device_context_->Map(matrix_buffer_, 0, D3D11_MAP_WRITE_DISCARD, 0,
-                            &mapped_resource);
-  if (FAILED(hr)) {
-    return false;
-  }
-
-  MatrixBuffer* matrix_buffer =
-      static_cast<MatrixBuffer*>(mapped_resource.pData);
-  matrix_buffer->world_matrix = world_matrix.Transpose();
-  matrix_buffer->view_matrix = view_matrix.Transpose();
-  matrix_buffer->projection_matrix = projection_matrix.Transpose();
-  device_context_->Unmap(matrix_buffer_, 0);
-
   if (light_) {
     hr = device_context_->Map(light_buffer_, 0, D3D11_MAP_WRITE_DISCARD, 0,
                               &mapped_resource);
@@ -189,7 +150,6 @@ bool Shader::Update(const float4x4& world_matrix,
   }
 
   device_context_->PSSetSamplers(0, 1, &sampler_state_);
-  device_context_->PSSetShaderResources(0, 1, &texture);
   device_context_->PSSetShader(pixel_shader_, 0, 0);
 
   device_context_->IASetInputLayout(input_layout_);
@@ -197,7 +157,75 @@ bool Shader::Update(const float4x4& world_matrix,
   return true;
 }
 
-bool Shader::CreateInputLayout(sptr<ShaderBuffer> buffer) {
+bool Shader::Update(const float4x4& world_matrix,
+                    const float4x4& view_matrix,
+                    const float4x4& projection_matrix) {
+  HRESULT hr;
+
+  D3D11_MAPPED_SUBRESOURCE mapped_resource;
+
+  hr = device_context_->Map(matrix_buffer_, 0, D3D11_MAP_WRITE_DISCARD, 0,
+                            &mapped_resource);
+  if (FAILED(hr)) {
+    return false;
+  }
+
+  MatrixBuffer* matrix_buffer =
+      static_cast<MatrixBuffer*>(mapped_resource.pData);
+  matrix_buffer->world_matrix = world_matrix.Transpose();
+  matrix_buffer->view_matrix = view_matrix.Transpose();
+  matrix_buffer->projection_matrix = projection_matrix.Transpose();
+  device_context_->Unmap(matrix_buffer_, 0);
+
+  return true;
+}
+
+void Shader::SetTexture(ID3D11ShaderResourceView* texture) {
+  device_context_->PSSetShaderResources(0, 1, &texture);
+}
+
+bool Shader::Reload() {
+  // The new objects are built aside, so a broken shader file leaves the
+  // working one in place
+  Shader fresh(device_, device_context_);
+  if (!fresh.Init(vs_path_, ps_path_, light_, vertex_format_)) {
+    return false;
+  }
+
+  std::swap(vertex_shader_, fresh.vertex_shader_);
+  std::swap(pixel_shader_, fresh.pixel_shader_);
+  std::swap(input_layout_, fresh.input_layout_);
+  std::swap(sampler_state_, fresh.sampler_state_);
+  std::swap(matrix_buffer_, fresh.matrix_buffer_);
+  std::swap(light_buffer_, fresh.light_buffer_);
+  std::swap(pixel_buffer_, fresh.pixel_buffer_);
+
+  return true;
+}
+
+const string& Shader::GetVSPath() const { return vs_path_; }
+
+const string& Shader::GetPSPath() const { return ps_path_; }
+
+void Shader::Release() {
+  safe_release(vertex_shader_);
+  safe_release(pixel_shader_);
+  safe_release(input_layout_);
+  safe_release(sampler_state_);
+  safe_release(matrix_buffer_);
+  safe_release(light_buffer_);
+  safe_release(pixel_buffer_);
+
+  vertex_shader_ = nullptr;
+  pixel_shader_ = nullptr;
+  input_layout_ = nullptr;
+  sampler_state_ = nullptr;
+  matrix_buffer_ = nullptr;
+  light_buffer_ = nullptr;
+  pixel_buffer_ = nullptr;
+}
+
+bool Shader::CreateInputLayout(sptr<ShaderBuffer> buffer, VertexFormat vertex_format) {
   HRESULT hr;
 
   ID3D11ShaderReflection* reflection = nullptr;
@@ -232,7 +260,22 @@ bool Shader::CreateInputLayout(sptr<ShaderBuffer> buffer) {
     ie_desc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
     ie_desc.InstanceDataStepRate = 0;
 
-    if (lstrcmpA(ie_desc.SemanticName, LPCSTR("POSITION")) == 0) {
+    // Packed vertices can't be told apart by reflection since shader
+    // inputs are floats either way, see vertex_ptn_packed
+    if (vertex_format == kVertexFormatPtnPacked) {
+      if (lstrcmpA(ie_desc.SemanticName, LPCSTR("POSITION")) == 0) {
+        ie_desc.Format = DXGI_FORMAT_R16G16B16A16_SNORM;
+      } else if (lstrcmpA(ie_desc.SemanticName, LPCSTR("TEXCOORD")) == 0) {
+        ie_desc.Format = DXGI_FORMAT_R16G16_FLOAT;
+      } else if (lstrcmpA(ie_desc.SemanticName, LPCSTR("NORMAL")) == 0) {
+        ie_desc.Format = DXGI_FORMAT_R16G16_SNORM;
+      } else {
+        VOODOO_LOG_ERROR(kLogCategoryRender,
+                         "Unsupported packed vertex semantic: {}",
+                         ie_desc.SemanticName);
+        return false;
+      }
+    } else if (lstrcmpA(ie_desc.SemanticName, LPCSTR("POSITION")) == 0) {
       ie_desc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
     } else if (param_desc.Mask == 1) {
       if (param_desc.ComponentType == D3D_REGISTER_COMPONENT_UINT32)
@@ -15,29 +15,23 @@
 
 #include "../include/voodoo/shader_buffer_manager.h"
 
-#include "../include/voodoo/logger.h"
+#include "../include/voodoo/file_system.h"
+#include "../include/voodoo/profiler.h"
 
-#include <fstream>
+#include <cstring>
 
 namespace voodoo {
-sptr<ShaderBuffer> ShaderBufferManager::Load(const string& filename) {
+sptr<ShaderBuffer> ShaderBufferManager::Load(const string& filename,
+                                             sptr<FileData> file) {
   using namespace std;
-  ifstream fs;
-  fs.open(filename, ios::in | ios::binary);
-  if (fs.fail()) {
-    Log::Error("Error: Failed to open shader file ");
-    throw runtime_error("Failed to open shader file");
-  }
-
-  fs.seekg(0, ios::end);
-  auto size = static_cast<uint>(fs.tellg());
-  fs.seekg(0, ios::beg);
-
-  auto buffer = make_shared<ShaderBuffer>(size);
-
-  fs.read(reinterpret_cast<char*>(&buffer->data[0]), buffer->size);
-  fs.close();
+  VOODOO_PROFILE_SCOPE("LoadShader");
+  auto buffer = make_shared<ShaderBuffer>(static_cast<uint>(file->GetSize()));
+  memcpy(buffer->data, file->GetData(), buffer->size);
 
   return buffer;
 }
+
+size_t ShaderBufferManager::GetAssetSize(const ShaderBuffer& buffer) const {
+  return sizeof(ShaderBuffer) + buffer.size;
+}
 }
\ No newline at end of file
@@ -16,28 +16,73 @@
 #include "../include/voodoo/texture.h"
 
 namespace voodoo {
-Texture::Texture(std::shared_ptr<ID3D11Device> device, std::shared_ptr<Image> image) {
+namespace {
+DXGI_FORMAT GetTextureFormat(ImageFormat format) {
+  switch (format) {
+    case kImageFormatBc1:
+      return DXGI_FORMAT_BC1_UNORM;
+    case kImageFormatBc3:
+      return DXGI_FORMAT_BC3_UNORM;
+    case kImageFormatBc4:
+      return DXGI_FORMAT_BC4_UNORM;
+    case kImageFormatBc7:
+      return DXGI_FORMAT_BC7_UNORM;
+    case kImageFormatR8:
+      return DXGI_FORMAT_R8_UNORM;
+    case kImageFormatRg8:
+      return DXGI_FORMAT_R8G8_UNORM;
+    default:
+      return DXGI_FORMAT_R8G8B8A8_UNORM;
+  }
+}
+}  // namespace
+
+Texture::Texture(std::shared_ptr<ID3D11Device> device, std::shared_ptr<Image> image)
+    : texture(nullptr), srv(nullptr), source(image) {
+  Create(device.get(), *image);
+}
+
+Texture::~Texture() {
+  if (texture) {
+    texture->Release();
+  }
+
+  if (srv) {
+    srv->Release();
+  }
+}
+
+void Texture::Create(ID3D11Device* device, const Image& image) {
   HRESULT hr;
 
   D3D11_TEXTURE2D_DESC texture_desc;
   memset(&texture_desc, 0, sizeof(texture_desc));
-  texture_desc.Width = image->width;
-  texture_desc.Height = image->height;
-  texture_desc.MipLevels = 1;
+  texture_desc.Width = image.width;
+  texture_desc.Height = image.height;
+  texture_desc.MipLevels = 1 + static_cast<UINT>(image.mips.size());
   texture_desc.ArraySize = 1;
-  texture_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+  texture_desc.Format = GetTextureFormat(image.format);
   texture_desc.SampleDesc.Count = 1;
   texture_desc.Usage = D3D11_USAGE_DEFAULT;
   texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
   texture_desc.CPUAccessFlags = 0;
 
-  D3D11_SUBRESOURCE_DATA subresource_data;
-  subresource_data.pSysMem = image->data;
-  subresource_data.SysMemPitch = texture_desc.Width * 4;
-  subresource_data.SysMemSlicePitch = 0;
+  // One subresource per mip level, the full resolution one first
+  vector<D3D11_SUBRESOURCE_DATA> subresource_data(texture_desc.MipLevels);
+  subresource_data[0].pSysMem = image.data;
+  subresource_data[0].SysMemPitch =
+      UINT(GetImageRowPitch(image.format, image.width));
+  subresource_data[0].SysMemSlicePitch = 0;
+  for (size_t i = 0; i < image.mips.size(); i++) {
+    subresource_data[i + 1].pSysMem = image.mips[i].data.data();
+    subresource_data[i + 1].SysMemPitch =
+        UINT(GetImageRowPitch(image.format, image.mips[i].width));
+    subresource_data[i + 1].SysMemSlicePitch = 0;
+  }
 
+  ID3D11Texture2D* new_texture;
   hr = device->CreateTexture2D(
-      &texture_desc, &subresource_data, &texture);
+      &texture_desc, subresource_data.data(), &new_texture);
   if (FAILED(hr)) {
     throw std::runtime_error("Failed to create texture from memory");
   }
@@ -47,35 +92,21 @@ Texture::Texture(std::shared_ptr<ID3D11Device> device, std::shared_ptr<Image> im
   srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
   srv_desc.Texture2D.MipLevels = texture_desc.MipLevels;
   srv_desc.Texture2D.MostDetailedMip = 0;
+  srv_desc.Format = texture_desc.Format;
 
-  // Determine format by image color channels
-  switch (image->channels) {
-    case 1:
-      srv_desc.Format = DXGI_FORMAT_R8_UNORM;
-      break;
-    case 2:
-      srv_desc.Format = DXGI_FORMAT_R8G8_UNORM;
-      break;
-    default:
-      srv_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-      break;
-  }
-
+  ID3D11ShaderResourceView* new_srv;
   hr = device->CreateShaderResourceView(
-      texture, &srv_desc, &srv);
+      new_texture, &srv_desc, &new_srv);
   if (FAILED(hr)) {
+    new_texture->Release();
     throw std::runtime_error(
         "Failed to create shader resource view from texture");
   }
-}
-
-Texture::~Texture() {
-  if (texture) {
-    texture->Release();
-  }
 
-  if (srv) {
-    srv->Release();
-  }
+  // Previous resources are kept until the new ones exist
+  safe_release(texture);
+  safe_release(srv);
+  texture = new_texture;
+  srv = new_srv;
 }
 }  // namespace voodoo
\ No newline at end of file
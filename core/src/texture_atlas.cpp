@@ -0,0 +1,96 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/texture_atlas.h"
+
+#include "../include/voodoo/file_system.h"
+
+#include <fstream>
+#include <iomanip>
+
+namespace voodoo {
+sptr<TextureAtlas> TextureAtlas::Load(const string& filename) {
+  using namespace std;
+  auto file = FileSystem::Read(filename);
+  istringstream fin(string(reinterpret_cast<const char*>(file->GetData()),
+                           file->GetSize()));
+
+  // A list of "Label: value" lines, region values are followed by the
+  // texture name which may contain spaces
+  auto atlas = make_shared<TextureAtlas>();
+  string label;
+  uint version = 0;
+  while (getline(fin >> ws, label, ':')) {
+    if (label == "Version") {
+      fin >> version;
+      if (version != kVersion) break;
+    } else if (label == "Page") {
+      string page;
+      getline(fin >> ws, page);
+      atlas->pages.push_back(page);
+    } else if (label == "Region") {
+      AtlasRegion region;
+      string texture;
+      fin >> region.page >> region.offset.x >> region.offset.y >>
+          region.scale.x >> region.scale.y;
+      getline(fin >> ws, texture);
+      if (fin.fail() || region.page >= atlas->pages.size()) break;
+      atlas->regions[texture] = region;
+    } else {
+      getline(fin, label);
+    }
+  }
+
+  if (version != kVersion || !fin.eof()) {
+    throw runtime_error("Invalid atlas file: \"" + filename + "\"");
+  }
+
+  return atlas;
+}
+
+bool TextureAtlas::Save(const string& filename) const {
+  using namespace std;
+  ofstream fout(filename);
+  if (fout.fail()) return false;
+
+  fout << "Version: " << kVersion << endl;
+  fout << "Page Count: " << pages.size() << endl;
+  for (const auto& page : pages) fout << "Page: " << page << endl;
+
+  // Offsets and scales are texel aligned fractions of the page size
+  fout << "Region Count: " << regions.size() << endl;
+  fout << setprecision(9);
+  for (const auto& region : regions) {
+    const AtlasRegion& r = region.second;
+    fout << "Region: " << r.page << ' ' << r.offset.x << ' ' << r.offset.y
+         << ' ' << r.scale.x << ' ' << r.scale.y << ' ' << region.first
+         << endl;
+  }
+
+  return !fout.fail();
+}
+
+const AtlasRegion* TextureAtlas::Find(const string& texture) const {
+  auto it = regions.find(texture);
+  return it != regions.end() ? &it->second : nullptr;
+}
+
+string TextureAtlas::GetPagePath(const string& filename, uint page) const {
+  size_t slash = filename.find_last_of("/\\");
+  string directory =
+      slash == string::npos ? string() : filename.substr(0, slash + 1);
+  return directory + pages[page];
+}
+}  // namespace voodoo
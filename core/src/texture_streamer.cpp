@@ -0,0 +1,333 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/texture_streamer.h"
+
+#include "../include/voodoo/camera.h"
+#include "../include/voodoo/frame_arena.h"
+#include "../include/voodoo/game_object.h"
+#include "../include/voodoo/logger.h"
+#include "../include/voodoo/memory_tracker.h"
+#include "../include/voodoo/profiler.h"
+#include "../include/voodoo/renderer.h"
+#include "../include/voodoo/thread_pool.h"
+#include "../include/voodoo/transform.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace voodoo {
+namespace {
+// Levels up to this size are always resident
+constexpr uint kTailExtent = 64;
+
+// Levels are kept this long after they were last needed, so that objects
+// moving back and forth do not stream them again and again
+const std::chrono::seconds kEvictDelay(2);
+}  // namespace
+
+TextureStreamer::TextureStreamer(sptr<GraphicsAPI> graphics_api)
+    : graphics_api_(graphics_api),
+      budget_(0),
+      next_id_(0),
+      in_flight_(0),
+      streamed_bytes_(0),
+      upgrades_(0),
+      evictions_(0),
+      window_start_(Clock::now()),
+      window_bytes_(0),
+      bandwidth_(0.0) {}
+
+TextureStreamer::~TextureStreamer() {
+  for (auto& stream : streams_) {
+    if (stream.second.pending) stream.second.request.Cancel();
+  }
+
+  // Loads in flight refer to this object
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this]() { return in_flight_ == 0; });
+}
+
+sptr<Texture> TextureStreamer::Load(const string& filename) {
+  using namespace std;
+  auto file = FileSystem::Read(filename);
+
+  Stream stream;
+  stream.filename = filename;
+  stream.header = VTex::ReadHeader(filename, *file);
+
+  uint extent = max(stream.header.width, stream.header.height);
+  stream.tail = 0;
+  while (stream.tail + 1 < stream.header.level_count &&
+         (extent >> stream.tail) > kTailExtent)
+    stream.tail++;
+
+  auto texture = make_shared<Texture>(graphics_api_->GetDevice(),
+                                      VTex::Load(filename, *file, stream.tail));
+
+  stream.texture = texture;
+  stream.resident = stream.wanted = stream.tail;
+  stream.pixels = 0.0f;
+  stream.last_needed = Clock::now();
+  stream.pending = stream.failed = false;
+  stream.id = next_id_++;
+  streams_[texture.get()] = stream;
+
+  return texture;
+}
+
+void TextureStreamer::SetBudget(ullong bytes) { budget_ = bytes; }
+
+void TextureStreamer::Update(const sptr<Scene>& scene, int screen_height) {
+  VOODOO_PROFILE_SCOPE("TextureStreaming");
+  vector<Upload> uploads;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uploads.swap(uploads_);
+  }
+  for (auto& upload : uploads) Apply(upload);
+
+  // Released textures are forgotten once nothing is in flight for them
+  for (auto it = streams_.begin(); it != streams_.end();) {
+    if (it->second.texture.expired() && !it->second.pending) {
+      it = streams_.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  for (auto& stream : streams_) {
+    stream.second.wanted = stream.second.tail;
+    stream.second.pixels = 0.0f;
+  }
+
+  // A texture is taken to cover its object once, so the level wanted is
+  // the one about as large as the object's bounding sphere on screen
+  auto camera = scene->GetCamera();
+  if (camera && screen_height > 0) {
+    auto eye = camera->GetTransform();
+    vec3f eye_position = eye->GetPosition();
+    vec3f forward = eye->GetForward();
+    float pixels_per_unit =
+        screen_height / (2.0f * std::tan(camera->GetFov() / 2.0f));
+
+    for (auto& game_object : scene->GetGameObjects()) {
+      if (!game_object->IsActive()) continue;
+
+      auto renderer = game_object->GetComponent<Renderer>();
+      if (!renderer || !renderer->GetMaterial() || !renderer->GetMesh())
+        continue;
+
+      auto texture = renderer->GetMaterial()->texture;
+      auto it = streams_.find(texture.get());
+      if (it == streams_.end()) continue;
+      Stream& stream = it->second;
+
+      auto transform = renderer->GetTransform();
+      vec3f scale = transform->GetScale();
+      float radius = GetRadius(*renderer->GetMesh()) *
+                     std::max(std::abs(scale.x),
+                              std::max(std::abs(scale.y), std::abs(scale.z)));
+      vec3f to_object = transform->GetPosition() - eye_position;
+      float distance = to_object.Length();
+
+      // Behind the camera
+      if (vec3f::DotProduct(to_object, forward) < -radius) continue;
+
+      float pixels = distance > radius
+                         ? 2.0f * radius / distance * pixels_per_unit
+                         : float(screen_height);
+
+      uint level = 0;
+      float extent = float(std::max(stream.header.width, stream.header.height));
+      while (level < stream.tail && extent / 2.0f >= pixels) {
+        extent /= 2.0f;
+        level++;
+      }
+
+      stream.wanted = std::min(stream.wanted, level);
+      stream.pixels = std::max(stream.pixels, pixels);
+    }
+  }
+
+  // Tails always stay resident, the budget left goes to the most visible
+  // textures first
+  frame_vector<Stream*> order;
+  order.reserve(streams_.size());
+  ullong used = 0, resident = 0;
+  for (auto& stream : streams_) {
+    order.push_back(&stream.second);
+    used += GetBytes(stream.second, stream.second.tail);
+    resident += GetBytes(stream.second, stream.second.resident);
+  }
+  std::sort(order.begin(), order.end(), [](const Stream* a, const Stream* b) {
+    return a->pixels > b->pixels;
+  });
+
+  for (auto* stream : order) {
+    ullong tail_bytes = GetBytes(*stream, stream->tail);
+    while (budget_ > 0 && stream->wanted < stream->tail &&
+           used - tail_bytes + GetBytes(*stream, stream->wanted) > budget_)
+      stream->wanted++;
+    used += GetBytes(*stream, stream->wanted) - tail_bytes;
+  }
+
+  auto now = Clock::now();
+  bool over_budget = budget_ > 0 && resident > budget_;
+  for (auto* stream : order) {
+    if (stream->wanted <= stream->resident) stream->last_needed = now;
+    if (stream->pending || stream->failed || stream->texture.expired())
+      continue;
+
+    if (stream->wanted < stream->resident) {
+      Request(*stream, stream->wanted,
+              stream->resident == stream->tail ? kIoPriorityHigh
+                                               : kIoPriorityNormal);
+    } else if (stream->wanted > stream->resident &&
+               (over_budget || now - stream->last_needed > kEvictDelay)) {
+      Request(*stream, stream->wanted, kIoPriorityLow);
+    }
+  }
+
+  std::chrono::duration<double> elapsed = now - window_start_;
+  if (elapsed.count() >= 1.0) {
+    bandwidth_ = window_bytes_ / elapsed.count();
+    window_bytes_ = 0;
+    window_start_ = now;
+  }
+}
+
+TextureStreamingStats TextureStreamer::GetStats() const {
+  TextureStreamingStats stats;
+  stats.textures = static_cast<uint>(streams_.size());
+  stats.resident_bytes = 0;
+  stats.budget = budget_;
+  stats.pending = 0;
+  for (const auto& stream : streams_) {
+    stats.resident_bytes += GetBytes(stream.second, stream.second.resident);
+    if (stream.second.pending) stats.pending++;
+  }
+  stats.streamed_bytes = streamed_bytes_;
+  stats.bandwidth = bandwidth_;
+  stats.upgrades = upgrades_;
+  stats.evictions = evictions_;
+
+  return stats;
+}
+
+void TextureStreamer::Request(Stream& stream, uint level,
+                              IoPriority priority) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_flight_++;
+  }
+  stream.pending = true;
+
+  const Texture* texture = stream.texture.lock().get();
+  string filename = stream.filename;
+  uint id = stream.id;
+  stream.request = IoQueue::Get().Read(
+      filename, priority,
+      [this, texture, id, level, filename](sptr<FileData> file,
+                                           std::exception_ptr error) {
+        ThreadPool::Get().Submit([this, texture, id, level, filename, file,
+                                  error]() {
+          MemoryScope memory_scope(kMemoryTagImages);
+          Upload upload = {texture, id, level, nullptr};
+          if (!error) {
+            try {
+              upload.image = VTex::Load(filename, *file, level);
+            } catch (const std::exception&) {
+            }
+          }
+
+          std::lock_guard<std::mutex> lock(mutex_);
+          uploads_.push_back(upload);
+          in_flight_--;
+          condition_.notify_all();
+        });
+      });
+}
+
+void TextureStreamer::Apply(Upload& upload) {
+  auto it = streams_.find(upload.texture);
+  if (it == streams_.end() || it->second.id != upload.id) return;
+
+  Stream& stream = it->second;
+  stream.pending = false;
+
+  auto texture = stream.texture.lock();
+  if (!texture) return;
+
+  try {
+    if (!upload.image) throw std::runtime_error("Failed to read levels");
+    texture->Create(graphics_api_->GetDevice().get(), *upload.image);
+  } catch (const std::exception& e) {
+    VOODOO_LOG_WARNING(kLogCategoryRender, "Failed to stream \"{}\": {}",
+                       stream.filename, e.what());
+    stream.failed = true;
+    return;
+  }
+
+  if (upload.level < stream.resident) {
+    upgrades_++;
+  } else {
+    evictions_++;
+  }
+  stream.resident = upload.level;
+
+  ullong bytes = GetBytes(stream, upload.level);
+  streamed_bytes_ += bytes;
+  window_bytes_ += bytes;
+}
+
+ullong TextureStreamer::GetBytes(const Stream& stream, uint level) const {
+  auto format = static_cast<ImageFormat>(stream.header.format);
+  int width = int(stream.header.width), height = int(stream.header.height);
+
+  ullong bytes = 0;
+  for (uint i = 0; i < stream.header.level_count; i++) {
+    if (i >= level) bytes += GetImageLevelSize(format, width, height);
+    width = std::max(width / 2, 1);
+    height = std::max(height / 2, 1);
+  }
+
+  return bytes;
+}
+
+float TextureStreamer::GetRadius(const Mesh& mesh) {
+  // Meshes get their bounds when loaded or built from vertices. They are
+  // read every time because hot reload replaces meshes in place.
+  float radius = 0.0f;
+  if ((mesh.bounds_max - mesh.bounds_min).LengthSquared() > 0.0f) {
+    for (int i = 0; i < 3; i++) {
+      float extent =
+          std::max(std::abs(mesh.bounds_min[i]), std::abs(mesh.bounds_max[i]));
+      radius += extent * extent;
+    }
+    radius = std::sqrt(radius);
+  } else if (mesh.vertex_format == kVertexFormatPtnPacked) {
+    // Packed positions are within the unit cube before their transform
+    radius = mesh.position_offset.Length() +
+             mesh.position_scale * std::sqrt(3.0f);
+  } else {
+    auto vertices = static_cast<const vertex_ptn*>(mesh.GetVertexData());
+    for (uint i = 0; i < mesh.vertex_count; i++)
+      radius = std::max(radius, vertices[i].position.Length());
+  }
+
+  return radius;
+}
+}  // namespace voodoo
@@ -0,0 +1,115 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace voodoo {
+ThreadPool::ThreadPool(uint thread_count) : stopping_(false) {
+  if (thread_count == 0) {
+    uint hardware = std::thread::hardware_concurrency();
+    thread_count = hardware > 1 ? hardware - 1 : 1;
+  }
+
+  for (uint i = 0; i < thread_count; i++)
+    threads_.emplace_back(&ThreadPool::Work, this);
+}
+
+ThreadPool::~ThreadPool() {
+  // Queued tasks are still executed so that no future is left broken
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+
+  for (auto& thread : threads_) thread.join();
+}
+
+void ThreadPool::ParallelFor(size_t count,
+                             const std::function<void(size_t)>& task) {
+  if (count == 0) return;
+  if (count == 1) {
+    task(0);
+    return;
+  }
+
+  // Helpers that start after every index was claimed return at once and
+  // never touch the task, which may be gone by then
+  struct State {
+    std::atomic<size_t> next{0};
+    size_t count;
+    size_t done = 0;
+    std::mutex mutex;
+    std::condition_variable condition;
+    const std::function<void(size_t)>* task;
+  };
+
+  auto state = std::make_shared<State>();
+  state->count = count;
+  state->task = &task;
+
+  auto work = [state]() {
+    size_t done = 0;
+    for (size_t i = state->next++; i < state->count; i = state->next++) {
+      (*state->task)(i);
+      done++;
+    }
+
+    if (done == 0) return;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->done += done;
+    if (state->done == state->count) state->condition.notify_all();
+  };
+
+  size_t helpers = std::min<size_t>(threads_.size(), count - 1);
+  for (size_t i = 0; i < helpers; i++) Enqueue(work);
+  work();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->condition.wait(lock,
+                        [&state]() { return state->done == state->count; });
+}
+
+uint ThreadPool::GetThreadCount() const {
+  return static_cast<uint>(threads_.size());
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  condition_.notify_one();
+}
+
+void ThreadPool::Work() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) return;
+
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
+}  // namespace voodoo
@@ -0,0 +1,256 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/vertex_packer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace voodoo {
+namespace {
+const float kSnorm16Max = 32767.0f;
+
+int16 float_to_snorm16(float value) {
+  return static_cast<int16>(std::round(clampf(value, -1.0f, 1.0f) * kSnorm16Max));
+}
+
+float snorm16_to_float(int16 value) {
+  return std::max(value / kSnorm16Max, -1.0f);
+}
+
+float sign_not_zero(float value) {
+  return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+float angle_between(const vec3f& a, const vec3f& b) {
+  float cosine = clampf(vec3f::DotProduct(a, b), -1.0f, 1.0f);
+  return rtod(std::acos(cosine));
+}
+}  // namespace
+
+uint16 float_to_half(float value) {
+  uint bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  uint sign = (bits >> 16) & 0x8000;
+  uint float_exponent = (bits >> 23) & 0xff;
+  uint mantissa = bits & 0x7fffff;
+  int exponent = static_cast<int>(float_exponent) - 127 + 15;
+
+  // Infinity and NaN
+  if (float_exponent == 0xff) {
+    return static_cast<uint16>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+
+  // Too large, saturate to infinity
+  if (exponent >= 31) {
+    return static_cast<uint16>(sign | 0x7c00);
+  }
+
+  // Denormalized half or zero
+  if (exponent <= 0) {
+    if (exponent < -10) return static_cast<uint16>(sign);
+
+    mantissa |= 0x800000;
+    uint shift = static_cast<uint>(14 - exponent);
+    uint half = mantissa >> shift;
+    uint remainder = mantissa & ((1u << shift) - 1);
+    uint halfway = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (half & 1))) half++;
+    return static_cast<uint16>(sign | half);
+  }
+
+  // Round to nearest even, a carry into the exponent is still correct
+  uint half = sign | (static_cast<uint>(exponent) << 10) | (mantissa >> 13);
+  uint remainder = mantissa & 0x1fff;
+  if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+  return static_cast<uint16>(half);
+}
+
+float half_to_float(uint16 value) {
+  uint sign = static_cast<uint>(value & 0x8000) << 16;
+  uint exponent = (value >> 10) & 0x1f;
+  uint mantissa = value & 0x3ff;
+
+  if (exponent == 0) {
+    float result = std::ldexp(static_cast<float>(mantissa), -24);
+    return sign ? -result : result;
+  }
+
+  uint bits;
+  if (exponent == 31) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+vec2i oct_encode(const vec3f& normal, int bits) {
+  float max_value = static_cast<float>((1 << (bits - 1)) - 1);
+
+  float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+  if (length == 0.0f) return vec2i(0, 0);
+
+  float u = normal.x / length;
+  float v = normal.y / length;
+  if (normal.z < 0.0f) {
+    float folded_u = (1.0f - std::abs(v)) * sign_not_zero(u);
+    float folded_v = (1.0f - std::abs(u)) * sign_not_zero(v);
+    u = folded_u;
+    v = folded_v;
+  }
+
+  // Rounding each component independently is not the closest encoding,
+  // so every floor/ceil combination is decoded and the best one is kept
+  vec3f target = normal.Normalized();
+  int u_floor = static_cast<int>(std::floor(u * max_value));
+  int v_floor = static_cast<int>(std::floor(v * max_value));
+  int limit = static_cast<int>(max_value);
+
+  vec2i best(0, 0);
+  float best_dot = -2.0f;
+  for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 2; j++) {
+      vec2i candidate(std::min(std::max(u_floor + i, -limit), limit),
+                      std::min(std::max(v_floor + j, -limit), limit));
+      float dot = vec3f::DotProduct(oct_decode(candidate, bits), target);
+      if (dot > best_dot) {
+        best_dot = dot;
+        best = candidate;
+      }
+    }
+  }
+
+  return best;
+}
+
+vec3f oct_decode(const vec2i& encoded, int bits) {
+  float max_value = static_cast<float>((1 << (bits - 1)) - 1);
+
+  float x = clampf(encoded.x / max_value, -1.0f, 1.0f);
+  float y = clampf(encoded.y / max_value, -1.0f, 1.0f);
+  float z = 1.0f - std::abs(x) - std::abs(y);
+
+  float t = std::max(-z, 0.0f);
+  x += x >= 0.0f ? -t : t;
+  y += y >= 0.0f ? -t : t;
+
+  return vec3f(x, y, z).Normalized();
+}
+
+void VertexPacker::Pack(Mesh& mesh) {
+  if (mesh.vertex_format == kVertexFormatPtnPacked || mesh.IsMapped()) return;
+
+  float3 offset;
+  float scale;
+  CalculateQuantization(mesh, offset, scale);
+
+  mesh.packed_vertices.resize(mesh.vertex_count);
+  for (uint i = 0; i < mesh.vertex_count; i++) {
+    mesh.packed_vertices[i] = PackVertex(mesh.vertices[i], offset, scale);
+  }
+
+  mesh.position_offset = offset;
+  mesh.position_scale = scale;
+  mesh.vertex_format = kVertexFormatPtnPacked;
+  vector<vertex_ptn>().swap(mesh.vertices);
+}
+
+VertexPackingStats VertexPacker::Analyze(const Mesh& mesh) {
+  VertexPackingStats stats;
+  if (mesh.vertex_format == kVertexFormatPtnPacked || mesh.IsMapped()) return stats;
+
+  stats.source_bytes = mesh.vertex_count * sizeof(vertex_ptn);
+  stats.packed_bytes = mesh.vertex_count * sizeof(vertex_ptn_packed);
+
+  float3 offset;
+  float scale;
+  CalculateQuantization(mesh, offset, scale);
+
+  for (uint i = 0; i < mesh.vertex_count; i++) {
+    const auto& source = mesh.vertices[i];
+    auto packed = PackVertex(source, offset, scale);
+
+    float3 position(snorm16_to_float(packed.position[0]),
+                    snorm16_to_float(packed.position[1]),
+                    snorm16_to_float(packed.position[2]));
+    position = position * scale + offset;
+    stats.max_position_error = std::max(
+        stats.max_position_error, (position - source.position).Length());
+
+    float2 texture(half_to_float(packed.texture[0]),
+                   half_to_float(packed.texture[1]));
+    stats.max_texture_error = std::max(
+        stats.max_texture_error, (texture - source.texture).Length());
+
+    if (source.normal.LengthSquared() > 0.0f) {
+      vec3f normal = source.normal.Normalized();
+      vec3f normal16 = oct_decode(vec2i(packed.normal[0], packed.normal[1]), 16);
+      vec3f normal8 = oct_decode(oct_encode(normal, 8), 8);
+      stats.max_normal_error = std::max(
+          stats.max_normal_error, angle_between(normal, normal16));
+      stats.max_normal_error_8bit = std::max(
+          stats.max_normal_error_8bit, angle_between(normal, normal8));
+    }
+  }
+
+  return stats;
+}
+
+void VertexPacker::CalculateQuantization(const Mesh& mesh, float3& offset, float& scale) {
+  if (mesh.vertex_count == 0) {
+    offset = kVec3fZeros;
+    scale = 1.0f;
+    return;
+  }
+
+  float3 min = mesh.vertices[0].position;
+  float3 max = mesh.vertices[0].position;
+  for (const auto& vertex : mesh.vertices) {
+    min = float3::Min(min, vertex.position);
+    max = float3::Max(max, vertex.position);
+  }
+
+  float3 extents = (max - min) * 0.5f;
+  offset = (min + max) * 0.5f;
+  scale = std::max(extents.x, std::max(extents.y, extents.z));
+  if (scale <= 0.0f) scale = 1.0f;
+}
+
+vertex_ptn_packed VertexPacker::PackVertex(const vertex_ptn& vertex,
+                                           const float3& offset, const float& scale) {
+  vertex_ptn_packed packed;
+
+  float3 position = (vertex.position - offset) / scale;
+  packed.position[0] = float_to_snorm16(position.x);
+  packed.position[1] = float_to_snorm16(position.y);
+  packed.position[2] = float_to_snorm16(position.z);
+  packed.position[3] = 0;
+
+  packed.texture[0] = float_to_half(vertex.texture.x);
+  packed.texture[1] = float_to_half(vertex.texture.y);
+
+  vec2i normal = oct_encode(vertex.normal, 16);
+  packed.normal[0] = static_cast<int16>(normal.x);
+  packed.normal[1] = static_cast<int16>(normal.y);
+
+  return packed;
+}
+}  // namespace voodoo
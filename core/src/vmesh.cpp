@@ -0,0 +1,148 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/vmesh.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace voodoo {
+namespace {
+uint align(uint offset, uint alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+bool is_block_valid(uint offset, ullong size, size_t file_size) {
+  return offset % VMesh::kAlignment == 0 && offset + size <= file_size;
+}
+}  // namespace
+
+sptr<Mesh> VMesh::Load(const string& filename) {
+  return Load(filename, FileSystem::Read(filename));
+}
+
+sptr<Mesh> VMesh::Load(const string& filename, sptr<FileData> mapping) {
+  using namespace std;
+  const byte* data = mapping->GetData();
+  size_t size = mapping->GetSize();
+
+  VMeshHeader header;
+  if (size < sizeof(header)) {
+    throw runtime_error("Invalid vmesh file: \"" + filename + "\"");
+  }
+  memcpy(&header, data, sizeof(header));
+
+  if (header.magic != kMagic || header.version != kVersion) {
+    throw runtime_error("Unsupported vmesh file: \"" + filename + "\"");
+  }
+
+  if (header.vertex_format != kVertexFormatPtn &&
+      header.vertex_format != kVertexFormatPtnPacked) {
+    throw runtime_error("Corrupted vmesh file: \"" + filename + "\"");
+  }
+
+  auto mesh = make_shared<Mesh>();
+  mesh->vertex_format = static_cast<VertexFormat>(header.vertex_format);
+  if (header.vertex_stride != mesh->GetVertexStride()) {
+    throw runtime_error("Unexpected vmesh vertex stride: \"" + filename + "\"");
+  }
+
+  ullong vertex_bytes = ullong(header.vertex_stride) * header.vertex_count;
+  ullong index_bytes = ullong(sizeof(uint)) * header.index_count;
+  ullong subset_bytes = ullong(sizeof(MeshSubset)) * header.subset_count;
+  if (header.file_size != size ||
+      !is_block_valid(header.vertex_offset, vertex_bytes, size) ||
+      !is_block_valid(header.index_offset, index_bytes, size) ||
+      !is_block_valid(header.subset_offset, subset_bytes, size)) {
+    throw runtime_error("Corrupted vmesh file: \"" + filename + "\"");
+  }
+
+  // Vertex arrays get indexed on the CPU by the optimiser and the atlas
+  // remap, so every index has to be in range
+  auto indices = reinterpret_cast<const uint*>(data + header.index_offset);
+  uint max_index = 0;
+  for (uint i = 0; i < header.index_count; i++)
+    max_index = max(max_index, indices[i]);
+  if (header.index_count > 0 && max_index >= header.vertex_count) {
+    throw runtime_error("Corrupted vmesh file: \"" + filename + "\"");
+  }
+
+  mesh->vertex_count = header.vertex_count;
+  mesh->index_count = header.index_count;
+  mesh->position_offset = float3(header.position_offset[0],
+                                 header.position_offset[1],
+                                 header.position_offset[2]);
+  mesh->position_scale = header.position_scale;
+  mesh->bounds_min = float3(header.bounds_min[0],
+                            header.bounds_min[1],
+                            header.bounds_min[2]);
+  mesh->bounds_max = float3(header.bounds_max[0],
+                            header.bounds_max[1],
+                            header.bounds_max[2]);
+
+  mesh->subsets.resize(header.subset_count);
+  if (header.subset_count > 0) {
+    memcpy(mesh->subsets.data(), data + header.subset_offset, subset_bytes);
+  }
+
+  mesh->mapping = mapping;
+  mesh->mapped_vertices = data + header.vertex_offset;
+  mesh->mapped_indices = indices;
+
+  return mesh;
+}
+
+bool VMesh::Save(const Mesh& mesh, const string& filename) {
+  using namespace std;
+  vector<MeshSubset> subsets = mesh.subsets;
+  if (subsets.empty()) {
+    subsets.push_back(MeshSubset(0, 0, mesh.vertex_count, 0, mesh.index_count / 3));
+  }
+
+  VMeshHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.vertex_format = mesh.vertex_format;
+  header.vertex_stride = mesh.GetVertexStride();
+  header.vertex_count = mesh.vertex_count;
+  header.index_count = mesh.index_count;
+  header.subset_count = static_cast<uint>(subsets.size());
+
+  for (int i = 0; i < 3; i++) {
+    header.bounds_min[i] = mesh.bounds_min[i];
+    header.bounds_max[i] = mesh.bounds_max[i];
+    header.position_offset[i] = mesh.position_offset[i];
+  }
+  header.position_scale = mesh.position_scale;
+
+  uint vertex_bytes = header.vertex_stride * header.vertex_count;
+  uint index_bytes = sizeof(uint) * header.index_count;
+  uint subset_bytes = sizeof(MeshSubset) * header.subset_count;
+
+  header.vertex_offset = align(sizeof(header), kAlignment);
+  header.index_offset = align(header.vertex_offset + vertex_bytes, kAlignment);
+  header.subset_offset = align(header.index_offset + index_bytes, kAlignment);
+  header.file_size = header.subset_offset + subset_bytes;
+
+  vector<byte> buffer(header.file_size, 0);
+  memcpy(buffer.data(), &header, sizeof(header));
+  memcpy(buffer.data() + header.vertex_offset, mesh.GetVertexData(), vertex_bytes);
+  memcpy(buffer.data() + header.index_offset, mesh.GetIndexData(), index_bytes);
+  memcpy(buffer.data() + header.subset_offset, subsets.data(), subset_bytes);
+
+  return FileSystem::Write(filename, buffer.data(), buffer.size());
+}
+}  // namespace voodoo
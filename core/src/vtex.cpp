@@ -0,0 +1,149 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "../include/voodoo/vtex.h"
+
+#include <cstring>
+
+namespace voodoo {
+namespace {
+size_t align(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+sptr<Image> VTex::Load(const string& filename) {
+  return Load(filename, *FileSystem::Read(filename));
+}
+
+sptr<Image> VTex::Load(const string& filename, const FileData& file,
+                       uint first_level) {
+  using namespace std;
+  VTexHeader header = ReadHeader(filename, file);
+  const byte* data = file.GetData();
+  size_t size = file.GetSize();
+
+  auto format = static_cast<ImageFormat>(header.format);
+  uint level_count = header.level_count;
+  first_level = min(first_level, level_count - 1);
+
+  int width = int(header.width), height = int(header.height);
+  for (uint i = 0; i < first_level; i++) {
+    width = max(width / 2, 1);
+    height = max(height / 2, 1);
+  }
+
+  auto image = make_shared<Image>(width, height, int(header.channels), format,
+                                  nullptr);
+  image->mips.resize(level_count - first_level - 1);
+
+  ullong offset = header.data_offset;
+  width = int(header.width);
+  height = int(header.height);
+  for (uint i = 0; i < level_count; i++) {
+    size_t level_size = GetImageLevelSize(format, width, height);
+    if (offset + level_size > size) {
+      throw runtime_error("Corrupted vtex file: \"" + filename + "\"");
+    }
+
+    if (i == first_level) {
+      image->data = new byte[level_size];
+      memcpy(image->data, data + offset, level_size);
+    } else if (i > first_level) {
+      ImageLevel& level = image->mips[i - first_level - 1];
+      level.width = width;
+      level.height = height;
+      level.data.assign(data + offset, data + offset + level_size);
+    }
+
+    offset = align(offset + level_size, kAlignment);
+    width = max(width / 2, 1);
+    height = max(height / 2, 1);
+  }
+
+  return image;
+}
+
+VTexHeader VTex::ReadHeader(const string& filename, const FileData& file) {
+  using namespace std;
+  const byte* data = file.GetData();
+  size_t size = file.GetSize();
+
+  VTexHeader header;
+  if (size < sizeof(header)) {
+    throw runtime_error("Invalid vtex file: \"" + filename + "\"");
+  }
+  memcpy(&header, data, sizeof(header));
+
+  if (header.magic != kMagic || header.version != kVersion ||
+      header.format >= kImageFormatCount) {
+    throw runtime_error("Unsupported vtex file: \"" + filename + "\"");
+  }
+
+  // Chains may stop short of 1x1, e.g. atlas pages stop before their
+  // padding is filtered away
+  uint max_level_count = 1;
+  for (uint extent = max(header.width, header.height); extent > 1; extent /= 2)
+    max_level_count++;
+
+  if (header.width == 0 || header.height == 0 || header.level_count == 0 ||
+      header.level_count > max_level_count || header.file_size != size ||
+      header.data_offset % kAlignment != 0) {
+    throw runtime_error("Corrupted vtex file: \"" + filename + "\"");
+  }
+
+  return header;
+}
+
+bool VTex::Save(const Image& image, const string& filename) {
+  using namespace std;
+  VTexHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.format = image.format;
+  header.width = image.width;
+  header.height = image.height;
+  header.channels = image.channels;
+  header.level_count = uint(image.mips.size()) + 1;
+  header.data_offset = align(sizeof(header), kAlignment);
+  header.file_size = GetSize(image);
+
+  vector<byte> buffer(header.file_size, 0);
+  memcpy(buffer.data(), &header, sizeof(header));
+
+  size_t offset = header.data_offset;
+  size_t level_size =
+      GetImageLevelSize(image.format, image.width, image.height);
+  memcpy(buffer.data() + offset, image.data, level_size);
+  offset = align(offset + level_size, kAlignment);
+  for (const auto& level : image.mips) {
+    memcpy(buffer.data() + offset, level.data.data(), level.data.size());
+    offset = align(offset + level.data.size(), kAlignment);
+  }
+
+  return FileSystem::Write(filename, buffer.data(), buffer.size());
+}
+
+size_t VTex::GetSize(const Image& image) {
+  size_t size = align(sizeof(VTexHeader), kAlignment);
+  size += align(GetImageLevelSize(image.format, image.width, image.height),
+                kAlignment);
+  for (const auto& level : image.mips)
+    size += align(level.data.size(), kAlignment);
+
+  return size;
+}
+}  // namespace voodoo
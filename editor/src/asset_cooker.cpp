@@ -0,0 +1,392 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asset_cooker.h"
+#include "atlas_converter.h"
+#include "model_converter.h"
+#include "texture_converter.h"
+
+#include <voodoo/hash.h>
+#include <voodoo/mapped_file.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace voodoo {
+namespace {
+const char* kManifestName = "cook_manifest.txt";
+
+bool IsModel(const fs::path& path) {
+  std::string extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension == ".obj";
+}
+
+bool IsTexture(const fs::path& path) {
+  std::string extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension == ".png" || extension == ".jpg" ||
+         extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+bool IsAtlas(const fs::path& path) {
+  return path.extension() == ".atlas";
+}
+
+const char* GetFormatName(ImageFormat format) {
+  switch (format) {
+    case kImageFormatBc1:
+      return "BC1";
+    case kImageFormatBc3:
+      return "BC3";
+    case kImageFormatBc4:
+      return "BC4";
+    case kImageFormatBc7:
+      return "BC7";
+    default:
+      return "RGBA8";
+  }
+}
+}  // namespace
+
+AssetCooker::AssetCooker(uint thread_count, BlockQuality texture_quality)
+    : thread_count_(thread_count), texture_quality_(texture_quality) {
+  if (thread_count_ == 0) thread_count_ = std::thread::hardware_concurrency();
+  if (thread_count_ == 0) thread_count_ = 1;
+
+  stats_ = {0, 0, 0, 0.0, 0, 0, 0, 0, 0.0, 0.0, 0, 0, 0, 0, 0, 0};
+}
+
+bool AssetCooker::Cook(const std::vector<std::string>& directories,
+                       bool force) {
+  using namespace std::chrono;
+
+  auto start = high_resolution_clock::now();
+  stats_ = {0, 0, 0, 0.0, 0, 0, 0, 0, 0.0, 0.0, 0, 0, 0, 0, 0, 0};
+
+  bool result = true;
+  for (const auto& directory : directories) {
+    if (!CookDirectory(directory, force)) result = false;
+  }
+
+  duration<double, std::milli> elapsed = high_resolution_clock::now() - start;
+  stats_.time = elapsed.count();
+  if (stats_.textures > 0) stats_.texture_psnr /= stats_.textures;
+
+  return result;
+}
+
+const CookStats& AssetCooker::GetStats() const { return stats_; }
+
+bool AssetCooker::CookDirectory(const std::string& directory, bool force) {
+  std::error_code error;
+  fs::path root(directory);
+  if (!fs::is_directory(root, error)) {
+    std::cerr << "Not a directory: " << directory << std::endl;
+    return false;
+  }
+
+  // A missing or outdated manifest simply cooks everything
+  Manifest previous;
+  std::string manifest_path = (root / kManifestName).string();
+  if (!force) ReadManifest(manifest_path, previous);
+
+  std::vector<std::string> sources;
+  for (fs::recursive_directory_iterator it(root, error), end; it != end;
+       it.increment(error)) {
+    if (error) break;
+    if (it->is_regular_file(error) &&
+        (IsModel(it->path()) || IsTexture(it->path()) ||
+         IsAtlas(it->path())))
+      sources.push_back(it->path().lexically_relative(root).generic_string());
+  }
+  std::sort(sources.begin(), sources.end());
+
+  // Every asset is cooked on a single thread, the pool spreads assets
+  // across cores
+  std::vector<Entry> entries(sources.size());
+  std::vector<CookResult> results(sources.size());
+  std::vector<TextureCookStats> textures(sources.size());
+  std::vector<AtlasCookStats> atlases(sources.size());
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < sources.size(); i = next++) {
+      results[i] = CookAsset(directory, sources[i], previous, force,
+                             entries[i], textures[i], atlases[i]);
+    }
+  };
+
+  uint thread_count =
+      std::min<uint>(thread_count_, static_cast<uint>(sources.size()));
+  std::vector<std::thread> threads;
+  for (uint i = 1; i < thread_count; i++) threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads) thread.join();
+
+  // Failed assets are left out so that the next run retries them
+  Manifest manifest;
+  for (size_t i = 0; i < sources.size(); i++) {
+    if (results[i] == kCookResultFailed) {
+      std::cerr << "Failed to cook: " << (root / sources[i]).string()
+                << std::endl;
+      stats_.failed++;
+      continue;
+    }
+
+    if (results[i] == kCookResultSkipped)
+      stats_.skipped++;
+    else
+      stats_.cooked++;
+    manifest[sources[i]] = std::move(entries[i]);
+
+    const AtlasCookStats& atlas = atlases[i];
+    if (results[i] == kCookResultCooked && atlas.pages > 0) {
+      std::cout << sources[i] << ": " << atlas.textures << " textures on "
+                << atlas.pages << " pages, " << std::fixed
+                << std::setprecision(1) << atlas.occupancy * 100.0
+                << "% occupied, " << atlas.skipped << " left out, "
+                << atlas.draws << " draws take " << atlas.binds_before
+                << " -> " << atlas.binds_after << " texture binds"
+                << std::defaultfloat << std::setprecision(6) << std::endl;
+      stats_.atlases++;
+      stats_.atlas_textures += atlas.textures;
+      stats_.atlas_pages += atlas.pages;
+      stats_.atlas_draws += atlas.draws;
+      stats_.atlas_binds_before += atlas.binds_before;
+      stats_.atlas_binds_after += atlas.binds_after;
+    }
+
+    const TextureCookStats& texture = textures[i];
+    if (results[i] != kCookResultCooked || texture.pixels == 0) continue;
+
+    std::cout << sources[i] << ": " << GetFormatName(texture.format) << ", "
+              << texture.source_bytes << " -> " << texture.cooked_bytes
+              << " bytes, " << std::fixed << std::setprecision(2)
+              << texture.psnr << " dB, " << texture.encode_time << " ms"
+              << std::defaultfloat << std::setprecision(6) << std::endl;
+    stats_.textures++;
+    stats_.texture_pixels += texture.pixels;
+    stats_.texture_source_bytes += texture.source_bytes;
+    stats_.texture_cooked_bytes += texture.cooked_bytes;
+    stats_.texture_encode_time += texture.encode_time;
+    stats_.texture_psnr += texture.psnr;
+  }
+
+  if (!WriteManifest(manifest_path, manifest)) {
+    std::cerr << "Failed to write manifest: " << manifest_path << std::endl;
+    return false;
+  }
+
+  return std::find(results.begin(), results.end(), kCookResultFailed) ==
+         results.end();
+}
+
+CookResult AssetCooker::CookAsset(const std::string& directory,
+                                  const std::string& source,
+                                  const Manifest& manifest, bool force,
+                                  Entry& entry, TextureCookStats& texture,
+                                  AtlasCookStats& atlas) {
+  fs::path root(directory);
+
+  auto it = manifest.find(source);
+  if (!force && it != manifest.end()) {
+    const Entry& previous = it->second;
+    bool up_to_date = true;
+
+    std::error_code error;
+    for (const auto& output : previous.outputs) {
+      if (!fs::exists(root / output, error)) up_to_date = false;
+    }
+
+    // Size and time stamp match skips hashing, touched but unchanged
+    // files only get their time stamp updated
+    for (const auto& dependency : previous.dependencies) {
+      if (!up_to_date) break;
+
+      Dependency current;
+      current.path = dependency.path;
+      current.hash = dependency.hash;
+      if (!Stat((root / dependency.path).string(), current)) {
+        up_to_date = false;
+      } else if (current.size != dependency.size ||
+                 current.time != dependency.time) {
+        up_to_date =
+            current.size == dependency.size &&
+            Hash((root / dependency.path).string(), current.hash) &&
+            current.hash == dependency.hash;
+      }
+
+      entry.dependencies.push_back(current);
+    }
+
+    if (up_to_date) {
+      entry.outputs = previous.outputs;
+      return kCookResultSkipped;
+    }
+  }
+
+  // Assets other than atlases only depend on their source, materials are
+  // not cooked yet
+  std::string path = (root / source).string();
+  Dependency dependency;
+  dependency.path = source;
+  if (!Stat(path, dependency) || !Hash(path, dependency.hash))
+    return kCookResultFailed;
+
+  if (IsAtlas(path)) {
+    AtlasConverter converter(texture_quality_);
+    if (!converter.Cook(path)) return kCookResultFailed;
+
+    atlas = converter.GetStats();
+    fs::path base = root.lexically_normal();
+    entry.dependencies.assign(1, dependency);
+    for (const auto& file : converter.GetDependencies()) {
+      Dependency texture_or_mesh;
+      texture_or_mesh.path =
+          fs::path(file).lexically_relative(base).generic_string();
+      if (texture_or_mesh.path == source) continue;
+      if (!Stat(file, texture_or_mesh) || !Hash(file, texture_or_mesh.hash))
+        return kCookResultFailed;
+      entry.dependencies.push_back(texture_or_mesh);
+    }
+    for (const auto& file : converter.GetOutputs())
+      entry.outputs.push_back(
+          fs::path(file).lexically_relative(base).generic_string());
+
+    return kCookResultCooked;
+  }
+
+  if (IsTexture(path)) {
+    TextureConverter converter(texture_quality_);
+    if (!converter.Cook(path)) return kCookResultFailed;
+
+    texture = converter.GetStats();
+    entry.outputs = TextureConverter::GetOutputs(source);
+  } else {
+    ModelConverter converter;
+    if (!converter.Cook(path, 1)) return kCookResultFailed;
+
+    entry.outputs = ModelConverter::GetOutputs(source);
+  }
+  entry.dependencies.assign(1, dependency);
+
+  return kCookResultCooked;
+}
+
+bool AssetCooker::Stat(const std::string& filename, Dependency& dependency) {
+  std::error_code error;
+  dependency.size = fs::file_size(filename, error);
+  if (error) return false;
+
+  dependency.time = static_cast<llong>(
+      fs::last_write_time(filename, error).time_since_epoch().count());
+
+  return !error;
+}
+
+bool AssetCooker::Hash(const std::string& filename, ullong& hash) {
+  try {
+    MappedFile file(filename);
+    hash = Fnv1a(file.GetData(), file.GetSize());
+  } catch (const std::exception&) {
+    return false;
+  }
+
+  // Output format changes invalidate every cooked asset
+  hash = Fnv1a(&kVersion, sizeof(kVersion), hash);
+
+  return true;
+}
+
+bool AssetCooker::ReadManifest(const std::string& filename,
+                               Manifest& manifest) {
+  std::ifstream input_fs(filename);
+  if (input_fs.fail()) return false;
+
+  std::string line, label;
+  uint version = 0;
+  Entry* entry = nullptr;
+
+  while (std::getline(input_fs, line)) {
+    size_t colon = line.find(": ");
+    if (colon == std::string::npos) continue;
+
+    label = line.substr(0, colon);
+    std::string value = line.substr(colon + 2);
+
+    if (label == "Version") {
+      version = static_cast<uint>(std::strtoul(value.c_str(), nullptr, 10));
+      if (version != kVersion) break;
+    } else if (label == "Asset") {
+      entry = &manifest[value];
+    } else if (label == "Dependency" && entry) {
+      // Hash, size and time come first, the path may contain spaces
+      Dependency dependency;
+      std::istringstream input_ss(value);
+      input_ss >> std::hex >> dependency.hash >> std::dec >> dependency.size >>
+          dependency.time;
+      input_ss.get();
+      std::getline(input_ss, dependency.path);
+      if (input_ss.fail() || dependency.path.empty()) break;
+      entry->dependencies.push_back(dependency);
+    } else if (label == "Output" && entry) {
+      entry->outputs.push_back(value);
+    }
+  }
+
+  if (version != kVersion || !input_fs.eof()) {
+    manifest.clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool AssetCooker::WriteManifest(const std::string& filename,
+                                const Manifest& manifest) {
+  std::ofstream output_fs(filename);
+  if (output_fs.fail()) return false;
+
+  output_fs << "Version: " << kVersion << std::endl;
+  output_fs << "Asset Count: " << manifest.size() << std::endl;
+
+  for (const auto& asset : manifest) {
+    output_fs << std::endl;
+    output_fs << "Asset: " << asset.first << std::endl;
+    for (const auto& dependency : asset.second.dependencies) {
+      output_fs << "Dependency: " << std::hex << std::setw(16)
+                << std::setfill('0') << dependency.hash << std::dec << ' '
+                << dependency.size << ' ' << dependency.time << ' '
+                << dependency.path << std::endl;
+    }
+    for (const auto& output : asset.second.outputs)
+      output_fs << "Output: " << output << std::endl;
+  }
+
+  return !output_fs.fail();
+}
+}  // namespace voodoo
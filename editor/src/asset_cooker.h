@@ -0,0 +1,95 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_ASSET_COOKER_H_
+#define VOODOO_ASSET_COOKER_H_
+
+#include "atlas_converter.h"
+#include "texture_converter.h"
+
+#include <voodoo/std_mappings.h>
+
+namespace voodoo {
+enum CookResult { kCookResultCooked = 0, kCookResultSkipped, kCookResultFailed };
+
+struct CookStats {
+  uint cooked, skipped, failed;
+  double time;
+
+  // Of the textures cooked in this run
+  uint textures;
+  ullong texture_pixels;
+  size_t texture_source_bytes, texture_cooked_bytes;
+  double texture_encode_time, texture_psnr;
+
+  // Of the atlases cooked in this run
+  uint atlases, atlas_textures, atlas_pages;
+  uint atlas_draws, atlas_binds_before, atlas_binds_after;
+};
+
+// Non-interactive batch conversion of every source asset below a set of
+// directories. Each directory keeps a manifest of its sources with their
+// dependencies, content hashes and outputs, so that only assets whose
+// dependencies changed are cooked again.
+class AssetCooker final {
+ public:
+  static constexpr uint kVersion = 1;
+
+  // Zero thread count uses every hardware thread
+  explicit AssetCooker(uint thread_count = 0,
+                       BlockQuality texture_quality = kBlockQualityNormal);
+
+  // Ignores the manifest and cooks everything when forced
+  bool Cook(const std::vector<std::string>& directories, bool force = false);
+
+  const CookStats& GetStats() const;
+
+ private:
+  struct Dependency {
+    std::string path;
+    ullong hash;
+
+    // Cheap change detection, the hash is only checked when these differ
+    ullong size;
+    llong time;
+  };
+
+  struct Entry {
+    std::vector<Dependency> dependencies;
+    std::vector<std::string> outputs;
+  };
+
+  typedef std::map<std::string, Entry> Manifest;
+
+  bool CookDirectory(const std::string& directory, bool force);
+  CookResult CookAsset(const std::string& directory, const std::string& source,
+                       const Manifest& manifest, bool force, Entry& entry,
+                       TextureCookStats& texture, AtlasCookStats& atlas);
+
+  static bool Stat(const std::string& filename, Dependency& dependency);
+  static bool Hash(const std::string& filename, ullong& hash);
+
+  static bool ReadManifest(const std::string& filename, Manifest& manifest);
+  static bool WriteManifest(const std::string& filename,
+                            const Manifest& manifest);
+
+ private:
+  uint thread_count_;
+  BlockQuality texture_quality_;
+  CookStats stats_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_ASSET_COOKER_H_
@@ -0,0 +1,169 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "asset_packer.h"
+
+#include <voodoo/file_system.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+namespace voodoo {
+namespace {
+const char* kSkippedFiles[] = {"cook_manifest.txt"};
+
+// Binary meshes are mapped straight from the archive, and compressed
+// images would only waste time in the codec
+const char* kStoredExtensions[] = {".vmesh", ".jpg", ".png"};
+}  // namespace
+
+bool AssetPacker::Pack(const std::string& directory,
+                       const std::string& archive) {
+  using namespace std::chrono;
+
+  std::error_code error;
+  fs::path root(directory);
+  if (!fs::is_directory(root, error)) {
+    std::cerr << "Not a directory: " << directory << std::endl;
+    return false;
+  }
+
+  sources_.clear();
+  fs::path output = fs::absolute(archive, error).lexically_normal();
+  for (fs::recursive_directory_iterator it(root, error), end; it != end;
+       it.increment(error)) {
+    if (error) break;
+    if (!it->is_regular_file(error)) continue;
+
+    const fs::path& path = it->path();
+    if (fs::absolute(path, error).lexically_normal() == output) continue;
+
+    std::string filename = path.filename().string();
+    std::string extension = path.extension().string();
+    bool skipped = false;
+    for (auto name : kSkippedFiles) skipped = skipped || filename == name;
+    if (skipped) continue;
+
+    ArchiveSource source;
+    source.name = path.lexically_relative(root).generic_string();
+    source.path = path.string();
+    source.compress = true;
+    for (auto stored : kStoredExtensions)
+      source.compress = source.compress && extension != stored;
+    sources_.push_back(source);
+  }
+
+  auto start = high_resolution_clock::now();
+  if (!Archive::Write(archive, sources_, &stats_)) return false;
+  duration<double, std::milli> elapsed = high_resolution_clock::now() - start;
+  pack_time_ = elapsed.count();
+
+  return Verify(archive) && ReadQueued(directory, archive);
+}
+
+const ArchiveStats& AssetPacker::GetStats() const { return stats_; }
+
+double AssetPacker::GetPackTime() const { return pack_time_; }
+
+double AssetPacker::GetLooseReadTime() const { return loose_read_time_; }
+
+double AssetPacker::GetArchiveReadTime() const { return archive_read_time_; }
+
+const IoStats& AssetPacker::GetIoStats() const { return io_stats_; }
+
+bool AssetPacker::Verify(const std::string& archive) {
+  using namespace std::chrono;
+
+  std::vector<sptr<FileData>> loose;
+  auto start = high_resolution_clock::now();
+  try {
+    for (const auto& source : sources_)
+      loose.push_back(std::make_shared<FileData>(
+          std::make_shared<MappedFile>(source.path)));
+
+    // Touch the data so that mapped files are actually read
+    ullong sum = 0;
+    for (const auto& file : loose) {
+      for (size_t i = 0; i < file->GetSize(); i += 4096)
+        sum += file->GetData()[i];
+    }
+    (void)sum;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  duration<double, std::milli> elapsed = high_resolution_clock::now() - start;
+  loose_read_time_ = elapsed.count();
+
+  // Opening is part of the cost, the archive replaces many opens by one
+  start = high_resolution_clock::now();
+  try {
+    Archive packed(archive);
+    for (size_t i = 0; i < sources_.size(); i++) {
+      auto entry = packed.Find(sources_[i].name);
+      if (!entry) return false;
+
+      auto file = packed.Read(*entry);
+      if (file->GetSize() != loose[i]->GetSize() ||
+          memcmp(file->GetData(), loose[i]->GetData(), file->GetSize()) != 0) {
+        std::cerr << "Archive entry differs: " << sources_[i].name
+                  << std::endl;
+        return false;
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  elapsed = high_resolution_clock::now() - start;
+  archive_read_time_ = elapsed.count();
+
+  return true;
+}
+
+bool AssetPacker::ReadQueued(const std::string& directory,
+                             const std::string& archive) {
+  if (!FileSystem::Mount(archive, directory)) return false;
+
+  IoQueue& queue = IoQueue::Get();
+  queue.ResetStats();
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  size_t remaining = sources_.size();
+  for (const auto& source : sources_) {
+    queue.Read((fs::path(directory) / source.name).string(), kIoPriorityNormal,
+               [&](sptr<FileData> file, std::exception_ptr error) {
+                 std::lock_guard<std::mutex> lock(mutex);
+                 if (--remaining == 0) condition.notify_one();
+               });
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&remaining]() { return remaining == 0; });
+  }
+  FileSystem::UnmountAll();
+
+  io_stats_ = queue.GetStats();
+  return io_stats_.failed == 0;
+}
+}  // namespace voodoo
@@ -0,0 +1,51 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_ASSET_PACKER_H_
+#define VOODOO_ASSET_PACKER_H_
+
+#include <voodoo/archive.h>
+#include <voodoo/io_queue.h>
+
+namespace voodoo {
+// Packs every file below a directory into an archive that can be mounted
+// at that directory
+class AssetPacker final {
+ public:
+  bool Pack(const std::string& directory, const std::string& archive);
+
+  const ArchiveStats& GetStats() const;
+  double GetPackTime() const;
+
+  // Reading every entry from loose files and from the archive
+  double GetLooseReadTime() const;
+  double GetArchiveReadTime() const;
+
+  // Reading every entry through the mounted archive on the I/O queue
+  const IoStats& GetIoStats() const;
+
+ private:
+  bool Verify(const std::string& archive);
+  bool ReadQueued(const std::string& directory, const std::string& archive);
+
+ private:
+  std::vector<ArchiveSource> sources_;
+  ArchiveStats stats_;
+  IoStats io_stats_;
+  double pack_time_, loose_read_time_, archive_read_time_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_ASSET_PACKER_H_
@@ -0,0 +1,405 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "atlas_converter.h"
+
+#include <voodoo/mesh_manager.h>
+#include <voodoo/vmesh.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+namespace fs = std::filesystem;
+
+namespace voodoo {
+namespace {
+// Outside of this texture coordinates are taken to repeat the texture
+constexpr float kUvEpsilon = 1e-4f;
+
+std::string Trim(const std::string& value) {
+  size_t begin = value.find_first_not_of(" \t\r");
+  size_t end = value.find_last_not_of(" \t\r");
+  return begin == std::string::npos ? std::string()
+                                    : value.substr(begin, end - begin + 1);
+}
+
+std::string Join(const std::string& directory, const std::string& path) {
+  return (fs::path(directory) / path).lexically_normal().generic_string();
+}
+}  // namespace
+
+AtlasConverter::AtlasConverter(BlockQuality quality)
+    : quality_(quality), page_size_(1024), padding_(8), occupancy_(0.0) {
+  stats_ = {0, 0, 0, 0.0, 0, 0, 0};
+}
+
+bool AtlasConverter::Cook(const std::string& filename) {
+  stats_ = {0, 0, 0, 0.0, 0, 0, 0};
+  sources_.clear();
+  meshes_.clear();
+  page_sizes_.clear();
+  occupancy_ = 0.0;
+  atlas_ = TextureAtlas();
+  dependencies_.assign(
+      1, fs::path(filename).lexically_normal().generic_string());
+  outputs_.clear();
+
+  fs::path path(filename);
+  std::string directory = path.parent_path().string();
+  std::string name = path.stem().string();
+
+  if (!ReadDescription(filename) || !LoadSources(directory) ||
+      !LoadMeshes(directory))
+    return false;
+
+  Pack(true);
+  Pack(false);
+
+  if (!WritePages(directory, name) || !WriteMeshes(directory)) return false;
+
+  std::string manifest = Join(directory, name + ".vatlas");
+  if (!atlas_.Save(manifest)) {
+    std::cerr << "Failed to write atlas: " << manifest << std::endl;
+    return false;
+  }
+  outputs_.push_back(manifest);
+
+  CountBinds();
+
+  return true;
+}
+
+const AtlasCookStats& AtlasConverter::GetStats() const { return stats_; }
+
+const std::vector<std::string>& AtlasConverter::GetDependencies() const {
+  return dependencies_;
+}
+
+const std::vector<std::string>& AtlasConverter::GetOutputs() const {
+  return outputs_;
+}
+
+bool AtlasConverter::ReadDescription(const std::string& filename) {
+  std::ifstream input_fs(filename);
+  if (input_fs.fail()) {
+    std::cerr << "Failed to read atlas description: " << filename << std::endl;
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(input_fs, line)) {
+    size_t colon = line.find(": ");
+    if (colon == std::string::npos) continue;
+
+    std::string label = Trim(line.substr(0, colon));
+    std::string value = Trim(line.substr(colon + 2));
+
+    if (label == "Page Size") {
+      page_size_ = std::atoi(value.c_str());
+    } else if (label == "Padding") {
+      padding_ = std::atoi(value.c_str());
+    } else if (label == "Texture") {
+      Source source;
+      source.name = value;
+      source.opaque = true;
+      source.packed = true;
+      source.page = 0;
+      source.rect = {0, 0, 0, 0};
+      sources_.push_back(source);
+    } else if (label == "Mesh") {
+      // The mesh path comes first, the texture after the last comma
+      size_t comma = value.find_last_of(',');
+      if (comma == std::string::npos) {
+        std::cerr << "Mesh without texture in " << filename << ": " << value
+                  << std::endl;
+        return false;
+      }
+      meshes_.push_back({Trim(value.substr(0, comma)),
+                         Trim(value.substr(comma + 1)), nullptr});
+    }
+  }
+
+  // Pages are square powers of two that fit a few textures each
+  if (page_size_ < 64 || (page_size_ & (page_size_ - 1)) != 0 ||
+      padding_ < 0 || padding_ > page_size_ / 8) {
+    std::cerr << "Invalid page size or padding in " << filename << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool AtlasConverter::LoadSources(const std::string& directory) {
+  for (auto& source : sources_) {
+    std::string path = Join(directory, source.name);
+    dependencies_.push_back(path);
+
+    source.image = TextureConverter::Load(path);
+    if (!source.image) return false;
+
+    const Image& image = *source.image;
+    size_t count = size_t(image.width) * image.height;
+    for (size_t i = 0; i < count && source.opaque; i++)
+      source.opaque = image.data[i * 4 + 3] == 255;
+
+    int limit = page_size_ / 2 - 2 * padding_;
+    if (image.width > limit || image.height > limit) source.packed = false;
+  }
+
+  return true;
+}
+
+bool AtlasConverter::LoadMeshes(const std::string& directory) {
+  for (auto& entry : meshes_) {
+    std::string path = Join(directory, entry.mesh);
+    if (std::find(dependencies_.begin(), dependencies_.end(), path) ==
+        dependencies_.end())
+      dependencies_.push_back(path);
+
+    Source* source = FindSource(entry.texture);
+    if (!source) {
+      std::cerr << "Mesh texture is not in the atlas: " << entry.texture
+                << std::endl;
+      return false;
+    }
+
+    try {
+      entry.data = MeshManager::Get().Retrieve(path);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return false;
+    }
+
+    if (entry.data->vertex_format != kVertexFormatPtn) {
+      std::cerr << "Packed meshes can not be remapped: " << path << std::endl;
+      return false;
+    }
+
+    // Repeating textures can only stay on their own
+    const vertex_ptn* vertices =
+        static_cast<const vertex_ptn*>(entry.data->GetVertexData());
+    for (uint i = 0; i < entry.data->vertex_count && source->packed; i++) {
+      const float2& uv = vertices[i].texture;
+      source->packed = uv.x >= -kUvEpsilon && uv.x <= 1.0f + kUvEpsilon &&
+                       uv.y >= -kUvEpsilon && uv.y <= 1.0f + kUvEpsilon;
+    }
+  }
+
+  for (const auto& source : sources_) {
+    if (!source.packed) stats_.skipped++;
+  }
+
+  return true;
+}
+
+void AtlasConverter::Pack(bool opaque) {
+  std::vector<Source*> remaining;
+  for (auto& source : sources_) {
+    if (source.packed && source.opaque == opaque) remaining.push_back(&source);
+  }
+
+  // Padded sizes are whole blocks, so that block compression never mixes
+  // two textures at the top level
+  auto padded = [this](int extent) {
+    return (extent + 2 * padding_ + 3) / 4 * 4;
+  };
+
+  // Largest first
+  std::sort(remaining.begin(), remaining.end(),
+            [](const Source* a, const Source* b) {
+              int a_side = std::max(a->image->width, a->image->height);
+              int b_side = std::max(b->image->width, b->image->height);
+              if (a_side != b_side) return a_side > b_side;
+              return a->image->width * a->image->height >
+                     b->image->width * b->image->height;
+            });
+
+  while (!remaining.empty()) {
+    ullong area = 0;
+    for (const auto* source : remaining)
+      area += ullong(padded(source->image->width)) *
+              padded(source->image->height);
+
+    // The smallest page that may hold everything left, grown until it
+    // does or the page size is reached
+    int size = 4;
+    while (ullong(size) * size < area && size < page_size_) size *= 2;
+
+    std::vector<Source*> rest;
+    int width = 0, height = 0;
+    double occupancy = 0.0;
+    for (;; size *= 2) {
+      RectPacker packer(size, size);
+      rest.clear();
+      width = height = 0;
+      for (auto* source : remaining) {
+        PackedRect& rect = source->rect;
+        if (packer.Insert(padded(source->image->width),
+                          padded(source->image->height), rect)) {
+          width = std::max(width, rect.x + rect.width);
+          height = std::max(height, rect.y + rect.height);
+        } else {
+          rest.push_back(source);
+        }
+      }
+
+      occupancy = packer.GetOccupancy();
+      if (rest.empty() || size >= page_size_) break;
+    }
+
+    // Pages are trimmed to the texels in use, which are whole blocks
+    occupancy *= double(size) * size / (double(width) * height);
+
+    uint page = static_cast<uint>(page_sizes_.size());
+    page_sizes_.emplace_back(width, height);
+    occupancy_ += occupancy;
+    for (auto* source : remaining) {
+      if (std::find(rest.begin(), rest.end(), source) == rest.end())
+        source->page = page;
+    }
+
+    remaining.swap(rest);
+  }
+}
+
+bool AtlasConverter::WritePages(const std::string& directory,
+                                const std::string& name) {
+  // The padding lasts log2(padding) levels
+  uint level_count = 1;
+  for (int padding = padding_; padding > 1; padding /= 2) level_count++;
+
+  for (uint page = 0; page < page_sizes_.size(); page++) {
+    int width = page_sizes_[page].first;
+    int height = page_sizes_[page].second;
+
+    // Unused texels of opaque pages stay opaque, so that they are still
+    // compressed without alpha
+    bool opaque = true;
+    byte* texels = new byte[size_t(width) * height * 4]();
+    Image image(width, height, 4, texels);
+
+    for (const auto& source : sources_) {
+      if (!source.packed || source.page != page) continue;
+      opaque = source.opaque;
+
+      // Edge texels are repeated into the padding
+      const Image& texture = *source.image;
+      const PackedRect& rect = source.rect;
+      for (int y = 0; y < rect.height; y++) {
+        int source_y = std::clamp(y - padding_, 0, texture.height - 1);
+        byte* row = texels + (size_t(rect.y + y) * width + rect.x) * 4;
+        for (int x = 0; x < rect.width; x++) {
+          int source_x = std::clamp(x - padding_, 0, texture.width - 1);
+          size_t texel = size_t(source_y) * texture.width + source_x;
+          memcpy(row + x * 4, texture.data + texel * 4, 4);
+        }
+      }
+
+      AtlasRegion region;
+      region.page = page;
+      region.offset = float2(float(rect.x + padding_) / width,
+                             float(rect.y + padding_) / height);
+      region.scale = float2(float(texture.width) / width,
+                            float(texture.height) / height);
+      atlas_.regions[source.name] = region;
+      stats_.textures++;
+    }
+
+    if (opaque) {
+      for (size_t i = 0; i < size_t(width) * height; i++)
+        texels[i * 4 + 3] = 255;
+      image.channels = 3;
+    }
+
+    std::string filename = name + "_" + std::to_string(page) + ".vtex";
+    std::string output = Join(directory, filename);
+    TextureConverter converter(quality_);
+    if (!converter.Cook(image, level_count, output)) return false;
+
+    atlas_.pages.push_back(filename);
+    outputs_.push_back(output);
+  }
+
+  stats_.pages = static_cast<uint>(page_sizes_.size());
+  if (stats_.pages > 0) stats_.occupancy = occupancy_ / stats_.pages;
+
+  return true;
+}
+
+bool AtlasConverter::WriteMeshes(const std::string& directory) {
+  for (const auto& entry : meshes_) {
+    const AtlasRegion* region = atlas_.Find(entry.texture);
+    if (!region) continue;
+
+    const Mesh& source = *entry.data;
+    const vertex_ptn* vertices =
+        static_cast<const vertex_ptn*>(source.GetVertexData());
+    const uint* indices = source.GetIndexData();
+
+    Mesh mesh(std::vector<vertex_ptn>(vertices, vertices + source.vertex_count),
+              std::vector<uint>(indices, indices + source.index_count));
+    mesh.subsets = source.subsets;
+    mesh.bounds_min = source.bounds_min;
+    mesh.bounds_max = source.bounds_max;
+    for (auto& vertex : mesh.vertices) {
+      vertex.texture.x = region->offset.x + vertex.texture.x * region->scale.x;
+      vertex.texture.y = region->offset.y + vertex.texture.y * region->scale.y;
+    }
+
+    fs::path path(Join(directory, entry.mesh));
+    std::string texture = fs::path(entry.texture).stem().string();
+    std::string output =
+        (path.parent_path() / (path.stem().string() + "_" + texture + ".vmesh"))
+            .generic_string();
+    if (!VMesh::Save(mesh, output)) {
+      std::cerr << "Failed to write mesh: " << output << std::endl;
+      return false;
+    }
+    outputs_.push_back(output);
+  }
+
+  return true;
+}
+
+void AtlasConverter::CountBinds() {
+  // Packed textures bind their page, others themselves
+  std::set<std::string> before;
+  std::set<std::pair<int, std::string>> after;
+  for (const auto& entry : meshes_) {
+    before.insert(entry.texture);
+    const AtlasRegion* region = atlas_.Find(entry.texture);
+    if (region)
+      after.emplace(int(region->page), std::string());
+    else
+      after.emplace(-1, entry.texture);
+  }
+
+  stats_.draws = static_cast<uint>(meshes_.size());
+  stats_.binds_before = static_cast<uint>(before.size());
+  stats_.binds_after = static_cast<uint>(after.size());
+}
+
+AtlasConverter::Source* AtlasConverter::FindSource(const std::string& name) {
+  for (auto& source : sources_) {
+    if (source.name == name) return &source;
+  }
+  return nullptr;
+}
+}  // namespace voodoo
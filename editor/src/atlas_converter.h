@@ -0,0 +1,112 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_ATLAS_CONVERTER_H_
+#define VOODOO_ATLAS_CONVERTER_H_
+
+#include "rect_packer.h"
+#include "texture_converter.h"
+
+#include <voodoo/mesh.h>
+#include <voodoo/texture_atlas.h>
+
+namespace voodoo {
+struct AtlasCookStats {
+  uint textures, skipped, pages;
+
+  // Mean over the pages
+  double occupancy;
+
+  // Draws of the listed meshes and the texture binds they take before and
+  // after packing, with draws sorted by texture
+  uint draws, binds_before, binds_after;
+};
+
+// Packs the small textures listed in an .atlas description into shared
+// pages and remaps the texture coordinates of the meshes drawn with them,
+// so that their materials bind the same texture. Descriptions are lists of
+// "Label: value" lines with paths relative to the description:
+//
+//   Page Size: 1024
+//   Padding: 8
+//   Texture: placeholder_red.jpg
+//   Mesh: ../meshes/cube.mesh, placeholder_red.jpg
+//
+// Pages are at most Page Size wide and high and trimmed to the texels in
+// use. Opaque textures and those with alpha go to separate pages, as they
+// are block compressed differently. Textures larger than half a page, and
+// those whose meshes repeat them outside [0, 1], are left as they are.
+// Every texture is surrounded by padding of its edge texels so that
+// filtering does not bleed across, and page mip chains stop once the
+// padding would be filtered away.
+//
+// Writes <name>_<page>.vtex pages and a <name>.vatlas manifest next to the
+// description, and <mesh>_<texture>.vmesh next to each listed mesh.
+class AtlasConverter final {
+ public:
+  explicit AtlasConverter(BlockQuality quality = kBlockQualityNormal);
+
+  bool Cook(const std::string& filename);
+
+  const AtlasCookStats& GetStats() const;
+
+  // Files read and written by the last Cook()
+  const std::vector<std::string>& GetDependencies() const;
+  const std::vector<std::string>& GetOutputs() const;
+
+ private:
+  struct Source {
+    std::string name;
+    sptr<Image> image;
+    bool opaque;
+    bool packed;
+    uint page;
+    PackedRect rect;
+  };
+
+  struct MeshEntry {
+    std::string mesh;
+    std::string texture;
+    sptr<Mesh> data;
+  };
+
+  bool ReadDescription(const std::string& filename);
+  bool LoadSources(const std::string& directory);
+  bool LoadMeshes(const std::string& directory);
+  void Pack(bool opaque);
+  bool WritePages(const std::string& directory, const std::string& name);
+  bool WriteMeshes(const std::string& directory);
+  void CountBinds();
+
+  Source* FindSource(const std::string& name);
+
+ private:
+  BlockQuality quality_;
+  int page_size_;
+  int padding_;
+
+  std::vector<Source> sources_;
+  std::vector<MeshEntry> meshes_;
+  std::vector<std::pair<int, int>> page_sizes_;
+  double occupancy_;
+  TextureAtlas atlas_;
+
+  AtlasCookStats stats_;
+  std::vector<std::string> dependencies_;
+  std::vector<std::string> outputs_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_ATLAS_CONVERTER_H_
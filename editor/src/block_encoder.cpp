@@ -0,0 +1,618 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "block_encoder.h"
+
+#include <voodoo/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace voodoo {
+namespace {
+typedef unsigned short uint16;
+
+// Texels of one 4x4 block, row by row
+typedef byte BlockTexels[16][4];
+
+const int kBc7Weights[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                             34, 38, 43, 47, 51, 55, 60, 64};
+
+void FetchBlock(const byte* rgba, int width, int height, int block_x,
+                int block_y, BlockTexels& texels) {
+  for (int y = 0; y < 4; y++) {
+    int row = std::min(block_y * 4 + y, height - 1);
+    for (int x = 0; x < 4; x++) {
+      int column = std::min(block_x * 4 + x, width - 1);
+      memcpy(texels[y * 4 + x], rgba + (size_t(row) * width + column) * 4, 4);
+    }
+  }
+}
+
+void StoreBlock(const BlockTexels& texels, int width, int height, int block_x,
+                int block_y, byte* rgba) {
+  for (int y = 0; y < 4; y++) {
+    int row = block_y * 4 + y;
+    for (int x = 0; x < 4; x++) {
+      int column = block_x * 4 + x;
+      if (row < height && column < width)
+        memcpy(rgba + (size_t(row) * width + column) * 4, texels[y * 4 + x], 4);
+    }
+  }
+}
+
+// Mean and principal axis of the first channel_count channels
+void FitAxis(const BlockTexels& texels, int channel_count, float mean[4],
+             float axis[4]) {
+  for (int c = 0; c < 4; c++) mean[c] = axis[c] = 0.0f;
+  for (int i = 0; i < 16; i++)
+    for (int c = 0; c < channel_count; c++) mean[c] += texels[i][c];
+  for (int c = 0; c < channel_count; c++) mean[c] /= 16.0f;
+
+  float covariance[4][4] = {};
+  for (int i = 0; i < 16; i++) {
+    float delta[4];
+    for (int c = 0; c < channel_count; c++) delta[c] = texels[i][c] - mean[c];
+    for (int a = 0; a < channel_count; a++)
+      for (int b = 0; b < channel_count; b++)
+        covariance[a][b] += delta[a] * delta[b];
+  }
+
+  // Power iteration from the channel with the largest variance
+  int largest = 0;
+  for (int c = 1; c < channel_count; c++)
+    if (covariance[c][c] > covariance[largest][largest]) largest = c;
+  for (int c = 0; c < channel_count; c++) axis[c] = covariance[largest][c];
+
+  for (int iteration = 0; iteration < 8; iteration++) {
+    float next[4] = {};
+    for (int a = 0; a < channel_count; a++)
+      for (int b = 0; b < channel_count; b++)
+        next[a] += covariance[a][b] * axis[b];
+
+    float length = 0.0f;
+    for (int c = 0; c < channel_count; c++) length += next[c] * next[c];
+    if (length < 1e-12f) break;
+
+    length = 1.0f / std::sqrt(length);
+    for (int c = 0; c < channel_count; c++) axis[c] = next[c] * length;
+  }
+}
+
+// Endpoints at the extent of the texels along the axis
+void GetAxisEndpoints(const BlockTexels& texels, int channel_count,
+                      float start[4], float end[4]) {
+  float mean[4], axis[4];
+  FitAxis(texels, channel_count, mean, axis);
+
+  float low = 0.0f, high = 0.0f;
+  for (int i = 0; i < 16; i++) {
+    float t = 0.0f;
+    for (int c = 0; c < channel_count; c++)
+      t += (texels[i][c] - mean[c]) * axis[c];
+    low = std::min(low, t);
+    high = std::max(high, t);
+  }
+
+  for (int c = 0; c < channel_count; c++) {
+    start[c] = std::clamp(mean[c] + axis[c] * high, 0.0f, 255.0f);
+    end[c] = std::clamp(mean[c] + axis[c] * low, 0.0f, 255.0f);
+  }
+}
+
+// Endpoints minimising the squared error for fixed interpolation weights
+// of the start endpoint. False when the system is singular.
+bool FitLeastSquares(const BlockTexels& texels, int channel_count,
+                     const float weights[16], float start[4], float end[4]) {
+  float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+  float ax[4] = {}, bx[4] = {};
+  for (int i = 0; i < 16; i++) {
+    float a = weights[i], b = 1.0f - a;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for (int c = 0; c < channel_count; c++) {
+      ax[c] += a * texels[i][c];
+      bx[c] += b * texels[i][c];
+    }
+  }
+
+  float determinant = aa * bb - ab * ab;
+  if (std::fabs(determinant) < 1e-6f) return false;
+
+  float inverse = 1.0f / determinant;
+  for (int c = 0; c < channel_count; c++) {
+    start[c] = std::clamp((bb * ax[c] - ab * bx[c]) * inverse, 0.0f, 255.0f);
+    end[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inverse, 0.0f, 255.0f);
+  }
+  return true;
+}
+
+int GetRefinementCount(BlockQuality quality) {
+  switch (quality) {
+    case kBlockQualityFast:
+      return 0;
+    case kBlockQualityNormal:
+      return 1;
+    default:
+      return 3;
+  }
+}
+
+uint16 To565(const float color[4]) {
+  int r = int(color[0] * 31.0f / 255.0f + 0.5f);
+  int g = int(color[1] * 63.0f / 255.0f + 0.5f);
+  int b = int(color[2] * 31.0f / 255.0f + 0.5f);
+  return uint16((r << 11) | (g << 5) | b);
+}
+
+void From565(uint16 color, int rgb[3]) {
+  int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+  rgb[0] = (r << 3) | (r >> 2);
+  rgb[1] = (g << 2) | (g >> 4);
+  rgb[2] = (b << 3) | (b >> 2);
+}
+
+void GetBc1Palette(uint16 color0, uint16 color1, bool four_colors,
+                   int palette[4][4]) {
+  From565(color0, palette[0]);
+  From565(color1, palette[1]);
+  for (int c = 0; c < 3; c++) {
+    if (four_colors) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    } else {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+      palette[3][c] = 0;
+    }
+  }
+  palette[0][3] = palette[1][3] = palette[2][3] = 255;
+  palette[3][3] = four_colors ? 255 : 0;
+}
+
+// Opaque four color block, also the color half of BC3
+void EncodeBc1(const BlockTexels& texels, BlockQuality quality, byte* block) {
+  static const float kStartWeights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+  float start[4], end[4];
+  GetAxisEndpoints(texels, 3, start, end);
+
+  uint best_error = ~0u;
+  uint16 best_colors[2] = {0, 0};
+  uint best_indices = 0;
+  int refinements = GetRefinementCount(quality);
+  for (int pass = 0; pass <= refinements; pass++) {
+    uint16 color0 = To565(start), color1 = To565(end);
+    if (color0 < color1) std::swap(color0, color1);
+
+    int palette[4][4];
+    GetBc1Palette(color0, color1, true, palette);
+
+    // Equal endpoints would select the three color mode
+    int palette_size = color0 == color1 ? 1 : 4;
+    uint error = 0, indices = 0;
+    float weights[16];
+    for (int i = 0; i < 16; i++) {
+      int best = 0, best_distance = 1 << 30;
+      for (int j = 0; j < palette_size; j++) {
+        int distance = 0;
+        for (int c = 0; c < 3; c++) {
+          int delta = int(texels[i][c]) - palette[j][c];
+          distance += delta * delta;
+        }
+        if (distance < best_distance) {
+          best_distance = distance;
+          best = j;
+        }
+      }
+      error += best_distance;
+      indices |= uint(best) << (2 * i);
+      weights[i] = kStartWeights[best];
+    }
+
+    if (error < best_error) {
+      best_error = error;
+      best_colors[0] = color0;
+      best_colors[1] = color1;
+      best_indices = indices;
+    }
+
+    if (best_error == 0 || pass == refinements ||
+        !FitLeastSquares(texels, 3, weights, start, end)) {
+      break;
+    }
+  }
+
+  memcpy(block, best_colors, 4);
+  memcpy(block + 4, &best_indices, 4);
+}
+
+void GetBc4Palette(int value0, int value1, int palette[8]) {
+  palette[0] = value0;
+  palette[1] = value1;
+  if (value0 > value1) {
+    for (int i = 1; i < 7; i++)
+      palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+  } else {
+    for (int i = 1; i < 5; i++)
+      palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+uint GetBc4Indices(const int values[16], int value0, int value1,
+                   ullong& indices) {
+  int palette[8];
+  GetBc4Palette(value0, value1, palette);
+
+  uint error = 0;
+  indices = 0;
+  for (int i = 0; i < 16; i++) {
+    int best = 0, best_distance = 1 << 30;
+    for (int j = 0; j < 8; j++) {
+      int distance = (values[i] - palette[j]) * (values[i] - palette[j]);
+      if (distance < best_distance) {
+        best_distance = distance;
+        best = j;
+      }
+    }
+    error += best_distance;
+    indices |= ullong(best) << (3 * i);
+  }
+  return error;
+}
+
+// Single channel block, also the alpha half of BC3
+void EncodeBc4(const BlockTexels& texels, int channel, BlockQuality quality,
+               byte* block) {
+  int values[16];
+  int low = 255, high = 0;
+  for (int i = 0; i < 16; i++) {
+    values[i] = texels[i][channel];
+    low = std::min(low, values[i]);
+    high = std::max(high, values[i]);
+  }
+
+  int best0 = high, best1 = low;
+  ullong best_indices = 0;
+  uint best_error = 0;
+  if (high > low) {
+    best_error = GetBc4Indices(values, high, low, best_indices);
+
+    // Nearby endpoints often round better than the extremes
+    int radius = quality == kBlockQualityHigh ? 2 : 0;
+    for (int d0 = -radius; d0 <= radius && best_error > 0; d0++) {
+      for (int d1 = -radius; d1 <= radius; d1++) {
+        int value0 = std::clamp(high + d0, 0, 255);
+        int value1 = std::clamp(low + d1, 0, 255);
+        if (value0 <= value1 || (d0 == 0 && d1 == 0)) continue;
+
+        ullong indices;
+        uint error = GetBc4Indices(values, value0, value1, indices);
+        if (error < best_error) {
+          best_error = error;
+          best0 = value0;
+          best1 = value1;
+          best_indices = indices;
+        }
+      }
+    }
+
+    // The six value mode has exact zero and one for the remaining texels
+    if (quality != kBlockQualityFast && best_error > 0) {
+      int inner_low = 255, inner_high = 0;
+      for (int i = 0; i < 16; i++) {
+        if (values[i] == 0 || values[i] == 255) continue;
+        inner_low = std::min(inner_low, values[i]);
+        inner_high = std::max(inner_high, values[i]);
+      }
+
+      if (inner_low <= inner_high) {
+        ullong indices;
+        uint error = GetBc4Indices(values, inner_low, inner_high, indices);
+        if (error < best_error) {
+          best_error = error;
+          best0 = inner_low;
+          best1 = inner_high;
+          best_indices = indices;
+        }
+      }
+    }
+  }
+
+  block[0] = byte(best0);
+  block[1] = byte(best1);
+  for (int i = 0; i < 6; i++) block[2 + i] = byte(best_indices >> (8 * i));
+}
+
+class BitWriter {
+ public:
+  explicit BitWriter(byte* data) : data_(data), position_(0) {
+    memset(data_, 0, 16);
+  }
+
+  void Write(uint value, int count) {
+    for (int i = 0; i < count; i++, position_++) {
+      if ((value >> i) & 1) data_[position_ / 8] |= byte(1 << (position_ % 8));
+    }
+  }
+
+ private:
+  byte* data_;
+  int position_;
+};
+
+class BitReader {
+ public:
+  explicit BitReader(const byte* data) : data_(data), position_(0) {}
+
+  uint Read(int count) {
+    uint value = 0;
+    for (int i = 0; i < count; i++, position_++)
+      value |= uint((data_[position_ / 8] >> (position_ % 8)) & 1) << i;
+    return value;
+  }
+
+ private:
+  const byte* data_;
+  int position_;
+};
+
+// Mode 6: RGBA endpoints of 7 bits plus a shared low bit each
+void EncodeBc7(const BlockTexels& texels, BlockQuality quality, byte* block) {
+  float start[4], end[4];
+  GetAxisEndpoints(texels, 4, start, end);
+
+  ullong best_error = ~0ull;
+  int best_endpoints[2][4] = {}, best_bits[2] = {0, 0};
+  int best_indices[16] = {};
+
+  static const int kBitChoices[4][2] = {{0, 0}, {1, 1}, {0, 1}, {1, 0}};
+  int bit_choice_count = quality == kBlockQualityFast ? 2 : 4;
+  int refinements = GetRefinementCount(quality);
+  for (int pass = 0; pass <= refinements; pass++) {
+    int pass_indices[16];
+    ullong pass_error = ~0ull;
+
+    for (int choice = 0; choice < bit_choice_count; choice++) {
+      int endpoints[2][4];
+      for (int c = 0; c < 4; c++) {
+        const int* bits = kBitChoices[choice];
+        int quantized0 = int((start[c] - bits[0]) / 2 + 0.5f);
+        int quantized1 = int((end[c] - bits[1]) / 2 + 0.5f);
+        quantized0 = std::clamp(quantized0, 0, 127);
+        quantized1 = std::clamp(quantized1, 0, 127);
+        endpoints[0][c] = (quantized0 << 1) | bits[0];
+        endpoints[1][c] = (quantized1 << 1) | bits[1];
+      }
+
+      int palette[16][4];
+      for (int j = 0; j < 16; j++) {
+        for (int c = 0; c < 4; c++) {
+          palette[j][c] = ((64 - kBc7Weights[j]) * endpoints[0][c] +
+                           kBc7Weights[j] * endpoints[1][c] + 32) >> 6;
+        }
+      }
+
+      ullong error = 0;
+      int indices[16];
+      for (int i = 0; i < 16 && error < pass_error; i++) {
+        int best = 0, best_distance = 1 << 30;
+        for (int j = 0; j < 16; j++) {
+          int distance = 0;
+          for (int c = 0; c < 4; c++) {
+            int delta = int(texels[i][c]) - palette[j][c];
+            distance += delta * delta;
+          }
+          if (distance < best_distance) {
+            best_distance = distance;
+            best = j;
+          }
+        }
+        error += best_distance;
+        indices[i] = best;
+      }
+
+      if (error < pass_error) {
+        pass_error = error;
+        memcpy(pass_indices, indices, sizeof(indices));
+      }
+
+      if (error < best_error) {
+        best_error = error;
+        memcpy(best_endpoints, endpoints, sizeof(endpoints));
+        best_bits[0] = kBitChoices[choice][0];
+        best_bits[1] = kBitChoices[choice][1];
+        memcpy(best_indices, indices, sizeof(indices));
+      }
+    }
+
+    if (best_error == 0 || pass == refinements || pass_error == ~0ull) break;
+
+    float weights[16];
+    for (int i = 0; i < 16; i++)
+      weights[i] = 1.0f - kBc7Weights[pass_indices[i]] / 64.0f;
+    if (!FitLeastSquares(texels, 4, weights, start, end)) break;
+  }
+
+  // The top bit of the first index is implied zero
+  if (best_indices[0] >= 8) {
+    for (int c = 0; c < 4; c++)
+      std::swap(best_endpoints[0][c], best_endpoints[1][c]);
+    std::swap(best_bits[0], best_bits[1]);
+    for (int i = 0; i < 16; i++) best_indices[i] = 15 - best_indices[i];
+  }
+
+  BitWriter writer(block);
+  writer.Write(1 << 6, 7);
+  for (int c = 0; c < 4; c++) {
+    writer.Write(best_endpoints[0][c] >> 1, 7);
+    writer.Write(best_endpoints[1][c] >> 1, 7);
+  }
+  writer.Write(best_bits[0], 1);
+  writer.Write(best_bits[1], 1);
+  writer.Write(best_indices[0], 3);
+  for (int i = 1; i < 16; i++) writer.Write(best_indices[i], 4);
+}
+
+void DecodeBc1(const byte* block, bool four_colors, BlockTexels& texels) {
+  uint16 colors[2];
+  uint indices;
+  memcpy(colors, block, 4);
+  memcpy(&indices, block + 4, 4);
+
+  int palette[4][4];
+  GetBc1Palette(colors[0], colors[1], four_colors || colors[0] > colors[1],
+                palette);
+  for (int i = 0; i < 16; i++) {
+    const int* color = palette[(indices >> (2 * i)) & 3];
+    for (int c = 0; c < 4; c++) texels[i][c] = byte(color[c]);
+  }
+}
+
+void DecodeBc4(const byte* block, int channel, BlockTexels& texels) {
+  int palette[8];
+  GetBc4Palette(block[0], block[1], palette);
+
+  ullong indices = 0;
+  for (int i = 0; i < 6; i++) indices |= ullong(block[2 + i]) << (8 * i);
+  for (int i = 0; i < 16; i++)
+    texels[i][channel] = byte(palette[(indices >> (3 * i)) & 7]);
+}
+
+void DecodeBc7(const byte* block, BlockTexels& texels) {
+  BitReader reader(block);
+  if (reader.Read(7) != 1 << 6) {
+    memset(texels, 0, sizeof(texels));
+    return;
+  }
+
+  int endpoints[2][4];
+  for (int c = 0; c < 4; c++) {
+    endpoints[0][c] = reader.Read(7) << 1;
+    endpoints[1][c] = reader.Read(7) << 1;
+  }
+  uint bit0 = reader.Read(1), bit1 = reader.Read(1);
+  for (int c = 0; c < 4; c++) {
+    endpoints[0][c] |= bit0;
+    endpoints[1][c] |= bit1;
+  }
+
+  for (int i = 0; i < 16; i++) {
+    int index = reader.Read(i == 0 ? 3 : 4);
+    for (int c = 0; c < 4; c++) {
+      texels[i][c] = byte(((64 - kBc7Weights[index]) * endpoints[0][c] +
+                           kBc7Weights[index] * endpoints[1][c] + 32) >> 6);
+    }
+  }
+}
+
+size_t GetBlockSize(ImageFormat format) {
+  return format == kImageFormatBc1 || format == kImageFormatBc4 ? 8 : 16;
+}
+}  // namespace
+
+void BlockEncoder::Encode(ImageFormat format, BlockQuality quality,
+                          const byte* rgba, int width, int height,
+                          std::vector<byte>& blocks) {
+  int block_width = (width + 3) / 4, block_height = (height + 3) / 4;
+  size_t block_size = GetBlockSize(format);
+  blocks.assign(size_t(block_width) * block_height * block_size, 0);
+
+  ThreadPool::Get().ParallelFor(block_height, [&](size_t block_y) {
+    byte* output = &blocks[block_y * block_width * block_size];
+    for (int block_x = 0; block_x < block_width; block_x++) {
+      BlockTexels texels;
+      FetchBlock(rgba, width, height, block_x, int(block_y), texels);
+
+      byte* block = output + block_x * block_size;
+      switch (format) {
+        case kImageFormatBc1:
+          EncodeBc1(texels, quality, block);
+          break;
+        case kImageFormatBc3:
+          EncodeBc4(texels, 3, quality, block);
+          EncodeBc1(texels, quality, block + 8);
+          break;
+        case kImageFormatBc4:
+          EncodeBc4(texels, 0, quality, block);
+          break;
+        case kImageFormatBc7:
+          EncodeBc7(texels, quality, block);
+          break;
+        default:
+          break;
+      }
+    }
+  });
+}
+
+void BlockEncoder::Decode(ImageFormat format, const byte* blocks, int width,
+                          int height, std::vector<byte>& rgba) {
+  int block_width = (width + 3) / 4, block_height = (height + 3) / 4;
+  size_t block_size = GetBlockSize(format);
+  rgba.assign(size_t(width) * height * 4, 255);
+
+  for (int block_y = 0; block_y < block_height; block_y++) {
+    for (int block_x = 0; block_x < block_width; block_x++) {
+      const byte* block =
+          blocks + (size_t(block_y) * block_width + block_x) * block_size;
+
+      BlockTexels texels;
+      memset(texels, 255, sizeof(texels));
+      switch (format) {
+        case kImageFormatBc1:
+          DecodeBc1(block, false, texels);
+          break;
+        case kImageFormatBc3:
+          DecodeBc1(block + 8, true, texels);
+          DecodeBc4(block, 3, texels);
+          break;
+        case kImageFormatBc4:
+          DecodeBc4(block, 0, texels);
+          break;
+        case kImageFormatBc7:
+          DecodeBc7(block, texels);
+          break;
+        default:
+          break;
+      }
+      StoreBlock(texels, width, height, block_x, block_y, rgba.data());
+    }
+  }
+}
+
+double BlockEncoder::GetPsnr(ImageFormat format, const byte* reference,
+                             const byte* decoded, int width, int height) {
+  int first = 0, last = 4;
+  if (format == kImageFormatBc1) last = 3;
+  if (format == kImageFormatBc4) last = 1;
+
+  double error = 0.0;
+  size_t count = size_t(width) * height;
+  for (size_t i = 0; i < count; i++) {
+    for (int c = first; c < last; c++) {
+      double delta = double(reference[i * 4 + c]) - decoded[i * 4 + c];
+      error += delta * delta;
+    }
+  }
+
+  double mse = error / (double(count) * (last - first));
+  if (mse <= 0.0) return 99.0;
+  return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+}  // namespace voodoo
@@ -0,0 +1,50 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_BLOCK_ENCODER_H_
+#define VOODOO_BLOCK_ENCODER_H_
+
+#include <voodoo/image.h>
+
+namespace voodoo {
+enum BlockQuality {
+  kBlockQualityFast = 0,    // Endpoints from the principal axis only
+  kBlockQualityNormal = 1,  // Least squares endpoint refinement
+  kBlockQualityHigh = 2,    // More refinement and endpoint search
+};
+
+// Block compression of RGBA8 texels into BC1, BC3, BC4 and BC7. Rows of
+// blocks are encoded in parallel on the shared thread pool.
+//
+// BC1 is always encoded in its opaque four color mode, BC4 takes the red
+// channel, and BC7 uses mode 6, a single RGBA subset with 4 bit indices.
+class BlockEncoder final {
+ public:
+  // Levels smaller than a block are padded by repeating edge texels
+  static void Encode(ImageFormat format, BlockQuality quality,
+                     const byte* rgba, int width, int height,
+                     std::vector<byte>& blocks);
+
+  // Decodes what Encode() produces, BC7 only in mode 6
+  static void Decode(ImageFormat format, const byte* blocks, int width,
+                     int height, std::vector<byte>& rgba);
+
+  // Peak signal to noise ratio in dB over the channels the format stores
+  static double GetPsnr(ImageFormat format, const byte* reference,
+                        const byte* decoded, int width, int height);
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_BLOCK_ENCODER_H_
@@ -0,0 +1,151 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "log_decoder.h"
+
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <limits>
+
+namespace voodoo {
+namespace {
+const char* kLevelNames[] = {"info", "warning", "error"};
+const char* kCategoryNames[] = {"engine", "assets", "render", "network"};
+
+std::string EscapeJson(const std::string& text) {
+  std::string escaped;
+  for (char c : text) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char code[8];
+          std::snprintf(code, sizeof(code), "\\u%04x", c);
+          escaped += code;
+        } else {
+          escaped += c;
+        }
+        break;
+    }
+  }
+  return escaped;
+}
+
+// UTC date and time with microseconds
+std::string FormatTime(ullong nanoseconds) {
+  std::time_t seconds = static_cast<std::time_t>(nanoseconds / 1000000000);
+  std::tm time = *std::gmtime(&seconds);
+  char text[64];
+  std::size_t length = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S",
+                                     &time);
+  std::snprintf(text + length, sizeof(text) - length, ".%06llu",
+                (nanoseconds % 1000000000) / 1000);
+  return text;
+}
+}  // namespace
+
+LogFilter::LogFilter()
+    : level(kLogEntryLevelInfo),
+      category(kLogCategoryCount),
+      from(0.0),
+      to(std::numeric_limits<double>::infinity()) {}
+
+bool LogDecoder::Decode(const std::string& filename, const LogFilter& filter,
+                        bool json, std::ostream& out) {
+  read_count_ = written_count_ = 0;
+  try {
+    BinaryLogReader reader(filename);
+
+    if (json) out << "[";
+    BinaryLogEntry entry;
+    while (reader.Next(entry)) {
+      read_count_++;
+
+      double seconds = entry.time / 1e9;
+      if (entry.level < filter.level || seconds < filter.from ||
+          seconds > filter.to ||
+          (filter.category != kLogCategoryCount &&
+           entry.category != filter.category))
+        continue;
+
+      std::string message = entry.format
+                                ? LogArguments::Format(entry.format, entry.text)
+                                : entry.text;
+      std::string time = FormatTime(reader.GetStartTime() + entry.time);
+      const char* level = kLevelNames[entry.level];
+      const char* category = kCategoryNames[entry.category];
+
+      if (json) {
+        out << (written_count_ ? ",\n " : "\n ") << "{\"time\": \"" << time
+            << "\", \"seconds\": " << seconds << ", \"thread\": "
+            << entry.thread << ", \"level\": \"" << level
+            << "\", \"category\": \"" << category << "\", \"message\": \""
+            << EscapeJson(message) << "\"}";
+      } else {
+        out << time << " [" << entry.thread << "] " << level << " "
+            << category << ": " << message << "\n";
+      }
+      written_count_++;
+    }
+    if (json) out << "\n]\n";
+
+    if (reader.IsTruncated())
+      std::cerr << "Warning: \"" << filename
+                << "\" ends within a record, the rest is skipped" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool LogDecoder::ParseLevel(const std::string& name, LogEntryLevel& level) {
+  for (int i = 0; i <= kLogEntryLevelError; i++) {
+    if (name == kLevelNames[i]) {
+      level = static_cast<LogEntryLevel>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool LogDecoder::ParseCategory(const std::string& name,
+                               LogCategory& category) {
+  for (int i = 0; i < kLogCategoryCount; i++) {
+    if (name == kCategoryNames[i]) {
+      category = static_cast<LogCategory>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+std::size_t LogDecoder::GetReadCount() const { return read_count_; }
+
+std::size_t LogDecoder::GetWrittenCount() const { return written_count_; }
+}  // namespace voodoo
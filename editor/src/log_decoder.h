@@ -0,0 +1,54 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_LOG_DECODER_H_
+#define VOODOO_LOG_DECODER_H_
+
+#include <voodoo/binary_log.h>
+
+#include <ostream>
+
+namespace voodoo {
+struct LogFilter {
+  LogFilter();
+
+  LogEntryLevel level;
+
+  // Every category when kLogCategoryCount
+  LogCategory category;
+
+  // Seconds since the start of the log
+  double from, to;
+};
+
+// Turns binary logs back into text lines or an array of JSON objects
+class LogDecoder final {
+ public:
+  bool Decode(const std::string& filename, const LogFilter& filter,
+              bool json, std::ostream& out);
+
+  static bool ParseLevel(const std::string& name, LogEntryLevel& level);
+  static bool ParseCategory(const std::string& name, LogCategory& category);
+
+  // Entries read and written by the last Decode()
+  std::size_t GetReadCount() const;
+  std::size_t GetWrittenCount() const;
+
+ private:
+  std::size_t read_count_, written_count_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_LOG_DECODER_H_
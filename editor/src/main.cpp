@@ -13,13 +13,166 @@
 // You should have received a copy of the GNU General Public License
 // along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
 
+#include "asset_cooker.h"
+#include "asset_packer.h"
+#include "log_decoder.h"
 #include "model_converter.h"
+#include "self_test.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Usage: editor [--force] [--threads N] [--quality fast|normal|high]
+//               <directory>...
+//        editor --pack <archive> <directory>
+//        editor --log <binary log> [--level info|warning|error]
+//               [--category engine|assets|render|network] [--from seconds]
+//               [--to seconds] [--json]
+//        editor --test
+// Without arguments the editor converts single models interactively.
+// Changing the texture quality needs --force to cook textures again.
+int Cook(int argc, char* argv[]) {
+  std::vector<std::string> directories;
+  bool force = false;
+  voodoo::uint thread_count = 0;
+  voodoo::BlockQuality quality = voodoo::kBlockQualityNormal;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--force") == 0) {
+      force = true;
+    } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      thread_count = static_cast<voodoo::uint>(std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+      const char* name = argv[++i];
+      if (std::strcmp(name, "fast") == 0)
+        quality = voodoo::kBlockQualityFast;
+      else if (std::strcmp(name, "high") == 0)
+        quality = voodoo::kBlockQualityHigh;
+    } else {
+      directories.push_back(argv[i]);
+    }
+  }
+
+  voodoo::AssetCooker cooker(thread_count, quality);
+  bool result = cooker.Cook(directories, force);
+
+  const voodoo::CookStats& stats = cooker.GetStats();
+  std::cout << "Cooked: " << stats.cooked << ", up to date: " << stats.skipped
+            << ", failed: " << stats.failed << " (" << stats.time << " ms)"
+            << std::endl;
+
+  if (stats.textures > 0) {
+    double ratio = static_cast<double>(stats.texture_cooked_bytes) /
+                   static_cast<double>(stats.texture_source_bytes);
+    double rate = stats.texture_encode_time > 0.0
+                      ? stats.texture_pixels / (stats.texture_encode_time * 1e3)
+                      : 0.0;
+    std::cout << "Textures: " << stats.textures << ", RGBA8 "
+              << stats.texture_source_bytes << " -> "
+              << stats.texture_cooked_bytes << " bytes (" << ratio * 100.0
+              << "%), encoded at " << rate << " MPix/s, mean PSNR "
+              << stats.texture_psnr << " dB" << std::endl;
+  }
+
+  if (stats.atlases > 0) {
+    std::cout << "Atlases: " << stats.atlases << ", " << stats.atlas_textures
+              << " textures on " << stats.atlas_pages << " pages, "
+              << stats.atlas_draws << " draws take "
+              << stats.atlas_binds_before << " -> " << stats.atlas_binds_after
+              << " texture binds" << std::endl;
+  }
+
+  return result ? 0 : 1;
+}
+
+int Pack(const char* archive, const char* directory) {
+  voodoo::AssetPacker packer;
+  bool result = packer.Pack(directory, archive);
+  if (!result) {
+    std::cerr << "Failed to pack " << directory << std::endl;
+    return 1;
+  }
+
+  const voodoo::ArchiveStats& stats = packer.GetStats();
+  double ratio = stats.source_size
+                     ? static_cast<double>(stats.archive_size) /
+                           static_cast<double>(stats.source_size)
+                     : 1.0;
+  std::cout << "Packed " << stats.entry_count << " files, "
+            << stats.source_size << " -> " << stats.archive_size
+            << " bytes (" << ratio * 100.0 << "%) in " << packer.GetPackTime()
+            << " ms" << std::endl;
+  std::cout << "Read all files loose: " << packer.GetLooseReadTime()
+            << " ms, from the archive: " << packer.GetArchiveReadTime()
+            << " ms" << std::endl;
+
+  const voodoo::IoStats& io = packer.GetIoStats();
+  double throughput =
+      io.busy_time > 0.0 ? io.bytes / (io.busy_time * 1000.0) : 0.0;
+  std::cout << "I/O queue: " << io.requests << " reads, " << io.bytes
+            << " bytes in " << io.busy_time << " ms (" << throughput
+            << " MB/s), latency p50 " << io.latency_p50 << " ms, p90 "
+            << io.latency_p90 << " ms, p99 " << io.latency_p99
+            << " ms, max " << io.latency_max << " ms" << std::endl;
+
+  return 0;
+}
+
+int DecodeLog(int argc, char* argv[]) {
+  voodoo::LogFilter filter;
+  bool json = false;
+  for (int i = 3; i < argc; i++) {
+    bool valid = true;
+    if (std::strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+      valid = voodoo::LogDecoder::ParseLevel(argv[++i], filter.level);
+    } else if (std::strcmp(argv[i], "--category") == 0 && i + 1 < argc) {
+      valid = voodoo::LogDecoder::ParseCategory(argv[++i], filter.category);
+    } else if (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+      filter.from = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+      filter.to = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--json") == 0) {
+      json = true;
+    } else {
+      valid = false;
+    }
+
+    if (!valid) {
+      std::cerr << "Invalid log option: " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  voodoo::LogDecoder decoder;
+  if (!decoder.Decode(argv[2], filter, json, std::cout)) return 1;
+
+  std::cerr << "Decoded " << decoder.GetWrittenCount() << " of "
+            << decoder.GetReadCount() << " entries" << std::endl;
+  return 0;
+}
+
+int Test() {
+  voodoo::SelfTest test;
+  bool result = test.Run();
+  std::cout << "Checks: " << test.GetCheckCount()
+            << ", failed: " << test.GetFailureCount() << std::endl;
+
+  return result ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc == 4 && std::strcmp(argv[1], "--pack") == 0)
+    return Pack(argv[2], argv[3]);
+  if (argc >= 3 && std::strcmp(argv[1], "--log") == 0)
+    return DecodeLog(argc, argv);
+  if (argc == 2 && std::strcmp(argv[1], "--test") == 0) return Test();
+  if (argc > 1) return Cook(argc, argv);
 
-int main() {
   int exit_code = 0;
 
   voodoo::ModelConverter* model_converter = voodoo::ModelConverter::Get();
   if (model_converter->Init()) exit_code = model_converter->Run();
 
   return exit_code;
-}
\ No newline at end of file
+}
@@ -15,8 +15,14 @@
 
 #include "model_converter.h"
 
+#include <voodoo/mesh_manager.h>
+#include <voodoo/vmesh.h>
+
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <tuple>
 
 namespace voodoo {
 ModelConverter* ModelConverter::singleton_;
@@ -51,6 +57,17 @@ bool ModelConverter::Run() {
   return true;
 }
 
+bool ModelConverter::Cook(const std::string& filename, uint parse_threads) {
+  return Read(filename, parse_threads) && Build() && Optimize() &&
+         Write(filename) && WriteBinary(filename);
+}
+
+std::vector<std::string> ModelConverter::GetOutputs(
+    const std::string& filename) {
+  std::string name = filename.substr(0, filename.find_last_of('.'));
+  return {name + ".mesh", name + ".vmesh"};
+}
+
 bool ModelConverter::CheckFile(char* filename) {
   bool result;
   std::ifstream input_fs;
@@ -64,17 +81,25 @@ bool ModelConverter::CheckFile(char* filename) {
 }
 
 bool ModelConverter::ProcessFile(char* filename) {
-  std::cout << std::endl << "Getting model metrics... ";
+  std::cout << std::endl << "Reading file...";
 
-  if (!GetModelMetrics(filename)) {
+  if (!Read(filename)) {
     std::cout << "FAILED" << std::endl;
     return false;
   }
 
   std::cout << "OK" << std::endl;
-  std::cout << std::endl << "Reading file...";
+  std::cout << std::endl << "Building indexed mesh...";
 
-  if (!Read(filename)) {
+  if (!Build()) {
+    std::cout << "FAILED" << std::endl;
+    return false;
+  }
+
+  std::cout << "OK" << std::endl;
+  std::cout << std::endl << "Optimizing...";
+
+  if (!Optimize()) {
     std::cout << "FAILED" << std::endl;
     return false;
   }
@@ -82,7 +107,15 @@ bool ModelConverter::ProcessFile(char* filename) {
   std::cout << "OK" << std::endl;
   std::cout << std::endl << "Converting...";
 
-  if (!Write(filename)) {
+  if (!Write(filename) || !WriteBinary(filename)) {
+    std::cout << "FAILED" << std::endl;
+    return false;
+  }
+
+  std::cout << "OK" << std::endl;
+  std::cout << std::endl << "Benchmarking...";
+
+  if (!Benchmark(filename)) {
     std::cout << "FAILED" << std::endl;
     return false;
   }
@@ -90,204 +123,165 @@ bool ModelConverter::ProcessFile(char* filename) {
   std::cout << "OK" << std::endl;
 
   std::cout << std::endl << "Summary:" << std::endl;
-  std::cout << "	Vertices: " << v_count_ << std::endl;
-  std::cout << "	UVs:      " << t_count_ << std::endl;
-  std::cout << "	Normals:  " << n_count_ << std::endl;
-  std::cout << "	Faces:    " << f_count_ << std::endl << std::endl;
+  std::cout << "	Vertices: " << model_.positions.size() << std::endl;
+  std::cout << "	UVs:      " << model_.texcoords.size() << std::endl;
+  std::cout << "	Normals:  " << model_.normals.size() << std::endl;
+  std::cout << "	Faces:    " << model_.corners.size() / 3 << std::endl;
+  std::cout << "	Unique:   " << mesh_.vertex_count << std::endl;
+  std::cout << "	ACMR:     " << stats_before_.acmr << " -> "
+            << stats_after_.acmr << std::endl;
+  std::cout << "	ATVR:     " << stats_before_.atvr << " -> "
+            << stats_after_.atvr << std::endl;
+
+  std::cout << std::endl << "Packed vertices:" << std::endl;
+  std::cout << "	Memory:   " << packing_stats_.source_bytes << " -> "
+            << packing_stats_.packed_bytes << " bytes" << std::endl;
+  std::cout << "	Position: " << packing_stats_.max_position_error
+            << " max error" << std::endl;
+  std::cout << "	UV:       " << packing_stats_.max_texture_error
+            << " max error" << std::endl;
+  std::cout << "	Normal:   " << packing_stats_.max_normal_error
+            << " deg max error (" << packing_stats_.max_normal_error_8bit
+            << " deg with 8 bit)" << std::endl;
+
+  std::cout << std::endl << "Parse time:" << std::endl;
+  std::cout << "	.obj:     " << parse_time_ << " ms ("
+            << file_size_ / (parse_time_ * 1000.0) << " MB/s)" << std::endl;
+
+  std::cout << std::endl << "Load time:" << std::endl;
+  std::cout << "	.mesh:    " << text_load_time_ << " ms" << std::endl;
+  std::cout << "	.vmesh:   " << binary_load_time_ << " ms" << std::endl
+            << std::endl;
 
   return true;
 }
 
-bool ModelConverter::GetModelMetrics(char* filename) {
-  std::ifstream input_fs;
-  char input;
+bool ModelConverter::Read(const std::string& filename, uint parse_threads) {
+  using namespace std::chrono;
 
-  // Reset model metrics
-  v_count_ = 0;
-  t_count_ = 0;
-  n_count_ = 0;
-  f_count_ = 0;
+  auto start = high_resolution_clock::now();
+  if (!ObjParser::Parse(filename, model_, parse_threads)) return false;
+  duration<double, std::milli> elapsed = high_resolution_clock::now() - start;
+  parse_time_ = elapsed.count();
 
-  input_fs.open(filename);
+  std::ifstream input_fs(filename, std::ios::binary | std::ios::ate);
+  file_size_ = static_cast<size_t>(input_fs.tellg());
 
-  if (input_fs.fail() == true) return false;
+  // Convert to the left-handed coordinate system
+  for (auto& position : model_.positions) position.z = -position.z;
+  for (auto& normal : model_.normals) normal.z = -normal.z;
+  for (auto& texcoord : model_.texcoords) texcoord.y = 1.0f - texcoord.y;
 
-  input_fs.get(input);
-  while (!input_fs.eof()) {
-    // Vertices
-    if (input == 'v') {
-      input_fs.get(input);
-      if (input == ' ') {
-        v_count_++;
-      }
-      if (input == 't') {
-        t_count_++;
-      }
-      if (input == 'n') {
-        n_count_++;
-      }
-    }
+  return true;
+}
 
-    // Faces
-    if (input == 'f') {
-      input_fs.get(input);
-      if (input == ' ') {
-        f_count_++;
+bool ModelConverter::Build() {
+  // Each distinct position/uv/normal triplet becomes one vertex
+  std::map<std::tuple<int, int, int>, uint> vertex_map;
+  std::vector<vertex_ptn> vertices;
+  std::vector<uint> indices;
+  indices.reserve(model_.corners.size());
+
+  for (size_t i = 0; i + 2 < model_.corners.size(); i += 3) {
+    // Corners are emitted in reverse, which flips the winding order
+    for (int corner = 2; corner >= 0; corner--) {
+      const ObjCorner& c = model_.corners[i + corner];
+      auto key = std::make_tuple(c.v, c.t, c.n);
+      auto it = vertex_map.find(key);
+      if (it != vertex_map.end()) {
+        indices.push_back(it->second);
+        continue;
       }
-    }
 
-    while (input != '\n') {
-      input_fs.get(input);
-    }
+      vertex_ptn vertex;
+      vertex.position = model_.positions[c.v];
+      vertex.texture = c.t >= 0 ? model_.texcoords[c.t] : kVec2fZeros;
+      vertex.normal = c.n >= 0 ? model_.normals[c.n] : kVec3fZeros;
 
-    input_fs.get(input);
+      uint index = static_cast<uint>(vertices.size());
+      vertex_map.insert(std::make_pair(key, index));
+      vertices.push_back(vertex);
+      indices.push_back(index);
+    }
   }
 
-  input_fs.close();
+  mesh_ = Mesh(vertices, indices);
+  mesh_.subsets.push_back(
+      MeshSubset(0, 0, mesh_.vertex_count, 0, mesh_.index_count / 3));
 
   return true;
 }
 
-bool ModelConverter::Read(char* filename) {
-  v_coords_.resize(v_count_);
-  t_coords_.resize(t_count_);
-  n_coords_.resize(n_count_);
-  faces_.resize(f_count_);
-
-  int v_index = 0;
-  int t_index = 0;
-  int f_index = 0;
-  int n_index = 0;
-
-  std::ifstream input_fs;
-
-  char input, input2;
-
-  input_fs.open(filename);
-
-  if (input_fs.fail() == true) {
-    return false;
-  }
-
-  input_fs.get(input);
-  while (!input_fs.eof()) {
-    if (input == 'v') {
-      input_fs.get(input);
-      if (input == ' ') {
-        input_fs >> v_coords_[v_index].x >> v_coords_[v_index].y >>
-            v_coords_[v_index].z;
-        v_coords_[v_index].z = v_coords_[v_index].z * -1.0f;
-        v_index++;
-      } else if (input == 't') {
-        input_fs >> t_coords_[t_index].x >> t_coords_[t_index].y;
-        t_coords_[t_index].y = 1.0f - t_coords_[t_index].y;
-        t_index++;
-      } else if (input == 'n') {
-        input_fs >> n_coords_[n_index].x >> n_coords_[n_index].y >>
-            n_coords_[n_index].z;
-        n_coords_[n_index].z = n_coords_[n_index].z * -1.0f;
-        n_index++;
-      }
-    } else if (input == 'f') {
-      input_fs.get(input);
-      if (input == ' ') {
-        input_fs >> faces_[f_index].v.z >> input2;
-        if ((char)input_fs.peek() == '/') {
-          faces_[f_index].t.z = 0;
-          input_fs >> input2;
-        } else {
-          input_fs >> faces_[f_index].t.z;
-          input_fs >> input2;
-        }
-
-        input_fs >> faces_[f_index].n.z;
-        input_fs >> faces_[f_index].v.y >> input2;
-
-        if ((char)input_fs.peek() == '/') {
-          faces_[f_index].t.y = 0;
-          input_fs >> input2;
-        } else {
-          input_fs >> faces_[f_index].t.y;
-          input_fs >> input2;
-        }
-
-        input_fs >> faces_[f_index].n.y;
-        input_fs >> faces_[f_index].v.x >> input2;
-
-        if ((char)input_fs.peek() == '/') {
-          faces_[f_index].t.x = 0;
-          input_fs >> input2;
-        } else {
-          input_fs >> faces_[f_index].t.x;
-          input_fs >> input2;
-        }
-
-        input_fs >> faces_[f_index].n.x;
-        f_index++;
-      }
-    }
-
-    while (input != '\n') {
-      input_fs.get(input);
-    }
-
-    input_fs.get(input);
-  }
-
-  input_fs.close();
+bool ModelConverter::Optimize() {
+  stats_before_ = MeshOptimizer::AnalyzeVertexCache(mesh_);
+  MeshOptimizer::Optimize(mesh_);
+  stats_after_ = MeshOptimizer::AnalyzeVertexCache(mesh_);
+  packing_stats_ = VertexPacker::Analyze(mesh_);
 
   return true;
 }
 
-bool ModelConverter::Write(char* filename) {
+bool ModelConverter::Write(const std::string& filename) {
   std::ofstream output_fs;
-  output_fs.open(
-      std::string(filename).substr(0, std::string(filename).find_last_of('.')) +
-      ".mesh");
+  output_fs.open(GetOutputs(filename)[0]);
+  if (output_fs.fail()) return false;
 
-  output_fs << "Vertex Count: " << (f_count_ * 3) << std::endl;
+  output_fs << "Vertex Count: " << mesh_.vertex_count << std::endl;
+  output_fs << "Index Count: " << mesh_.index_count << std::endl;
   output_fs << std::endl;
   output_fs << "Data:" << std::endl;
   output_fs << std::endl;
 
-  int v_index = 0;
-  int t_index = 0;
-  int n_index = 0;
-
-  for (int i = 0; i < f_count_; i++) {
-    v_index = faces_[i].v.x - 1;
-    t_index = faces_[i].t.x - 1;
-    n_index = faces_[i].n.x - 1;
-
-    output_fs << v_coords_[v_index].x << ' ' << v_coords_[v_index].y << ' '
-              << v_coords_[v_index].z << ' ' << t_coords_[t_index].x << ' '
-              << t_coords_[t_index].y << ' ' << n_coords_[n_index].x << ' '
-              << n_coords_[n_index].y << ' ' << n_coords_[n_index].z
-              << std::endl;
-
-    v_index = faces_[i].v.y - 1;
-    t_index = faces_[i].t.y - 1;
-    n_index = faces_[i].n.y - 1;
-
-    output_fs << v_coords_[v_index].x << ' ' << v_coords_[v_index].y << ' '
-              << v_coords_[v_index].z << ' ' << t_coords_[t_index].x << ' '
-              << t_coords_[t_index].y << ' ' << n_coords_[n_index].x << ' '
-              << n_coords_[n_index].y << ' ' << n_coords_[n_index].z
+  for (const auto& v : mesh_.vertices) {
+    output_fs << v.position.x << ' ' << v.position.y << ' '
+              << v.position.z << ' ' << v.texture.x << ' '
+              << v.texture.y << ' ' << v.normal.x << ' '
+              << v.normal.y << ' ' << v.normal.z
               << std::endl;
+  }
 
-    v_index = faces_[i].v.z - 1;
-    t_index = faces_[i].t.z - 1;
-    n_index = faces_[i].n.z - 1;
+  output_fs << std::endl;
+  output_fs << "Indices:" << std::endl;
+  output_fs << std::endl;
 
-    output_fs << v_coords_[v_index].x << ' ' << v_coords_[v_index].y << ' '
-              << v_coords_[v_index].z << ' ' << t_coords_[t_index].x << ' '
-              << t_coords_[t_index].y << ' ' << n_coords_[n_index].x << ' '
-              << n_coords_[n_index].y << ' ' << n_coords_[n_index].z
-              << std::endl;
+  for (uint i = 0; i < mesh_.index_count; i += 3) {
+    output_fs << mesh_.indices[i] << ' ' << mesh_.indices[i + 1] << ' '
+              << mesh_.indices[i + 2] << std::endl;
   }
 
   output_fs.close();
 
   return true;
 }
-}  // namespace voodoo
\ No newline at end of file
+
+bool ModelConverter::WriteBinary(const std::string& filename) {
+  return VMesh::Save(mesh_, GetOutputs(filename)[1]);
+}
+
+bool ModelConverter::Benchmark(const std::string& filename) {
+  using namespace std::chrono;
+  const int kIterations = 10;
+
+  auto outputs = GetOutputs(filename);
+
+  // Every manager has its own cache, so each iteration loads from disk
+  auto measure = [kIterations](const std::string& path) {
+    auto start = high_resolution_clock::now();
+    for (int i = 0; i < kIterations; i++) {
+      MeshManager manager;
+      if (!manager.Retrieve(path)) return -1.0;
+    }
+    duration<double, std::milli> elapsed = high_resolution_clock::now() - start;
+    return elapsed.count() / kIterations;
+  };
+
+  try {
+    text_load_time_ = measure(outputs[0]);
+    binary_load_time_ = measure(outputs[1]);
+  } catch (const std::exception&) {
+    return false;
+  }
+
+  return text_load_time_ >= 0 && binary_load_time_ >= 0;
+}
+}  // namespace voodoo
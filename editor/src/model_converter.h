@@ -16,41 +16,51 @@
 #ifndef VOODOO_MESH_CONVERTER_H_
 #define VOODOO_MESH_CONVERTER_H_
 
-#include <voodoo/math.h>
+#include "obj_parser.h"
+
+#include <voodoo/mesh_optimizer.h>
+#include <voodoo/vertex_packer.h>
 
 namespace voodoo {
-struct Face {
-  vec3<int> v;
-  vec3<int> t;
-  vec3<int> n;
-};
 
 class ModelConverter final {
  public:
+  ModelConverter() = default;
+
   static ModelConverter* Get();
 
   bool Init();
   bool Run();
 
- private:
-  ModelConverter() = default;
+  // Converts without console output. Used by the batch cooker, which
+  // runs one converter per worker thread.
+  bool Cook(const std::string& filename, uint parse_threads);
 
+  // Files written for a source model
+  static std::vector<std::string> GetOutputs(const std::string& filename);
+
+ private:
   bool CheckFile(char* filename);
   bool ProcessFile(char* filename);
 
-  bool GetModelMetrics(char* filename);
-  bool Read(char* filename);
-  bool Write(char* filename);
+  bool Read(const std::string& filename, uint parse_threads = 0);
+  bool Build();
+  bool Optimize();
+  bool Write(const std::string& filename);
+  bool WriteBinary(const std::string& filename);
+  bool Benchmark(const std::string& filename);
 
  private:
   static ModelConverter* singleton_;
 
-  int v_count_, t_count_, n_count_, f_count_;
+  ObjModel model_;
+  size_t file_size_;
+  double parse_time_;
 
-  std::vector<vec3<float>> v_coords_;
-  std::vector<vec3<float>> t_coords_;
-  std::vector<vec3<float>> n_coords_;
-  std::vector<Face> faces_;
+  Mesh mesh_;
+  VertexCacheStats stats_before_, stats_after_;
+  VertexPackingStats packing_stats_;
+  double text_load_time_, binary_load_time_;
 };
 }  // namespace voodoo
 
@@ -0,0 +1,269 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "obj_parser.h"
+
+#include <voodoo/mapped_file.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <thread>
+
+namespace voodoo {
+namespace {
+// Chunks are a few megabytes so that every thread gets several of them
+// and finishes at roughly the same time
+const size_t kChunkSize = 4 << 20;
+
+inline bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+inline const char* SkipBlank(const char* p, const char* end) {
+  while (p < end && IsBlank(*p)) p++;
+  return p;
+}
+
+inline const char* ParseFloat(const char* p, const char* end, float& value) {
+  p = SkipBlank(p, end);
+  if (p < end && *p == '+') p++;
+  auto result = std::from_chars(p, end, value);
+  return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+inline const char* ParseInt(const char* p, const char* end, int& value) {
+  if (p < end && *p == '+') p++;
+  auto result = std::from_chars(p, end, value);
+  return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+// Components in the order of a face's "v/t/n" triplets
+inline int& GetComponent(ObjCorner& corner, uint component) {
+  switch (component) {
+    case 0:
+      return corner.v;
+    case 1:
+      return corner.t;
+    default:
+      return corner.n;
+  }
+}
+
+template <typename T>
+inline void CopyTo(std::vector<T>& destination, const std::vector<T>& source,
+                   size_t offset) {
+  std::copy(source.begin(), source.end(), destination.begin() + offset);
+}
+}  // namespace
+
+bool ObjParser::Parse(const std::string& filename, ObjModel& model,
+                      uint thread_count) {
+  model = ObjModel();
+
+  sptr<MappedFile> file;
+  try {
+    file = std::make_shared<MappedFile>(filename);
+  } catch (const std::exception&) {
+    return false;
+  }
+
+  const char* data = reinterpret_cast<const char*>(file->GetData());
+  const char* data_end = data + file->GetSize();
+
+  // Split into chunks that start and end on line boundaries
+  std::vector<std::pair<const char*, const char*>> ranges;
+  for (const char* begin = data; begin < data_end;) {
+    const char* end = begin + std::min<size_t>(kChunkSize, data_end - begin);
+    while (end < data_end && end[-1] != '\n') end++;
+    ranges.push_back(std::make_pair(begin, end));
+    begin = end;
+  }
+
+  if (thread_count == 0) thread_count = std::thread::hardware_concurrency();
+  thread_count = std::max(1u, std::min<uint>(thread_count, static_cast<uint>(ranges.size())));
+
+  // Runs a task for every chunk on a pool of threads pulling from a shared
+  // counter
+  auto run = [thread_count, &ranges](auto&& task) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+      for (size_t i = next++; i < ranges.size(); i = next++) task(i);
+    };
+
+    std::vector<std::thread> threads;
+    for (uint i = 1; i < thread_count; i++) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+  };
+
+  std::vector<Chunk> chunks(ranges.size());
+  run([&](size_t i) { ParseChunk(ranges[i].first, ranges[i].second, chunks[i]); });
+
+  // Prefix sums give every chunk its place in the merged model
+  std::vector<ObjCorner> offsets(chunks.size());
+  std::vector<size_t> corner_offsets(chunks.size());
+  ObjCorner total = {0, 0, 0};
+  size_t corner_total = 0;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (chunks[i].failed) return false;
+
+    offsets[i] = total;
+    corner_offsets[i] = corner_total;
+    total.v += static_cast<int>(chunks[i].positions.size());
+    total.t += static_cast<int>(chunks[i].texcoords.size());
+    total.n += static_cast<int>(chunks[i].normals.size());
+    corner_total += chunks[i].corners.size();
+  }
+
+  model.positions.resize(total.v);
+  model.texcoords.resize(total.t);
+  model.normals.resize(total.n);
+  model.corners.resize(corner_total);
+
+  std::atomic<bool> valid(true);
+  run([&](size_t i) {
+    if (!MergeChunk(chunks[i], offsets[i], corner_offsets[i], model))
+      valid = false;
+    chunks[i] = Chunk();
+  });
+
+  if (!valid) model = ObjModel();
+
+  return valid;
+}
+
+void ObjParser::ParseChunk(const char* begin, const char* end, Chunk& chunk) {
+  chunk.failed = true;
+
+  for (const char* line = begin; line < end;) {
+    const char* line_end =
+        static_cast<const char*>(memchr(line, '\n', end - line));
+    if (!line_end) line_end = end;
+
+    const char* p = SkipBlank(line, line_end);
+    if (line_end - p >= 2) {
+      if (p[0] == 'v' && IsBlank(p[1])) {
+        vec3f position;
+        p = ParseFloat(p + 2, line_end, position.x);
+        if (p) p = ParseFloat(p, line_end, position.y);
+        if (p) p = ParseFloat(p, line_end, position.z);
+        if (!p) return;
+        chunk.positions.push_back(position);
+      } else if (p[0] == 'v' && p[1] == 't') {
+        vec2f texcoord;
+        p = ParseFloat(p + 2, line_end, texcoord.x);
+        if (p) p = ParseFloat(p, line_end, texcoord.y);
+        if (!p) return;
+        chunk.texcoords.push_back(texcoord);
+      } else if (p[0] == 'v' && p[1] == 'n') {
+        vec3f normal;
+        p = ParseFloat(p + 2, line_end, normal.x);
+        if (p) p = ParseFloat(p, line_end, normal.y);
+        if (p) p = ParseFloat(p, line_end, normal.z);
+        if (!p) return;
+        chunk.normals.push_back(normal);
+      } else if (p[0] == 'f' && IsBlank(p[1])) {
+        if (!ParseFace(p + 2, line_end, chunk)) return;
+      }
+    }
+
+    line = line_end + 1;
+  }
+
+  chunk.failed = false;
+}
+
+bool ObjParser::ParseFace(const char* begin, const char* end, Chunk& chunk) {
+  const int sizes[3] = {static_cast<int>(chunk.positions.size()),
+                        static_cast<int>(chunk.texcoords.size()),
+                        static_cast<int>(chunk.normals.size())};
+
+  chunk.polygon.clear();
+  for (const char* p = SkipBlank(begin, end); p < end; p = SkipBlank(p, end)) {
+    ObjCorner corner = {-1, -1, -1};
+    int* components[3] = {&corner.v, &corner.t, &corner.n};
+    uint relative = 0;
+
+    // v, v/t, v//n or v/t/n
+    for (int i = 0; i < 3; i++) {
+      if (i > 0) {
+        if (p == end || *p != '/') break;
+        p++;
+        if (i == 1 && p < end && *p == '/') continue;
+      }
+
+      int index;
+      p = ParseInt(p, end, index);
+      if (!p || index == 0) return false;
+
+      // Relative indices count back from the last element read so far,
+      // which is only known in chunk-local terms until the merge
+      if (index < 0) relative |= 1 << i;
+      *components[i] = index < 0 ? sizes[i] + index : index - 1;
+    }
+
+    if (p < end && !IsBlank(*p)) return false;
+
+    chunk.polygon.push_back(std::make_pair(corner, relative));
+  }
+
+  if (chunk.polygon.size() < 3) return false;
+
+  // Polygons are triangulated as fans around the first corner
+  for (size_t i = 2; i < chunk.polygon.size(); i++) {
+    for (size_t corner : {size_t(0), i - 1, i}) {
+      uint base = static_cast<uint>(chunk.corners.size()) * 3;
+      uint relative = chunk.polygon[corner].second;
+      for (uint j = 0; j < 3; j++)
+        if (relative & (1 << j)) chunk.relative.push_back(base + j);
+      chunk.corners.push_back(chunk.polygon[corner].first);
+    }
+  }
+
+  return true;
+}
+
+bool ObjParser::MergeChunk(const Chunk& chunk, const ObjCorner& offset,
+                           size_t corner_offset, ObjModel& model) {
+  CopyTo(model.positions, chunk.positions, offset.v);
+  CopyTo(model.texcoords, chunk.texcoords, offset.t);
+  CopyTo(model.normals, chunk.normals, offset.n);
+
+  ObjCorner* corners = model.corners.data() + corner_offset;
+  std::copy(chunk.corners.begin(), chunk.corners.end(), corners);
+
+  // Relative indices become absolute once the chunk offset is known
+  const int offsets[3] = {offset.v, offset.t, offset.n};
+  for (uint relative : chunk.relative) {
+    int& index = GetComponent(corners[relative / 3], relative % 3);
+    index += offsets[relative % 3];
+    if (index < 0) return false;
+  }
+
+  const int sizes[3] = {static_cast<int>(model.positions.size()),
+                        static_cast<int>(model.texcoords.size()),
+                        static_cast<int>(model.normals.size())};
+  for (size_t i = 0; i < chunk.corners.size(); i++) {
+    const ObjCorner& corner = corners[i];
+    if (corner.v < 0 || corner.v >= sizes[0] || corner.t >= sizes[1] ||
+        corner.n >= sizes[2]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+}  // namespace voodoo
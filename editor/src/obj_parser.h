@@ -0,0 +1,69 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_OBJ_PARSER_H_
+#define VOODOO_OBJ_PARSER_H_
+
+#include <voodoo/math.h>
+
+namespace voodoo {
+// Indices are zero-based and already resolved, missing attributes are -1
+struct ObjCorner {
+  int v, t, n;
+};
+
+struct ObjModel {
+  std::vector<vec3f> positions;
+  std::vector<vec2f> texcoords;
+  std::vector<vec3f> normals;
+  // Three corners per triangle in file winding order, polygons are
+  // triangulated as fans
+  std::vector<ObjCorner> corners;
+};
+
+// Single pass Wavefront OBJ parser. The file is memory-mapped and split
+// into line-aligned chunks which are parsed in parallel, then merged with
+// global offsets applied to relative (negative) indices.
+class ObjParser final {
+ public:
+  // Zero thread count uses every hardware thread
+  static bool Parse(const std::string& filename, ObjModel& model, uint thread_count = 0);
+
+ private:
+  struct Chunk {
+    std::vector<vec3f> positions;
+    std::vector<vec2f> texcoords;
+    std::vector<vec3f> normals;
+    std::vector<ObjCorner> corners;
+
+    // Corner components holding chunk-local positions of relative
+    // indices, encoded as corner * 3 + component
+    std::vector<uint> relative;
+
+    // Scratch space for the corners of the face being parsed, with a mask
+    // of relative components
+    std::vector<std::pair<ObjCorner, uint>> polygon;
+
+    bool failed;
+  };
+
+  static void ParseChunk(const char* begin, const char* end, Chunk& chunk);
+  static bool ParseFace(const char* begin, const char* end, Chunk& chunk);
+  static bool MergeChunk(const Chunk& chunk, const ObjCorner& offset,
+                         size_t corner_offset, ObjModel& model);
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_OBJ_PARSER_H_
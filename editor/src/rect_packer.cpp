@@ -0,0 +1,119 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "rect_packer.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace voodoo {
+namespace {
+bool Intersects(const PackedRect& a, const PackedRect& b) {
+  return a.x < b.x + b.width && b.x < a.x + a.width &&
+         a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+bool Contains(const PackedRect& outer, const PackedRect& inner) {
+  return inner.x >= outer.x && inner.y >= outer.y &&
+         inner.x + inner.width <= outer.x + outer.width &&
+         inner.y + inner.height <= outer.y + outer.height;
+}
+}  // namespace
+
+RectPacker::RectPacker(int width, int height)
+    : width_(width), height_(height), used_area_(0) {
+  free_rects_.push_back({0, 0, width, height});
+}
+
+bool RectPacker::Insert(int width, int height, PackedRect& rect) {
+  // Best short side fit, ties broken by the long side
+  int best_short = INT_MAX, best_long = INT_MAX;
+  for (const auto& free : free_rects_) {
+    if (width > free.width || height > free.height) continue;
+
+    int leftover_x = free.width - width;
+    int leftover_y = free.height - height;
+    int short_side = std::min(leftover_x, leftover_y);
+    int long_side = std::max(leftover_x, leftover_y);
+    if (short_side < best_short ||
+        (short_side == best_short && long_side < best_long)) {
+      rect = {free.x, free.y, width, height};
+      best_short = short_side;
+      best_long = long_side;
+    }
+  }
+
+  if (best_short == INT_MAX) return false;
+
+  SplitFreeRects(rect);
+  PruneFreeRects();
+  used_area_ += ullong(width) * height;
+
+  return true;
+}
+
+double RectPacker::GetOccupancy() const {
+  return static_cast<double>(used_area_) / (double(width_) * height_);
+}
+
+void RectPacker::SplitFreeRects(const PackedRect& used) {
+  // Every free rectangle overlapping the used one is replaced by up to
+  // four maximal rectangles around it
+  std::vector<PackedRect> split;
+  for (size_t i = 0; i < free_rects_.size();) {
+    PackedRect free = free_rects_[i];
+    if (!Intersects(free, used)) {
+      i++;
+      continue;
+    }
+
+    if (used.x > free.x)
+      split.push_back({free.x, free.y, used.x - free.x, free.height});
+    if (used.x + used.width < free.x + free.width) {
+      int x = used.x + used.width;
+      split.push_back({x, free.y, free.x + free.width - x, free.height});
+    }
+    if (used.y > free.y)
+      split.push_back({free.x, free.y, free.width, used.y - free.y});
+    if (used.y + used.height < free.y + free.height) {
+      int y = used.y + used.height;
+      split.push_back({free.x, y, free.width, free.y + free.height - y});
+    }
+
+    free_rects_[i] = free_rects_.back();
+    free_rects_.pop_back();
+  }
+
+  free_rects_.insert(free_rects_.end(), split.begin(), split.end());
+}
+
+void RectPacker::PruneFreeRects() {
+  // Rectangles inside others add nothing, of equal ones a single one is
+  // kept
+  std::vector<bool> removed(free_rects_.size(), false);
+  for (size_t i = 0; i < free_rects_.size(); i++) {
+    for (size_t j = 0; j < free_rects_.size() && !removed[i]; j++) {
+      if (i == j || removed[j]) continue;
+      if (Contains(free_rects_[j], free_rects_[i])) removed[i] = true;
+    }
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < free_rects_.size(); i++) {
+    if (!removed[i]) free_rects_[count++] = free_rects_[i];
+  }
+  free_rects_.resize(count);
+}
+}  // namespace voodoo
@@ -0,0 +1,51 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_RECT_PACKER_H_
+#define VOODOO_RECT_PACKER_H_
+
+#include <voodoo/std_mappings.h>
+
+namespace voodoo {
+struct PackedRect {
+  int x, y, width, height;
+};
+
+// MaxRects bin packer. Keeps every maximal free rectangle of the bin and
+// places each new rectangle where it leaves the shortest leftover side,
+// which packs tightly when larger rectangles are inserted first.
+// Rectangles are never rotated, as that would rotate the texels.
+class RectPacker final {
+ public:
+  RectPacker(int width, int height);
+
+  // False when the rectangle no longer fits
+  bool Insert(int width, int height, PackedRect& rect);
+
+  // Fraction of the bin covered by inserted rectangles
+  double GetOccupancy() const;
+
+ private:
+  void SplitFreeRects(const PackedRect& used);
+  void PruneFreeRects();
+
+ private:
+  int width_, height_;
+  ullong used_area_;
+  std::vector<PackedRect> free_rects_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_RECT_PACKER_H_
@@ -0,0 +1,108 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "self_test.h"
+
+#include <voodoo/asset_manager.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace voodoo {
+namespace {
+const size_t kBlobSize = 1000;
+
+// Files loaded as their bytes, each accounted at its size
+class BlobManager : public AssetManager<vector<byte>> {
+ private:
+  virtual sptr<vector<byte>> Load(const string& filename,
+                                  sptr<FileData> file) override {
+    return std::make_shared<vector<byte>>(file->GetData(),
+                                          file->GetData() + file->GetSize());
+  }
+
+  virtual size_t GetAssetSize(const vector<byte>& blob) const override {
+    return blob.size();
+  }
+};
+}  // namespace
+
+SelfTest::SelfTest() : check_count_(0), failure_count_(0) {}
+
+bool SelfTest::Run() {
+  check_count_ = failure_count_ = 0;
+  CheckAssetBudget();
+
+  return failure_count_ == 0;
+}
+
+uint SelfTest::GetCheckCount() const { return check_count_; }
+
+uint SelfTest::GetFailureCount() const { return failure_count_; }
+
+void SelfTest::CheckAssetBudget() {
+  namespace fs = std::filesystem;
+  fs::path directory = fs::temp_directory_path() / "voodoo_self_test";
+  fs::create_directories(directory);
+
+  vector<string> files;
+  for (int i = 0; i < 8; i++) {
+    files.push_back((directory / ("blob_" + std::to_string(i))).string());
+    std::ofstream fout(files.back(), std::ios::out | std::ios::binary);
+    fout << string(kBlobSize, char('a' + i));
+  }
+
+  // Room for three blobs, six are loaded and held
+  BlobManager manager;
+  manager.SetBudget(kBlobSize * 3);
+  vector<sptr<vector<byte>>> held;
+  for (int i = 0; i < 6; i++) held.push_back(manager.Retrieve(files[i]));
+
+  bool same = true;
+  for (int i = 0; i < 6; i++)
+    same = same && manager.Retrieve(files[i]) == held[i];
+  Check(same, "held assets stay cached beyond the budget");
+  Check(manager.GetStats().evictions == 0, "held assets are not evicted");
+  Check(manager.GetStats().misses == 6, "held assets are loaded once");
+
+  // A future that was not taken yet holds its asset too
+  AssetFuture<vector<byte>> future = manager.RetrieveAsync(files[6]);
+  future.wait();
+  held.push_back(manager.Retrieve(files[7]));
+  Check(manager.Retrieve(files[6]) == future.get(),
+        "assets of pending futures stay cached");
+  Check(manager.GetStats().misses == 8, "assets of futures are loaded once");
+
+  // Released assets are evicted down to the budget
+  held.clear();
+  future = AssetFuture<vector<byte>>();
+  manager.Trim();
+  AssetCacheStats stats = manager.GetStats();
+  Check(stats.resident_bytes <= stats.budget,
+        "released assets are evicted down to the budget");
+
+  std::error_code error;
+  fs::remove_all(directory, error);
+}
+
+void SelfTest::Check(bool condition, const char* description) {
+  check_count_++;
+  if (condition) return;
+
+  failure_count_++;
+  std::cerr << "Failed: " << description << std::endl;
+}
+}  // namespace voodoo
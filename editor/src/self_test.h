@@ -0,0 +1,46 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_SELF_TEST_H_
+#define VOODOO_SELF_TEST_H_
+
+#include <voodoo/std_mappings.h>
+
+namespace voodoo {
+// Checks of engine behavior that regressions would break without any
+// visible error, run by "editor --test". Failures are written to the
+// error stream.
+class SelfTest final {
+ public:
+  SelfTest();
+
+  bool Run();
+
+  uint GetCheckCount() const;
+  uint GetFailureCount() const;
+
+ private:
+  // Loads beyond the memory budget while every older asset is held must
+  // neither evict nor load a second copy of any of them
+  void CheckAssetBudget();
+
+  void Check(bool condition, const char* description);
+
+ private:
+  uint check_count_, failure_count_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_SELF_TEST_H_
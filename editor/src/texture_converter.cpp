@@ -0,0 +1,197 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "texture_converter.h"
+
+#include <voodoo/mapped_file.h>
+#include <voodoo/mip_generator.h>
+#include <voodoo/vtex.h>
+
+#include "stb_image.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace voodoo {
+namespace {
+bool IsFont(const std::string& filename) {
+  for (const auto& part : fs::path(filename)) {
+    if (part == "fonts") return true;
+  }
+  return false;
+}
+}  // namespace
+
+TextureConverter::TextureConverter(BlockQuality quality) : quality_(quality) {
+  stats_ = {kImageFormatRgba8, 0, 0, 0, 0.0, 0.0};
+}
+
+bool TextureConverter::Cook(const std::string& filename) {
+  stats_ = {kImageFormatRgba8, 0, 0, 0, 0.0, 0.0};
+
+  sptr<Image> image = Load(filename);
+  if (!image) return false;
+
+  // Fonts are addressed in texels, so padding them to whole blocks keeps
+  // every glyph in place
+  if (IsFont(filename) && (image->width % 4 != 0 || image->height % 4 != 0)) {
+    int width = (image->width + 3) / 4 * 4;
+    int height = (image->height + 3) / 4 * 4;
+    byte* padded = new byte[size_t(width) * height * 4]();
+    for (int y = 0; y < image->height; y++) {
+      memcpy(padded + size_t(y) * width * 4,
+             image->data + size_t(y) * image->width * 4,
+             size_t(image->width) * 4);
+    }
+
+    delete[] image->data;
+    image->data = padded;
+    image->width = width;
+    image->height = height;
+  }
+
+  return Encode(*image, IsFont(filename), 0, GetOutputs(filename)[0]);
+}
+
+bool TextureConverter::Cook(Image& image, uint level_count,
+                            const std::string& output) {
+  stats_ = {kImageFormatRgba8, 0, 0, 0, 0.0, 0.0};
+  return Encode(image, false, level_count, output);
+}
+
+sptr<Image> TextureConverter::Load(const std::string& filename) {
+  // The image owns its texels, so stb's buffer is copied
+  sptr<Image> image;
+  try {
+    MappedFile file(filename);
+    int width, height, channels;
+    byte* texels = stbi_load_from_memory(file.GetData(),
+                                         static_cast<int>(file.GetSize()),
+                                         &width, &height, &channels, 4);
+    if (!texels) {
+      std::cerr << "Failed to read image file: " << filename << std::endl;
+      return nullptr;
+    }
+
+    size_t size = size_t(width) * height * 4;
+    image = std::make_shared<Image>(width, height, channels, new byte[size]);
+    memcpy(image->data, texels, size);
+    stbi_image_free(texels);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return nullptr;
+  }
+
+  return image;
+}
+
+const TextureCookStats& TextureConverter::GetStats() const { return stats_; }
+
+std::vector<std::string> TextureConverter::GetOutputs(
+    const std::string& filename) {
+  std::string name = filename.substr(0, filename.find_last_of('.'));
+  return {name + ".vtex"};
+}
+
+bool TextureConverter::Encode(Image& image, bool font, uint level_count,
+                              const std::string& output) {
+  using namespace std::chrono;
+  ImageFormat format = ChooseFormat(font, image);
+
+  MipOptions mip_options;
+  if (font) {
+    mip_options.srgb = false;
+    mip_options.coverage_channel = 0;
+  }
+  MipGenerator::Generate(image, mip_options);
+  if (level_count > 0 && image.mips.size() >= level_count)
+    image.mips.resize(level_count - 1);
+
+  size_t level_size = GetImageLevelSize(kImageFormatRgba8, image.width,
+                                        image.height);
+  std::vector<byte> reference(image.data, image.data + level_size);
+
+  stats_.format = format;
+  stats_.pixels = ullong(image.width) * image.height;
+  stats_.source_bytes = level_size;
+  for (const auto& level : image.mips) {
+    stats_.pixels += ullong(level.width) * level.height;
+    stats_.source_bytes += level.data.size();
+  }
+
+  if (IsBlockCompressed(format)) {
+    auto start = high_resolution_clock::now();
+
+    std::vector<byte> blocks;
+    BlockEncoder::Encode(format, quality_, image.data, image.width,
+                         image.height, blocks);
+    delete[] image.data;
+    image.data = new byte[blocks.size()];
+    memcpy(image.data, blocks.data(), blocks.size());
+
+    for (auto& level : image.mips) {
+      BlockEncoder::Encode(format, quality_, level.data.data(), level.width,
+                           level.height, blocks);
+      level.data.swap(blocks);
+    }
+    image.format = format;
+
+    duration<double, std::milli> elapsed = high_resolution_clock::now() - start;
+    stats_.encode_time = elapsed.count();
+
+    std::vector<byte> decoded;
+    BlockEncoder::Decode(format, image.data, image.width, image.height,
+                         decoded);
+    stats_.psnr = BlockEncoder::GetPsnr(format, reference.data(),
+                                        decoded.data(), image.width,
+                                        image.height);
+  } else {
+    stats_.psnr = BlockEncoder::GetPsnr(format, reference.data(),
+                                        image.data, image.width,
+                                        image.height);
+  }
+
+  stats_.cooked_bytes = GetImageLevelSize(format, image.width, image.height);
+  for (const auto& level : image.mips)
+    stats_.cooked_bytes += level.data.size();
+
+  if (!VTex::Save(image, output)) {
+    std::cerr << "Failed to write texture: " << output << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+ImageFormat TextureConverter::ChooseFormat(bool font,
+                                           const Image& image) const {
+  // Top level blocks must be whole
+  if (image.width % 4 != 0 || image.height % 4 != 0) return kImageFormatRgba8;
+
+  if (image.channels == 1 || font) return kImageFormatBc4;
+
+  bool opaque = true;
+  size_t count = size_t(image.width) * image.height;
+  for (size_t i = 0; i < count && opaque; i++)
+    opaque = image.data[i * 4 + 3] == 255;
+
+  if (quality_ == kBlockQualityHigh) return kImageFormatBc7;
+  return opaque ? kImageFormatBc1 : kImageFormatBc3;
+}
+}  // namespace voodoo
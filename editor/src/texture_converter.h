@@ -0,0 +1,71 @@
+// This file is part of Voodoo Engine.
+//
+// Voodoo Engine is free software : you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Voodoo Engine is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef VOODOO_TEXTURE_CONVERTER_H_
+#define VOODOO_TEXTURE_CONVERTER_H_
+
+#include "block_encoder.h"
+
+namespace voodoo {
+struct TextureCookStats {
+  ImageFormat format;
+
+  // Texels of every mip level
+  ullong pixels;
+
+  // Every mip level as RGBA8 and in the cooked format
+  size_t source_bytes, cooked_bytes;
+
+  double encode_time;
+
+  // Of the full resolution level
+  double psnr;
+};
+
+// Cooks images into .vtex files with a mip chain in a block compressed
+// format. Fonts and single channel images become BC4, images with alpha
+// BC3 and others BC1. The high quality preset uses BC7 instead of BC1 and
+// BC3. Images other than fonts whose size is not a multiple of the block
+// size stay RGBA8.
+class TextureConverter final {
+ public:
+  explicit TextureConverter(BlockQuality quality = kBlockQualityNormal);
+
+  bool Cook(const std::string& filename);
+
+  // Cooks an RGBA8 image already in memory, such as an atlas page. Mip
+  // levels past level_count are dropped, zero keeps the whole chain.
+  bool Cook(Image& image, uint level_count, const std::string& output);
+
+  const TextureCookStats& GetStats() const;
+
+  // Reads any image stb_image supports as RGBA8, null on failure
+  static sptr<Image> Load(const std::string& filename);
+
+  // Files written for a source image
+  static std::vector<std::string> GetOutputs(const std::string& filename);
+
+ private:
+  bool Encode(Image& image, bool font, uint level_count,
+              const std::string& output);
+  ImageFormat ChooseFormat(bool font, const Image& image) const;
+
+ private:
+  BlockQuality quality_;
+  TextureCookStats stats_;
+};
+}  // namespace voodoo
+
+#endif  // VOODOO_TEXTURE_CONVERTER_H_
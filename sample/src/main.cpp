@@ -13,9 +13,15 @@
 // You should have received a copy of the GNU General Public License
 // along with Voodoo Engine.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <voodoo/behavior_stats.h>
 #include <voodoo/engine.h>
 #include <voodoo/image_manager.h>
+#include <voodoo/logger.h>
+#include <voodoo/memory_tracker.h>
 #include <voodoo/mesh_manager.h>
+#include <voodoo/profiler.h>
+#include <voodoo/texture_atlas.h>
+#include <voodoo/vertex_packer.h>
 
 // Components
 #include <voodoo/camera.h>
@@ -26,11 +32,36 @@
 
 #include "rotatable.h"
 
+#include <filesystem>
+
 std::shared_ptr<voodoo::Scene> CreateScene(voodoo::Engine engine) {
   using namespace std;
   using namespace voodoo;
   auto scene = std::make_shared<Scene>();
 
+  // The cooked font atlas is BC4 compressed with its mips, the source one
+  // is used until the editor has cooked the assets
+  string font_path = "../assets/textures/fonts/consolas.vtex";
+  if (!std::filesystem::exists(font_path))
+    font_path = "../assets/textures/fonts/consolas.png";
+
+  // The font is alpha tested on its red channel, its glyphs must not thin
+  // out in the smaller mips. Its alpha is always opaque, so the gray level
+  // alone is kept.
+  ImageOptions font_options;
+  font_options.channels = 1;
+  font_options.mips.srgb = false;
+  font_options.mips.coverage_channel = 0;
+  font_options.mips.coverage_cutoff = 0.5f;
+  ImageManager::Get().SetImageOptions(font_path, font_options);
+
+  // Start loading in the background, Retrieve() below waits for the loads
+  // in flight instead of reading the files again
+  MeshManager::Get().RetrieveAsync("../assets/meshes/cube.mesh");
+  MeshManager::Get().RetrieveAsync("../assets/meshes/mario.mesh");
+  ImageManager::Get().RetrieveAsync("../assets/textures/checker.jpg");
+  ImageManager::Get().RetrieveAsync(font_path);
+
   auto default_shader = make_shared<Shader>(
       engine.GetGraphicsAPI()->GetDevice(),
       engine.GetGraphicsAPI()->GetDeviceContext());
@@ -39,6 +70,15 @@ std::shared_ptr<voodoo::Scene> CreateScene(voodoo::Engine engine) {
       "../assets/shaders/default_ps.cso",
       true);
 
+  auto packed_shader = make_shared<Shader>(
+      engine.GetGraphicsAPI()->GetDevice(),
+      engine.GetGraphicsAPI()->GetDeviceContext());
+  packed_shader->Init(
+      "../assets/shaders/default_packed_vs.cso",
+      "../assets/shaders/default_ps.cso",
+      true,
+      kVertexFormatPtnPacked);
+
   // Camera
   auto camera = scene->AddGameObject("Camera");
   camera->AddComponent<Camera>();
@@ -46,19 +86,49 @@ std::shared_ptr<voodoo::Scene> CreateScene(voodoo::Engine engine) {
   camera->GetTransform()->SetRotationByDegrees(45, 225, 0);
   scene->SetCamera(camera->GetComponent<Camera>());
 
-  // Cube
-  auto cube = scene->AddGameObject("Cube");
-  cube->AddComponent<Renderer>();
+  // Cubes. Once the editor has packed their textures into the props atlas,
+  // they are drawn with meshes remapped to its page and their materials
+  // share a single texture bind.
+  string props_path = "../assets/textures/props.vatlas";
+  sptr<TextureAtlas> props;
+  vector<sptr<Texture>> props_pages;
+  if (std::filesystem::exists(props_path)) {
+    props = TextureAtlas::Load(props_path);
+    for (uint i = 0; i < props->pages.size(); i++) {
+      props_pages.push_back(make_shared<Texture>(
+          engine.GetGraphicsAPI()->GetDevice(),
+          ImageManager::Get().Retrieve(props->GetPagePath(props_path, i))));
+    }
+  }
 
-  auto cube_mesh_filter = cube->AddComponent<MeshFilter>();
-  auto cube_mesh = MeshManager::Get().Retrieve("../assets/meshes/cube.mesh");
-  cube_mesh_filter->SetMesh(cube_mesh);
-  auto cube_texture = make_shared<Texture>(
-      engine.GetGraphicsAPI()->GetDevice(),
-      ImageManager::Get().Retrieve("../assets/textures/placeholder_blue.jpg"));
-  auto cube_material = make_shared<Material>(default_shader, cube_texture);
-  cube_mesh_filter->SetMaterial(cube_material);
-  cube->GetTransform()->SetPosition(-1, 0, 0);
+  auto add_cube = [&](const string& name, const string& texture,
+                      float x, float z) {
+    auto cube = scene->AddGameObject(name);
+    cube->AddComponent<Renderer>();
+
+    auto cube_mesh_filter = cube->AddComponent<MeshFilter>();
+    sptr<Mesh> cube_mesh;
+    sptr<Texture> cube_texture;
+    const AtlasRegion* region = props ? props->Find(texture) : nullptr;
+    if (region) {
+      string stem = texture.substr(0, texture.find_last_of('.'));
+      cube_mesh = MeshManager::Get().Retrieve("../assets/meshes/cube_" +
+                                              stem + ".vmesh");
+      cube_texture = props_pages[region->page];
+    } else {
+      cube_mesh = MeshManager::Get().Retrieve("../assets/meshes/cube.mesh");
+      cube_texture = make_shared<Texture>(
+          engine.GetGraphicsAPI()->GetDevice(),
+          ImageManager::Get().Retrieve("../assets/textures/" + texture));
+    }
+    cube_mesh_filter->SetMesh(cube_mesh);
+    auto cube_material = make_shared<Material>(default_shader, cube_texture);
+    cube_mesh_filter->SetMaterial(cube_material);
+    cube->GetTransform()->SetPosition(x, 0, z);
+  };
+  add_cube("Cube", "placeholder_blue.jpg", -1, 0);
+  add_cube("Red Cube", "placeholder_red.jpg", -1, -1.5f);
+  add_cube("Green Cube", "placeholder_green.jpg", -2.5f, 0);
 
   // Mario
   auto mario = scene->AddGameObject("Mario");
@@ -67,11 +137,26 @@ std::shared_ptr<voodoo::Scene> CreateScene(voodoo::Engine engine) {
 
   auto mario_mesh_filter = mario->AddComponent<MeshFilter>();
   auto mario_mesh = MeshManager::Get().Retrieve("../assets/meshes/mario.mesh");
+  VertexPacker::Pack(*mario_mesh);
   mario_mesh_filter->SetMesh(mario_mesh);
-  auto mario_texture = make_shared<Texture>(
-      engine.GetGraphicsAPI()->GetDevice(),
-      ImageManager::Get().Retrieve("../assets/textures/checker.jpg"));
-  auto mario_material = make_shared<Material>(default_shader, mario_texture);
+
+  // The cooked texture streams its mips in as Mario comes closer
+  sptr<Texture> mario_texture;
+  string checker_path = "../assets/textures/checker.vtex";
+  if (std::filesystem::exists(checker_path)) {
+    mario_texture = engine.GetTextureStreamer()->Load(checker_path);
+  } else {
+    mario_texture = make_shared<Texture>(
+        engine.GetGraphicsAPI()->GetDevice(),
+        ImageManager::Get().Retrieve("../assets/textures/checker.jpg"));
+  }
+  auto mario_material = make_shared<Material>(packed_shader, mario_texture);
+
+  // Hot reloaded meshes come back unpacked
+  engine.GetHotReload()->AddListener([mario_mesh](const string& filename) {
+    if (filename == "../assets/meshes/mario.mesh")
+      VertexPacker::Pack(*mario_mesh);
+  });
   mario_mesh_filter->SetMaterial(mario_material);
   mario->GetTransform()->SetPosition(1, 0, 0);
 
@@ -81,7 +166,11 @@ std::shared_ptr<voodoo::Scene> CreateScene(voodoo::Engine engine) {
 
   auto text_text = text->AddComponent<Text>();
   text_text->SetText("Voodoo");
-  text_text->SetFont(make_shared<Font>());
+
+  auto font = make_shared<Font>();
+  auto font_image = ImageManager::Get().Retrieve(font_path);
+  font->SetAtlasSize(float(font_image->width), float(font_image->height));
+  text_text->SetFont(font);
 
   auto text_shader = make_shared<Shader>(
       engine.GetGraphicsAPI()->GetDevice(),
@@ -90,14 +179,26 @@ std::shared_ptr<voodoo::Scene> CreateScene(voodoo::Engine engine) {
       "../assets/shaders/font_vs.cso",
       "../assets/shaders/font_ps.cso",
       false);
-  auto text_texture = make_shared<Texture>(
-      engine.GetGraphicsAPI()->GetDevice(),
-      ImageManager::Get().Retrieve("../assets/textures/fonts/consolas.png"));
+  auto text_texture =
+      make_shared<Texture>(engine.GetGraphicsAPI()->GetDevice(), font_image);
   auto text_material = make_shared<Material>(text_shader, text_texture);
   text_text->SetMaterial(text_material);
   text->GetTransform()->SetPosition(1.0f, 0, 1.0f);
   text->GetTransform()->SetScale(0.01f);
 
+  MipStats mips = MipGenerator::GetStats();
+  double mpix = mips.pixels / 1e6;
+  double rate = mips.time > 0.0 ? mpix / (mips.time / 1e3) : 0.0;
+  VOODOO_LOG_INFO(kLogCategoryAssets,
+                  "Generated mips of {} images: {} MPix in {} ms ({} MPix/s)",
+                  mips.images, mpix, mips.time, rate);
+
+  ImageMemoryStats memory = ImageManager::Get().GetMemoryStats();
+  VOODOO_LOG_INFO(kLogCategoryAssets,
+                  "Decoded {} images into {} KB ({} KB as RGBA)",
+                  memory.images, memory.bytes / 1024,
+                  memory.rgba8_bytes / 1024);
+
   return scene;
 }
 
@@ -105,12 +206,22 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE prev_instance, LPSTR cmd_line,
   using namespace voodoo;
   int exit_code = 1;
 
+  // The trace covers startup and the first frames, later frames run
+  // without recording
+  Profiler::Get().BeginCapture(300);
+
   auto engine = Engine();
   if (engine.Init(instance, L"Sample")) {
+    engine.GetHotReload()->Watch("../assets");
     if (engine.LoadScene(CreateScene(engine))) {
       exit_code = engine.Run();
     }
   }
 
+  Profiler::Get().EndCapture("trace.json");
+  Profiler::Get().Dump();
+  BehaviorStats::Get().Dump();
+  MemoryTracker::Dump();
+
   return exit_code;
 }
\ No newline at end of file
@@ -28,7 +28,8 @@ float4 main(PixelInput input) : SV_TARGET {
 
   color = shader_texture.Sample(sample_type, input.tex);
 
-  if (color.r == 0.0f) {
+  // Mips keep the coverage of this cutoff
+  if (color.r < 0.5f) {
     color.a = 0.0f;
   } else {
     color.rgb = pixel_color.rgb;